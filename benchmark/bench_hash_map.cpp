@@ -0,0 +1,98 @@
+#include "benchmark/benchmark.h"
+#include "flat_hash_map.h"
+#include "unordered_map.h"
+#include "vector.h"
+#include <random>
+
+using namespace aria;
+
+namespace {
+
+// distinct random keys, the first half is inserted into the map and the second half is used for the misses
+vector<size_t> make_keys(size_t n) {
+  std::mt19937_64 gen(42);
+  flat_hash_map<size_t, int> seen;
+  vector<size_t> keys;
+  while (keys.size() < 2 * n) {
+    const size_t key = gen();
+    if (seen.try_emplace(key).second)
+      keys.push_back(key);
+  }
+  return keys;
+}
+
+template <class Map> Map make_map(const vector<size_t> &keys, size_t n) {
+  Map m;
+  for (size_t i = 0; i < n; i++)
+    m[keys[i]] = int(i);
+  return m;
+}
+
+template <class Map> void bench_find_hit(benchmark::State &state) {
+  const size_t n = state.range(0);
+  const auto keys = make_keys(n);
+  const auto m = make_map<Map>(keys, n);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(m.find(keys[i]));
+    if (++i == n)
+      i = 0;
+  }
+}
+
+template <class Map> void bench_find_miss(benchmark::State &state) {
+  const size_t n = state.range(0);
+  const auto keys = make_keys(n);
+  const auto m = make_map<Map>(keys, n);
+  size_t i = n;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(m.find(keys[i]));
+    if (++i == 2 * n)
+      i = n;
+  }
+}
+
+// fill the table right up to its maximum load factor, where the probe sequences are the longest
+template <class Map> void bench_find_high_load(benchmark::State &state) {
+  Map m;
+  m.reserve(state.range(0));
+  const auto n = size_t(m.bucket_count() * m.max_load_factor());
+  const auto keys = make_keys(n);
+  for (size_t i = 0; i < n; i++)
+    m[keys[i]] = int(i);
+  state.counters["load_factor"] = m.load_factor();
+  size_t i = 0;
+  for (auto _ : state) {
+    // alternate between a hit and a miss
+    benchmark::DoNotOptimize(m.find(keys[i]));
+    i = i < n ? i + n : i - n + 1;
+    if (i == n)
+      i = 0;
+  }
+}
+
+template <class Map> void bench_insert(benchmark::State &state) {
+  const size_t n = state.range(0);
+  const auto keys = make_keys(n);
+  for (auto _ : state) {
+    Map m;
+    for (size_t i = 0; i < n; i++)
+      m[keys[i]] = int(i);
+    benchmark::DoNotOptimize(m.size());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+using flat_map_t = flat_hash_map<size_t, int>;
+using node_map_t = unordered_map<size_t, int>;
+
+} // namespace
+
+BENCHMARK_TEMPLATE(bench_find_hit, flat_map_t)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+BENCHMARK_TEMPLATE(bench_find_hit, node_map_t)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+BENCHMARK_TEMPLATE(bench_find_miss, flat_map_t)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+BENCHMARK_TEMPLATE(bench_find_miss, node_map_t)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+BENCHMARK_TEMPLATE(bench_find_high_load, flat_map_t)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+BENCHMARK_TEMPLATE(bench_find_high_load, node_map_t)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+BENCHMARK_TEMPLATE(bench_insert, flat_map_t)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+BENCHMARK_TEMPLATE(bench_insert, node_map_t)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
\ No newline at end of file
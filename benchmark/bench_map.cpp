@@ -0,0 +1,102 @@
+#include "benchmark/benchmark.h"
+#include "btree_map.h"
+#include "map.h"
+#include "pool_allocator.h"
+#include "vector.h"
+#include <map>
+#include <random>
+
+using namespace aria;
+
+namespace {
+
+vector<int> sorted_keys(size_t n) {
+  vector<int> keys;
+  for (size_t i = 0; i < n; i++)
+    keys.push_back(int(i));
+  return keys;
+}
+
+vector<int> shuffled_keys(size_t n) {
+  auto keys = sorted_keys(n);
+  std::mt19937 gen(42);
+  for (size_t i = n; i > 1; i--)
+    aria::swap(keys[i - 1], keys[gen() % i]);
+  return keys;
+}
+
+// keys arrive in order with a few of them swapped, like timestamps
+vector<int> nearly_sorted_keys(size_t n) {
+  auto keys = sorted_keys(n);
+  std::mt19937 gen(42);
+  for (size_t i = 0; i + 8 < n; i += 16)
+    aria::swap(keys[i], keys[i + gen() % 8]);
+  return keys;
+}
+
+template <class Map, vector<int> (*MakeKeys)(size_t)> void bench_insert(benchmark::State &state) {
+  const auto keys = MakeKeys(state.range(0));
+  for (auto _ : state) {
+    Map m;
+    for (auto key : keys)
+      m.insert({key, key});
+    benchmark::DoNotOptimize(m.size());
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <class Map> void bench_find_after_sorted_insert(benchmark::State &state) {
+  const auto keys = sorted_keys(state.range(0));
+  const auto lookups = shuffled_keys(state.range(0));
+  Map m;
+  for (auto key : keys)
+    m.insert({key, key});
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(m.find(lookups[i]));
+    if (++i == lookups.size())
+      i = 0;
+  }
+}
+
+// sum of the values of a range of 1000 consecutive keys, starting at a random key
+template <class Map> void bench_range_scan(benchmark::State &state) {
+  const auto keys = shuffled_keys(state.range(0));
+  Map m;
+  for (auto key : keys)
+    m.insert({key, key});
+  size_t i = 0;
+  for (auto _ : state) {
+    long long sum = 0;
+    for (auto it = m.lower_bound(keys[i]), last = m.lower_bound(keys[i] + 1000); it != last; ++it)
+      sum += it->second;
+    benchmark::DoNotOptimize(sum);
+    if (++i == keys.size())
+      i = 0;
+  }
+}
+
+using aria_map_t = map<int, int>;
+using btree_map_t = btree_map<int, int>;
+using pool_map_t = map<int, int, less<int>, pool_allocator<pair<const int, int>>>;
+using std_map_t = std::map<int, int>;
+
+} // namespace
+
+BENCHMARK_TEMPLATE(bench_insert, aria_map_t, sorted_keys)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_insert, btree_map_t, sorted_keys)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_insert, std_map_t, sorted_keys)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_insert, aria_map_t, nearly_sorted_keys)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_insert, btree_map_t, nearly_sorted_keys)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_insert, std_map_t, nearly_sorted_keys)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_insert, aria_map_t, shuffled_keys)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_insert, btree_map_t, shuffled_keys)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_insert, std_map_t, shuffled_keys)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_insert, pool_map_t, shuffled_keys)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_find_after_sorted_insert, aria_map_t)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_find_after_sorted_insert, btree_map_t)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_find_after_sorted_insert, std_map_t)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_range_scan, aria_map_t)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_range_scan, pool_map_t)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_range_scan, btree_map_t)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(bench_range_scan, std_map_t)->RangeMultiplier(10)->Range(1000, 1000000);
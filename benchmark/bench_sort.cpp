@@ -0,0 +1,119 @@
+#include "algorithm.h"
+#include "benchmark/benchmark.h"
+#include "vector.h"
+#include <algorithm>
+#include <functional>
+#include <random>
+
+using namespace aria;
+
+namespace {
+
+enum distribution { random_values, sorted, reversed, sawtooth, few_unique };
+const char *distribution_names[] = {"random", "sorted", "reversed", "sawtooth", "few_unique"};
+
+vector<int> make_input(distribution d, size_t n) {
+  std::mt19937 gen(42);
+  vector<int> v;
+  for (size_t i = 0; i < n; i++) {
+    switch (d) {
+    case random_values:
+      v.push_back(int(gen()));
+      break;
+    case sorted:
+      v.push_back(int(i));
+      break;
+    case reversed:
+      v.push_back(int(n - i));
+      break;
+    case sawtooth:
+      v.push_back(int(i % 1000));
+      break;
+    case few_unique:
+      v.push_back(int(gen() % 4));
+      break;
+    }
+  }
+  return v;
+}
+
+struct aria_sort {
+  template <class It> void operator()(It first, It last) const { aria::sort(first, last); }
+};
+
+// greater<> keeps the branchless partitioning but is never dispatched to radix sort, so this is pdqsort at every size.
+// It sorts in descending order, so compare it with std_sort_greater, not std_sort.
+struct aria_pdqsort {
+  template <class It> void operator()(It first, It last) const { aria::sort(first, last, greater{}); }
+};
+
+struct aria_radix_sort {
+  template <class It> void operator()(It first, It last) const { aria::radix_sort(first, last); }
+};
+
+struct aria_stable_sort {
+  template <class It> void operator()(It first, It last) const { aria::stable_sort(first, last); }
+};
+
+struct std_sort {
+  template <class It> void operator()(It first, It last) const { std::sort(first, last); }
+};
+
+struct std_sort_greater {
+  template <class It> void operator()(It first, It last) const { std::sort(first, last, std::greater{}); }
+};
+
+// range(0) is the distribution and range(1) the size
+template <class Sort> void bench_sort(benchmark::State &state) {
+  const auto d = distribution(state.range(0));
+  const auto input = make_input(d, state.range(1));
+  state.SetLabel(distribution_names[d]);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto v = input;
+    state.ResumeTiming();
+    Sort()(v.begin(), v.end());
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+// selecting the smallest range(1) / 100 elements, or the median, against sorting everything
+enum selection { top_k, median, full_sort };
+const char *selection_names[] = {"partial_sort", "nth_element", "sort"};
+
+void bench_select(benchmark::State &state) {
+  const auto s = selection(state.range(0));
+  const auto input = make_input(random_values, state.range(1));
+  state.SetLabel(selection_names[s]);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto v = input;
+    state.ResumeTiming();
+    switch (s) {
+    case top_k:
+      aria::partial_sort(v.begin(), v.begin() + v.size() / 100, v.end());
+      break;
+    case median:
+      aria::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+      break;
+    case full_sort:
+      aria::sort(v.begin(), v.end());
+      break;
+    }
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(bench_sort, aria_sort)->ArgsProduct({{random_values, sorted, reversed, sawtooth, few_unique}, {1 << 10, 1 << 20}});
+BENCHMARK_TEMPLATE(bench_sort, aria_pdqsort)->ArgsProduct({{random_values, sorted, reversed, sawtooth, few_unique}, {1 << 10, 1 << 20}});
+BENCHMARK_TEMPLATE(bench_sort, aria_radix_sort)->ArgsProduct({{random_values, sorted, reversed, sawtooth, few_unique}, {1 << 10, 1 << 20}});
+BENCHMARK_TEMPLATE(bench_sort, aria_stable_sort)
+    ->ArgsProduct({{random_values, sorted, reversed, sawtooth, few_unique}, {1 << 10, 1 << 20}});
+BENCHMARK_TEMPLATE(bench_sort, std_sort)->ArgsProduct({{random_values, sorted, reversed, sawtooth, few_unique}, {1 << 10, 1 << 20}});
+BENCHMARK_TEMPLATE(bench_sort, std_sort_greater)
+    ->ArgsProduct({{random_values, sorted, reversed, sawtooth, few_unique}, {1 << 10, 1 << 20}});
+BENCHMARK(bench_select)->ArgsProduct({{top_k, median, full_sort}, {1 << 10, 1 << 20}});
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "benchmark/benchmark.h"
+#include "task_group.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+using namespace aria;
+
+namespace {
+
+// a few microseconds of work
+void spin(int n) {
+  for (int i = 0; i < n; i++)
+    benchmark::DoNotOptimize(i);
+}
+
+void wait_for(std::atomic<int> &pending) {
+  for (int p = pending; p != 0; p = pending)
+    pending.wait(p);
+}
+
+void finish(std::atomic<int> &pending) {
+  if (--pending == 0)
+    pending.notify_all();
+}
+
+// range(0) tasks submitted by the main thread, to the injection queue
+void bench_external_submit(benchmark::State &state) {
+  ThreadPool pool(state.range(1));
+  pool.start();
+  for (auto _ : state) {
+    std::atomic<int> pending = int(state.range(0));
+    for (int i = 0; i < state.range(0); i++)
+      pool.detach_task([&] {
+        spin(1000);
+        finish(pending);
+      });
+    wait_for(pending);
+  }
+  pool.stop();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// range(0) tasks submitted by one task, so they go to its worker's deque and the other workers steal them
+void bench_fan_out(benchmark::State &state) {
+  ThreadPool pool(state.range(1));
+  pool.start();
+  for (auto _ : state) {
+    std::atomic<int> pending = int(state.range(0));
+    pool.detach_task([&] {
+      for (int i = 0; i < state.range(0); i++)
+        pool.detach_task([&] {
+          spin(1000);
+          finish(pending);
+        });
+    });
+    wait_for(pending);
+  }
+  pool.stop();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// a loop of range(0) iterations split by parallel_for, against a future per chunk of 64 iterations
+void bench_parallel_for(benchmark::State &state) {
+  ThreadPool pool(state.range(1));
+  pool.start();
+  for (auto _ : state)
+    parallel_for(pool, 0, int(state.range(0)), 64, [](int b, int e) { spin((e - b) * 100); });
+  pool.stop();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void bench_future_per_chunk(benchmark::State &state) {
+  ThreadPool pool(state.range(1));
+  pool.start();
+  for (auto _ : state) {
+    std::vector<future<void>> futures;
+    for (int i = 0; i < state.range(0); i += 64)
+      futures.push_back(pool.submit_task([] { spin(64 * 100); }));
+    for (auto &f : futures)
+      f.get();
+  }
+  pool.stop();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// The time until a task submitted with priority range(1) starts, behind a burst of 1000 low priority background tasks.
+// The background tasks left are purged after each iteration
+void bench_priority_latency(benchmark::State &state) {
+  using clock_type = ThreadPool::clock_type;
+  ThreadPool pool(state.range(0));
+  pool.start();
+  for (auto _ : state) {
+    for (int i = 0; i < 1000; i++)
+      pool.detach_task([] { spin(10000); }, task_priority::low);
+    const auto submitted = clock_type::now();
+    const auto started = pool.submit_task([] { return clock_type::now(); }, task_priority(state.range(1))).get();
+    state.SetIterationTime(std::chrono::duration<double>(started - submitted).count());
+    pool.purge();
+  }
+  pool.stop();
+}
+
+} // namespace
+
+BENCHMARK(bench_external_submit)->ArgsProduct({{1 << 14}, {1, 4, 16}})->UseRealTime();
+BENCHMARK(bench_fan_out)->ArgsProduct({{1 << 14}, {1, 4, 16}})->UseRealTime();
+BENCHMARK(bench_parallel_for)->ArgsProduct({{1 << 16}, {1, 4, 16}})->UseRealTime();
+BENCHMARK(bench_future_per_chunk)->ArgsProduct({{1 << 16}, {1, 4, 16}})->UseRealTime();
+BENCHMARK(bench_priority_latency)->ArgsProduct({{1, 4}, {int(task_priority::high), int(task_priority::low)}})->UseManualTime();
@@ -1,9 +1,12 @@
 #pragma once
+#include "allocator.h"
+#include "bit.h"
 #include "functional.h"
 #include "iterator.h"
 #include "ranges.h"
 #include "utility.h"
 #include <cmath>
+#include <new> //nothrow
 
 // https://en.cppreference.com/w/cpp/algorithm
 namespace aria {
@@ -208,14 +211,52 @@ template <forward_iterator It1, forward_iterator It2> constexpr void iter_swap(I
   swap(*a, *b);
 }
 
-template <bidirectional_iterator It> void reverse(It first, It last) {
-  if (first == last)
-    return;
-  --last;
-  for (; first != last; ++first, --last)
+template <bidirectional_iterator It> constexpr void reverse(It first, It last) {
+  for (; first != last && first != --last; ++first)
     iter_swap(first, last);
 }
 
+// returns the new position of *first
+template <forward_iterator It> constexpr It rotate(It first, It middle, It last) {
+  if (first == middle)
+    return last;
+  if (middle == last)
+    return first;
+  It result = first;
+  for (bool first_pass = true; first != middle && middle != last; first_pass = false) {
+    // swap [middle, last) to the front, the rest is a rotation of [write, last) around next_read
+    It write = first, next_read = first;
+    for (It read = middle; read != last; ++write, ++read) {
+      if (write == next_read)
+        next_read = read;
+      iter_swap(write, read);
+    }
+    if (first_pass)
+      result = write;
+    first = write;
+    middle = next_read;
+  }
+  return result;
+}
+
+// reverse both parts, then reverse the whole range by swapping from both ends, and finish the longer part where they stop
+template <bidirectional_iterator It> constexpr It rotate(It first, It middle, It last) {
+  if (first == middle)
+    return last;
+  if (middle == last)
+    return first;
+  reverse(first, middle);
+  reverse(middle, last);
+  while (first != middle && middle != last)
+    iter_swap(first++, --last);
+  if (first == middle) {
+    reverse(middle, last);
+    return last;
+  }
+  reverse(first, middle);
+  return first;
+}
+
 //-----------------------Partitioning operations-----------------------
 // is_partitioned partition partition_point
 template <input_iterator It, class UnaryPred> bool is_partitioned(It first, It last, UnaryPred p) {
@@ -415,36 +456,711 @@ template <bidirectional_iterator It, class Compare> constexpr void insertion_sor
 
 template <bidirectional_iterator It> constexpr void insertion_sort(It first, It last) { return insertion_sort(first, last, less{}); }
 
+namespace _merge {
+// uninitialized memory for up to n elements, size() is 0 if it can't be allocated. The sorts fall back to their in-place variants then
+template <class T> class temporary_buffer {
+public:
+  explicit temporary_buffer(ptrdiff_t n) noexcept
+      : m_ptr(static_cast<T *>(::operator new(sizeof(T) * n, std::align_val_t(alignof(T)), std::nothrow))), m_size(m_ptr ? n : 0) {}
+  ~temporary_buffer() { ::operator delete(m_ptr, std::align_val_t(alignof(T))); }
+  temporary_buffer(const temporary_buffer &) = delete;
+  temporary_buffer &operator=(const temporary_buffer &) = delete;
+
+  T *data() const noexcept { return m_ptr; }
+  ptrdiff_t size() const noexcept { return m_size; }
+
+private:
+  T *m_ptr;
+  ptrdiff_t m_size;
+};
+} // namespace _merge
+
+// Radix sort: the keys are integers or floating points, which are sorted by their ordered bits (LSD, stable, with a buffer),
+// or strings, which are sorted a character at a time (MSD, in place, not stable)
+namespace _radix {
+template <class K> concept bits_key = requires(K k) { to_ordered_bits(k); };
+template <class K> concept string_key = requires(const K &k) {
+  { k.data() } -> convertible_to<const char *>;
+  { k.size() } -> convertible_to<size_t>;
+};
+
+// aria::sort sorts the arithmetic values with radix sort from this size
+inline constexpr ptrdiff_t sort_threshold = 1 << 11;
+// the buckets of MSD radix sort below this size are sorted by comparison
+inline constexpr ptrdiff_t small_bucket_size = 64;
+
+template <class Compare, class T>
+inline constexpr bool is_sort_dispatchable = bits_key<T> && (is_same_v<Compare, less<>> || is_same_v<Compare, less<T>>);
+
+// a pass per byte of the key from the lowest, moving the elements between [first, last) and the buffer.
+// The histograms of all the passes are counted at once, and a pass is skipped when all the keys have the same byte in it.
+template <random_access_iterator It, class Proj> void lsd_sort_with_buffer(It first, It last, Proj &proj, iter_value_t<It> *buffer) {
+  using T = iter_value_t<It>;
+  using bits_type = decltype(to_ordered_bits(proj(*first)));
+  constexpr size_t n_passes = sizeof(bits_type);
+  const size_t n = last - first;
+  auto byte_of = [&proj](const T &x, size_t pass) { return size_t(to_ordered_bits(proj(x)) >> (8 * pass)) & 0xff; };
+
+  size_t counts[n_passes][256]{};
+  for (auto it = first; it != last; ++it) {
+    const auto bits = to_ordered_bits(proj(*it));
+    for (size_t pass = 0; pass < n_passes; pass++)
+      counts[pass][size_t(bits >> (8 * pass)) & 0xff]++;
+  }
+
+  bool constructed = false; // the buffer holds objects after the first pass which uses it
+  bool in_buffer = false;
+
+  // scatters src[0, n) to dst at offsets, counts by the byte of the pass
+  auto scatter = [&](auto src, auto dst, size_t pass, size_t(&offsets)[256], bool construct) {
+    for (size_t i = 0; i < n; i++) {
+      auto &x = src[i];
+      const auto pos = offsets[byte_of(x, pass)]++;
+      if (construct)
+        construct_at(addressof(dst[pos]), move(x));
+      else
+        dst[pos] = move(x);
+    }
+  };
+
+  for (size_t pass = 0; pass < n_passes; pass++) {
+    auto &count = counts[pass];
+    const auto first_byte = in_buffer ? byte_of(buffer[0], pass) : byte_of(*first, pass);
+    if (count[first_byte] == n)
+      continue;
+
+    size_t offsets[256];
+    for (size_t b = 0, sum = 0; b < 256; b++) {
+      offsets[b] = sum;
+      sum += count[b];
+    }
+    if (in_buffer) {
+      scatter(buffer, first, pass, offsets, false);
+    } else {
+      scatter(first, buffer, pass, offsets, !constructed);
+      constructed = true;
+    }
+    in_buffer = !in_buffer;
+  }
+
+  if (in_buffer)
+    for (size_t i = 0; i < n; i++)
+      first[i] = move(buffer[i]);
+  if (constructed)
+    destroy(buffer, buffer + n);
+}
+
+template <random_access_iterator It, class Proj, class Allocator> void lsd_sort(It first, It last, Proj &proj, Allocator alloc) {
+  const size_t n = last - first;
+  auto buffer = alloc.allocate(n);
+  lsd_sort_with_buffer(first, last, proj, to_address(buffer));
+  alloc.deallocate(buffer, n);
+}
+} // namespace _radix
+
+// pattern-defeating quicksort (Orson Peters, https://github.com/orlp/pdqsort):
+// introsort with median of 3 (ninther for large ranges) pivots, a partition which groups the elements equal to the pivot
+// when they repeat, a bounded insertion sort for ranges which are already partitioned, and shuffles against bad pivots.
+// Arithmetic values compared with less or greater are partitioned in blocks without branching on the comparisons.
 namespace _sort {
-template <input_iterator It, class Compare> It quick_select(It first, It last, Compare comp) {
-  auto pivot = prev(last);
-  auto pos = partition(first, pivot, [&](const auto &val) { return comp(val, *pivot); });
-  iter_swap(pos, pivot);
-  return pos;
+inline constexpr ptrdiff_t insertion_sort_threshold = 24;
+inline constexpr ptrdiff_t ninther_threshold = 128;
+inline constexpr ptrdiff_t partial_insertion_sort_limit = 8;
+inline constexpr ptrdiff_t block_size = 64;
+
+template <class Compare, class T>
+inline constexpr bool is_branchless = is_arithmetic_v<T> && (is_same_v<Compare, less<>> || is_same_v<Compare, less<T>> ||
+                                                             is_same_v<Compare, greater<>> || is_same_v<Compare, greater<T>>);
+
+inline int log2_floor(ptrdiff_t n) {
+  int res = 0;
+  while (n >>= 1)
+    res++;
+  return res;
 }
 
-template <random_access_iterator It, class Compare> void introsort(It first, It last, Compare comp, int max_depth) {
-  static constexpr int max_length_for_insertion_sort = 16;
-  if (last - first <= 1)
+// Unguarded: there is an element before first which is not greater than any element of the range, so sifting stops without a bound check
+template <bool Unguarded, random_access_iterator It, class Compare> void insertion_sort(It first, It last, Compare comp) {
+  if (first == last)
     return;
-  if (last - first <= max_length_for_insertion_sort) {
-    insertion_sort(first, last, comp);
-  } else if (max_depth == 0) {
-    make_heap(first, last, comp);
-    sort_heap(first, last, comp);
+  for (auto cur = first + 1; cur != last; ++cur) {
+    auto sift = cur, sift_1 = cur - 1;
+    if (comp(*sift, *sift_1)) {
+      auto tmp = move(*sift);
+      do {
+        *sift-- = move(*sift_1);
+      } while ((Unguarded || sift != first) && comp(tmp, *--sift_1));
+      *sift = move(tmp);
+    }
+  }
+}
+
+// gives up and returns false once it has moved more than partial_insertion_sort_limit elements
+template <random_access_iterator It, class Compare> bool partial_insertion_sort(It first, It last, Compare comp) {
+  if (first == last)
+    return true;
+  ptrdiff_t moved = 0;
+  for (auto cur = first + 1; cur != last; ++cur) {
+    auto sift = cur, sift_1 = cur - 1;
+    if (comp(*sift, *sift_1)) {
+      auto tmp = move(*sift);
+      do {
+        *sift-- = move(*sift_1);
+      } while (sift != first && comp(tmp, *--sift_1));
+      *sift = move(tmp);
+      moved += cur - sift;
+    }
+    if (moved > partial_insertion_sort_limit)
+      return false;
+  }
+  return true;
+}
+
+template <random_access_iterator It, class Compare> void sort2(It a, It b, Compare &comp) {
+  if (comp(*b, *a))
+    iter_swap(a, b);
+}
+
+// the median ends up in b
+template <random_access_iterator It, class Compare> void sort3(It a, It b, It c, Compare &comp) {
+  sort2(a, b, comp);
+  sort2(b, c, comp);
+  sort2(a, b, comp);
+}
+
+// Partitions around the pivot *first, the elements equal to the pivot go to the right.
+// Returns the position of the pivot, and whether the range was already partitioned.
+template <random_access_iterator It, class Compare> pair<It, bool> partition_right(It first, It last, Compare &comp) {
+  auto pivot = move(*first);
+  auto f = first, l = last;
+  // *(first + 1) is not greater than the pivot and *(last - 1) not less than it after the median selection
+  while (comp(*++f, pivot)) {
+  }
+  if (f - 1 == first) {
+    while (f < l && !comp(*--l, pivot)) {
+    }
+  } else {
+    while (!comp(*--l, pivot)) {
+    }
+  }
+
+  const bool already_partitioned = f >= l;
+  while (f < l) {
+    iter_swap(f, l);
+    while (comp(*++f, pivot)) {
+    }
+    while (!comp(*--l, pivot)) {
+    }
+  }
+
+  auto pivot_pos = f - 1;
+  *first = move(*pivot_pos);
+  *pivot_pos = move(pivot);
+  return {pivot_pos, already_partitioned};
+}
+
+// swaps the elements at first + offsets_l[i] and last - offsets_r[i]. A cyclic permutation does fewer moves unless num_l == num_r
+template <random_access_iterator It>
+void swap_offsets(It first, It last, const unsigned char *offsets_l, const unsigned char *offsets_r, size_t num, bool use_swaps) {
+  if (use_swaps) {
+    for (size_t i = 0; i < num; ++i)
+      iter_swap(first + offsets_l[i], last - offsets_r[i]);
+  } else if (num > 0) {
+    auto l = first + offsets_l[0];
+    auto r = last - offsets_r[0];
+    auto tmp = move(*l);
+    *l = move(*r);
+    for (size_t i = 1; i < num; ++i) {
+      l = first + offsets_l[i];
+      *r = move(*l);
+      r = last - offsets_r[i];
+      *l = move(*r);
+    }
+    *r = move(tmp);
+  }
+}
+
+// partition_right for cheap comparisons (BlockQuicksort, Edelkamp and Weiss): the comparison results of a block are first
+// recorded as offsets without branches, then the misplaced elements are swapped
+template <random_access_iterator It, class Compare> pair<It, bool> partition_right_branchless(It first, It last, Compare &comp) {
+  auto pivot = move(*first);
+  auto f = first, l = last;
+  while (comp(*++f, pivot)) {
+  }
+  if (f - 1 == first) {
+    while (f < l && !comp(*--l, pivot)) {
+    }
+  } else {
+    while (!comp(*--l, pivot)) {
+    }
+  }
+
+  const bool already_partitioned = f >= l;
+  if (!already_partitioned) {
+    iter_swap(f, l);
+    ++f;
+
+    alignas(64) unsigned char offsets_l[block_size];
+    alignas(64) unsigned char offsets_r[block_size];
+    auto offsets_l_base = f, offsets_r_base = l;
+    size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+    while (f < l) {
+      // only refill the blocks which are empty, and split the rest between them if it is less than two blocks
+      const size_t num_unknown = l - f;
+      const size_t left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+      const size_t right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+
+      for (size_t i = 0, n = min<size_t>(left_split, block_size); i < n; ++i, ++f) {
+        offsets_l[num_l] = static_cast<unsigned char>(i);
+        num_l += !comp(*f, pivot);
+      }
+      for (size_t i = 0, n = min<size_t>(right_split, block_size); i < n;) {
+        offsets_r[num_r] = static_cast<unsigned char>(++i);
+        num_r += comp(*--l, pivot);
+      }
+
+      const size_t num = min(num_l, num_r);
+      swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r, num, num_l == num_r);
+      num_l -= num;
+      num_r -= num;
+      start_l += num;
+      start_r += num;
+      if (num_l == 0) {
+        start_l = 0;
+        offsets_l_base = f;
+      }
+      if (num_r == 0) {
+        start_r = 0;
+        offsets_r_base = l;
+      }
+    }
+
+    // one of the blocks may still have misplaced elements, move them to the boundary
+    if (num_l) {
+      while (num_l--)
+        iter_swap(offsets_l_base + offsets_l[start_l + num_l], --l);
+      f = l;
+    }
+    if (num_r) {
+      while (num_r--) {
+        iter_swap(offsets_r_base - offsets_r[start_r + num_r], f);
+        ++f;
+      }
+      l = f;
+    }
+  }
+
+  auto pivot_pos = f - 1;
+  *first = move(*pivot_pos);
+  *pivot_pos = move(pivot);
+  return {pivot_pos, already_partitioned};
+}
+
+// The elements equal to the pivot *first go to the left, returns the position of the pivot.
+// Used when the pivot equals the element before the range, so [first, pivot] are all equal and already in place.
+template <random_access_iterator It, class Compare> It partition_left(It first, It last, Compare &comp) {
+  auto pivot = move(*first);
+  auto f = first, l = last;
+  while (comp(pivot, *--l)) {
+  }
+  if (l + 1 == last) {
+    while (f < l && !comp(pivot, *++f)) {
+    }
   } else {
-    auto mid = quick_select(first, last, comp);
-    introsort(first, mid, comp, max_depth - 1);
-    introsort(mid + 1, last, comp, max_depth - 1);
+    while (!comp(pivot, *++f)) {
+    }
+  }
+
+  while (f < l) {
+    iter_swap(f, l);
+    while (comp(pivot, *--l)) {
+    }
+    while (!comp(pivot, *++f)) {
+    }
+  }
+
+  *first = move(*l);
+  *l = move(pivot);
+  return l;
+}
+
+// leftmost: first is the beginning of the whole range, otherwise *(first - 1) is not greater than any element of [first, last)
+// bad_allowed: the number of unbalanced partitions before falling back to heap sort
+template <bool Branchless, random_access_iterator It, class Compare>
+void pdqsort(It first, It last, Compare &comp, int bad_allowed, bool leftmost) {
+  while (true) {
+    const auto size = last - first;
+    if (size < insertion_sort_threshold) {
+      if (leftmost)
+        insertion_sort<false>(first, last, comp);
+      else
+        insertion_sort<true>(first, last, comp);
+      return;
+    }
+
+    // the pivot is moved to first
+    const auto s2 = size / 2;
+    if (size > ninther_threshold) {
+      sort3(first, first + s2, last - 1, comp);
+      sort3(first + 1, first + (s2 - 1), last - 2, comp);
+      sort3(first + 2, first + (s2 + 1), last - 3, comp);
+      sort3(first + (s2 - 1), first + s2, first + (s2 + 1), comp);
+      iter_swap(first, first + s2);
+    } else {
+      sort3(first + s2, first, last - 1, comp);
+    }
+
+    // the pivot equals the element before the range, which is a pivot of a previous partition, so no element is less than it.
+    // The elements equal to it are put in place at once, this makes the ranges with many duplicates O(n log k)
+    if (!leftmost && !comp(*(first - 1), *first)) {
+      first = partition_left(first, last, comp) + 1;
+      continue;
+    }
+
+    const auto [pivot_pos, already_partitioned] = [&] {
+      if constexpr (Branchless)
+        return partition_right_branchless(first, last, comp);
+      else
+        return partition_right(first, last, comp);
+    }();
+
+    const auto l_size = pivot_pos - first;
+    const auto r_size = last - (pivot_pos + 1);
+    if (l_size < size / 8 || r_size < size / 8) {
+      if (--bad_allowed == 0) {
+        make_heap(first, last, comp);
+        sort_heap(first, last, comp);
+        return;
+      }
+
+      // break the patterns which lead to the bad pivots
+      if (l_size >= insertion_sort_threshold) {
+        iter_swap(first, first + l_size / 4);
+        iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+        if (l_size > ninther_threshold) {
+          iter_swap(first + 1, first + (l_size / 4 + 1));
+          iter_swap(first + 2, first + (l_size / 4 + 2));
+          iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+          iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+        }
+      }
+      if (r_size >= insertion_sort_threshold) {
+        iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+        iter_swap(last - 1, last - r_size / 4);
+        if (r_size > ninther_threshold) {
+          iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+          iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+          iter_swap(last - 2, last - (1 + r_size / 4));
+          iter_swap(last - 3, last - (2 + r_size / 4));
+        }
+      }
+    } else if (already_partitioned && partial_insertion_sort(first, pivot_pos, comp) && partial_insertion_sort(pivot_pos + 1, last, comp)) {
+      // a balanced partition which moved nothing, the range is likely sorted already
+      return;
+    }
+
+    // recurse into the left part, and loop on the right one
+    pdqsort<Branchless>(first, pivot_pos, comp, bad_allowed, leftmost);
+    first = pivot_pos + 1;
+    leftmost = false;
   }
 }
 
 } // namespace _sort
 
 template <random_access_iterator It, class Compare> void sort(It first, It last, Compare comp) {
-  _sort::introsort(first, last, comp, 2 * log2(last - first + 1));
+  if (last - first < 2)
+    return;
+  if constexpr (contiguous_iterator<It> && _radix::is_sort_dispatchable<Compare, iter_value_t<It>>) {
+    if (last - first >= _radix::sort_threshold) {
+      // sorts in place with pdqsort if the buffer can't be allocated
+      if (_merge::temporary_buffer<iter_value_t<It>> buffer(last - first); buffer.size() > 0) {
+        identity proj;
+        _radix::lsd_sort_with_buffer(first, last, proj, buffer.data());
+        return;
+      }
+    }
+  }
+  constexpr bool branchless = _sort::is_branchless<Compare, iter_value_t<It>>;
+  _sort::pdqsort<branchless>(first, last, comp, _sort::log2_floor(last - first), true);
 }
 
 template <random_access_iterator It> void sort(It first, It last) { return sort(first, last, less{}); }
 
+namespace _radix {
+// American flag sort on the character at depth, the keys which end before it go first. The keys in [first, last) share depth characters.
+// The buckets are sorted recursively except the largest one, which the loop goes on with, so the recursion is at most log2(n) deep
+template <random_access_iterator It, class Proj> void msd_sort(It first, It last, Proj &proj, size_t depth) {
+  for (; last - first >= small_bucket_size; ++depth) {
+    // bucket 0 holds the keys which end at depth, the others are in the order of the characters at depth, as char compares them
+    auto bucket_of = [&proj, depth](const auto &x) -> size_t {
+      const auto &key = proj(x);
+      return depth < size_t(key.size()) ? size_t(to_ordered_bits(key.data()[depth])) + 1 : 0;
+    };
+
+    ptrdiff_t ends[257]{};
+    for (auto it = first; it != last; ++it)
+      ends[bucket_of(*it)]++;
+    size_t largest = 1;
+    for (size_t b = 2; b < 257; b++) {
+      if (ends[b] > ends[largest])
+        largest = b;
+    }
+    ptrdiff_t next[257];
+    for (ptrdiff_t b = 0, sum = 0; b < 257; b++) {
+      next[b] = sum;
+      sum += ends[b];
+      ends[b] = sum;
+    }
+
+    // every swap moves an element into its bucket
+    for (size_t b = 0; b < 257; b++) {
+      while (next[b] < ends[b]) {
+        const auto d = bucket_of(first[next[b]]);
+        if (d == b)
+          next[b]++;
+        else
+          iter_swap(first + next[b], first + next[d]++);
+      }
+    }
+
+    for (size_t b = 1; b < 257; b++) {
+      if (b != largest && ends[b] - ends[b - 1] > 1)
+        msd_sort(first + ends[b - 1], first + ends[b], proj, depth + 1);
+    }
+    last = first + ends[largest];
+    first += ends[largest - 1];
+  }
+  sort(first, last, [&proj](const auto &a, const auto &b) { return proj(a) < proj(b); });
+}
+} // namespace _radix
+
+// Sorts by the keys proj(x), which are integers, floating points, or strings (anything with data() and size() of chars, e.g. string_view).
+// Integers and floating points are sorted stably with a buffer of last - first elements, strings in place and not stably.
+template <random_access_iterator It, class Proj = identity> void radix_sort(It first, It last, Proj proj = {}) {
+  using key_type = remove_cvref_t<decltype(proj(*first))>;
+  static_assert(_radix::bits_key<key_type> || _radix::string_key<key_type>, "the key must be an arithmetic type or a string");
+  if (last - first < 2)
+    return;
+  if constexpr (_radix::bits_key<key_type>)
+    _radix::lsd_sort(first, last, proj, allocator<iter_value_t<It>>());
+  else
+    _radix::msd_sort(first, last, proj, 0);
+}
+
+// the buffer is allocated with alloc
+template <random_access_iterator It, class Proj, class Allocator>
+  requires _radix::bits_key<remove_cvref_t<decltype(declval<Proj &>()(*declval<It>()))>>
+void radix_sort(It first, It last, Proj proj, const Allocator &alloc) {
+  if (last - first < 2)
+    return;
+  _radix::lsd_sort(first, last, proj, alloc);
+}
+
+//-----------------------Merge, stable sort and selection-----------------------
+namespace _merge {
+inline constexpr ptrdiff_t insertion_sort_threshold = 32;
+
+// the shorter of the two runs is moved to the buffer, which has room for it, and merged back. On a tie the element of the left
+// run goes first
+template <random_access_iterator It, class Compare, class T>
+void merge_with_buffer(It first, It middle, It last, Compare &comp, T *buffer) {
+  if (middle - first <= last - middle) {
+    auto buffer_end = buffer;
+    for (auto it = first; it != middle; ++it, ++buffer_end)
+      construct_at(buffer_end, move(*it));
+    auto out = first;
+    auto p = buffer;
+    for (; p != buffer_end && middle != last; ++out) {
+      if (comp(*middle, *p))
+        *out = move(*middle++);
+      else
+        *out = move(*p++);
+    }
+    for (; p != buffer_end; ++p, ++out)
+      *out = move(*p);
+    destroy(buffer, buffer_end);
+  } else {
+    auto buffer_end = buffer;
+    for (auto it = middle; it != last; ++it, ++buffer_end)
+      construct_at(buffer_end, move(*it));
+    auto out = last;
+    auto p = buffer_end;
+    while (p != buffer && middle != first) {
+      if (comp(*(p - 1), *(middle - 1)))
+        *--out = move(*--middle);
+      else
+        *--out = move(*--p);
+    }
+    while (p != buffer)
+      *--out = move(*--p);
+    destroy(buffer, buffer_end);
+  }
+}
+
+// Merges with the buffer once a run fits in it. Before that the runs are split so that the halves can be swapped by a rotation
+// (the first half of the longer run, and the part of the other run which belongs before its end), and the two sides are merged separately.
+template <random_access_iterator It, class Compare, class T>
+void merge_adaptive(It first, It middle, It last, Compare &comp, T *buffer, ptrdiff_t buffer_size) {
+  const ptrdiff_t len1 = middle - first, len2 = last - middle;
+  if (len1 == 0 || len2 == 0 || !comp(*middle, *(middle - 1)))
+    return;
+  if (min(len1, len2) <= buffer_size) {
+    merge_with_buffer(first, middle, last, comp, buffer);
+    return;
+  }
+  if (len1 + len2 == 2) {
+    iter_swap(first, middle);
+    return;
+  }
+
+  It cut1, cut2;
+  if (len1 > len2) {
+    cut1 = first + len1 / 2;
+    cut2 = lower_bound(middle, last, *cut1, comp);
+  } else {
+    cut2 = middle + len2 / 2;
+    cut1 = upper_bound(first, middle, *cut2, comp);
+  }
+  auto new_middle = rotate(cut1, middle, cut2);
+  merge_adaptive(first, cut1, new_middle, comp, buffer, buffer_size);
+  merge_adaptive(new_middle, cut2, last, comp, buffer, buffer_size);
+}
+
+template <random_access_iterator It, class Compare, class T>
+void stable_sort(It first, It last, Compare &comp, T *buffer, ptrdiff_t buffer_size) {
+  if (last - first <= insertion_sort_threshold) {
+    _sort::insertion_sort<false>(first, last, comp);
+    return;
+  }
+  auto middle = first + (last - first) / 2;
+  stable_sort(first, middle, comp, buffer, buffer_size);
+  stable_sort(middle, last, comp, buffer, buffer_size);
+  merge_adaptive(first, middle, last, comp, buffer, buffer_size);
+}
+} // namespace _merge
+
+template <input_iterator It1, input_iterator It2, class OutputIt, class Compare>
+constexpr OutputIt merge(It1 first1, It1 last1, It2 first2, It2 last2, OutputIt d_first, Compare comp) {
+  for (; first1 != last1 && first2 != last2; ++d_first) {
+    if (comp(*first2, *first1))
+      *d_first = *first2++;
+    else
+      *d_first = *first1++;
+  }
+  d_first = copy(first1, last1, d_first);
+  return copy(first2, last2, d_first);
+}
+
+template <input_iterator It1, input_iterator It2, class OutputIt>
+constexpr OutputIt merge(It1 first1, It1 last1, It2 first2, It2 last2, OutputIt d_first) {
+  return merge(first1, last1, first2, last2, d_first, less{});
+}
+
+// uses a buffer for the shorter run if it can be allocated, otherwise merges in place with rotations in O(n log n)
+template <random_access_iterator It, class Compare> void inplace_merge(It first, It middle, It last, Compare comp) {
+  _merge::temporary_buffer<iter_value_t<It>> buffer(min(middle - first, last - middle));
+  _merge::merge_adaptive(first, middle, last, comp, buffer.data(), buffer.size());
+}
+
+template <random_access_iterator It> void inplace_merge(It first, It middle, It last) { inplace_merge(first, middle, last, less{}); }
+
+// merge sort with a buffer of half the elements, or with the in place merge if it can't be allocated
+template <random_access_iterator It, class Compare> void stable_sort(It first, It last, Compare comp) {
+  if (last - first < 2)
+    return;
+  _merge::temporary_buffer<iter_value_t<It>> buffer((last - first + 1) / 2);
+  _merge::stable_sort(first, last, comp, buffer.data(), buffer.size());
+}
+
+template <random_access_iterator It> void stable_sort(It first, It last) { stable_sort(first, last, less{}); }
+
+// keeps the smallest middle - first elements in a max heap, and sorts it at the end
+template <random_access_iterator It, class Compare> void partial_sort(It first, It middle, It last, Compare comp) {
+  if (first == middle)
+    return;
+  make_heap(first, middle, comp);
+  const auto k = middle - first;
+  for (auto it = middle; it != last; ++it) {
+    if (comp(*it, *first)) {
+      iter_swap(it, first);
+      _heap::sift_down(first, 0, k, comp);
+    }
+  }
+  sort_heap(first, middle, comp);
+}
+
+template <random_access_iterator It> void partial_sort(It first, It middle, It last) { partial_sort(first, middle, last, less{}); }
+
+template <input_iterator InputIt, random_access_iterator RandomIt, class Compare>
+RandomIt partial_sort_copy(InputIt first, InputIt last, RandomIt d_first, RandomIt d_last, Compare comp) {
+  auto d_middle = d_first;
+  for (; first != last && d_middle != d_last; ++first, ++d_middle)
+    *d_middle = *first;
+  if (d_middle == d_first)
+    return d_middle;
+
+  make_heap(d_first, d_middle, comp);
+  const auto k = d_middle - d_first;
+  for (; first != last; ++first) {
+    if (comp(*first, *d_first)) {
+      *d_first = *first;
+      _heap::sift_down(d_first, 0, k, comp);
+    }
+  }
+  sort_heap(d_first, d_middle, comp);
+  return d_middle;
+}
+
+template <input_iterator InputIt, random_access_iterator RandomIt>
+RandomIt partial_sort_copy(InputIt first, InputIt last, RandomIt d_first, RandomIt d_last) {
+  return partial_sort_copy(first, last, d_first, d_last, less{});
+}
+
+// Introselect: quickselect with the median of 3 pivots and the partitions of pdqsort, which continues into the side containing nth.
+// A range where the pivot equals the element before it gets the equal elements out of the way at once.
+// After 2 log2(n) partitions it falls back to partial_sort, so the worst case is O(n log n).
+template <random_access_iterator It, class Compare> void nth_element(It first, It nth, It last, Compare comp) {
+  if (nth == last)
+    return;
+  const bool branchless = _sort::is_branchless<Compare, iter_value_t<It>>;
+  const auto begin = first;
+  int depth_limit = 2 * _sort::log2_floor(last - first);
+  while (last - first > _sort::insertion_sort_threshold) {
+    if (depth_limit-- == 0) {
+      partial_sort(first, nth + 1, last, comp);
+      return;
+    }
+
+    const auto s2 = (last - first) / 2;
+    _sort::sort3(first + s2, first, last - 1, comp);
+    if (first != begin && !comp(*(first - 1), *first)) {
+      const auto pivot_pos = _sort::partition_left(first, last, comp);
+      if (nth <= pivot_pos)
+        return;
+      first = pivot_pos + 1;
+      continue;
+    }
+
+    const auto pivot_pos = [&] {
+      if constexpr (branchless)
+        return _sort::partition_right_branchless(first, last, comp).first;
+      else
+        return _sort::partition_right(first, last, comp).first;
+    }();
+    if (pivot_pos == nth)
+      return;
+    if (nth < pivot_pos)
+      last = pivot_pos;
+    else
+      first = pivot_pos + 1;
+  }
+  if (first == begin)
+    _sort::insertion_sort<false>(first, last, comp);
+  else
+    _sort::insertion_sort<true>(first, last, comp);
+}
+
+template <random_access_iterator It> void nth_element(It first, It nth, It last) { nth_element(first, nth, last, less{}); }
+
 } // namespace aria
\ No newline at end of file
@@ -35,6 +35,7 @@ template <allocatable T> struct allocator {
   template <allocatable U> using rebind_alloc = allocator<U>;
 
   constexpr allocator() noexcept = default;
+  template <allocatable U> constexpr allocator(const allocator<U> &) noexcept {}
 
   // todo operator new is not constexpr
   [[nodiscard]] constexpr T *allocate(size_type n) { return static_cast<T *>(::operator new(n * sizeof(T))); }
@@ -44,6 +45,11 @@ template <allocatable T> struct allocator {
 
 template <class T1, class T2> constexpr bool operator==(const allocator<T1> &lhs, const allocator<T2> &rhs) noexcept { return true; }
 
+// defined in memory_resource.h, the containers declare their pmr aliases with it
+namespace pmr {
+template <class T> class polymorphic_allocator;
+}
+
 //------------------------- allocator_traits -------------------------//
 
 template <class Alloc> struct _get_pointer_type : type_identity<typename Alloc::value_type *> {};
@@ -130,7 +136,7 @@ template <class Alloc> struct allocator_traits {
   template <class U> using rebind_alloc = typename _get_rebind_type<U, Alloc>::type;
 
   [[nodiscard]] static constexpr pointer allocate(Alloc &a, size_type n) { return a.allocate(n); }
-  static constexpr void deallocate(Alloc &a, pointer p, size_type n) { a.deallicate(p, n); }
+  static constexpr void deallocate(Alloc &a, pointer p, size_type n) { a.deallocate(p, n); }
 
   template <class T, class... Args> static constexpr void construct(Alloc &a, T *p, Args &&...args) {
     if constexpr (requires { a.construct(p, forward<Args>(args)...); }) {
@@ -140,11 +146,11 @@ template <class Alloc> struct allocator_traits {
     }
   }
 
-  template <class T, class... Args> static constexpr void destroy(Alloc &a, T *p) {
-    if constexpr (requires { a.destory(p); }) {
-      a.destory(p);
+  template <class T> static constexpr void destroy(Alloc &a, T *p) {
+    if constexpr (requires { a.destroy(p); }) {
+      a.destroy(p);
     } else {
-      destory_at(p);
+      destroy_at(p);
     }
   }
 };
@@ -1,10 +1,13 @@
 #pragma once
 #include "algorithm.h"
 #include "allocator.h"
+#include "bit.h"
 #include "iterator.h"
 #include "node_handle.h"
 #include "utility.h"
 
+// binary_search_tree is used to implement map and set, it is a red-black tree.
+// The header node m_root_node works as end(): the root is its left child, and it is regarded as larger than any key.
 namespace aria {
 
 namespace _bst {
@@ -12,9 +15,24 @@ struct node_base {
   node_base *parent{};
   node_base *left{};
   node_base *right{};
+  bool red{};
   void reset_edge() noexcept { parent = left = right = nullptr; }
 };
 
+inline bool is_red(const node_base *p) noexcept { return p && p->red; }
+
+// the number of black nodes on every path from p down to a leaf, or -1 if the subtree is not a valid red-black tree
+inline int black_height(const node_base *p, const node_base *parent) noexcept {
+  if (!p)
+    return 0;
+  if (p->parent != parent || (p->red && (is_red(p->left) || is_red(p->right))))
+    return -1;
+  const auto left = black_height(p->left, p), right = black_height(p->right, p);
+  if (left < 0 || left != right)
+    return -1;
+  return left + !p->red;
+}
+
 node_base *next(node_base *p) {
   if (p->right) {
     p = p->right;
@@ -55,8 +73,9 @@ void right_rotate(node_base *p) {
   if (!p->left)
     return;
   auto par = p->parent, l = p->left, lr = l->right;
+  p->left = lr;
   if (lr)
-    link(p, p->left, lr);
+    lr->parent = p;
   if (par)
     link(par, parent_ref(p), l);
   link(l, l->right, p);
@@ -66,8 +85,9 @@ void left_rotate(node_base *p) {
   if (!p->right)
     return;
   auto par = p->parent, r = p->right, rl = r->left;
+  p->right = rl;
   if (rl)
-    link(p, p->right, rl);
+    rl->parent = p;
   if (par)
     link(par, parent_ref(p), r);
   link(r, r->left, p);
@@ -111,6 +131,10 @@ void swap(node_base &a, node_base &b) {
   swap_parent(&a, &b);
   swap_left(&a, &b);
   swap_right(&a, &b);
+  // the colors belong to the positions in the tree
+  const bool a_red = a.red;
+  a.red = b.red;
+  b.red = a_red;
 
   if (is_left) {
     a.parent = &b;
@@ -121,26 +145,126 @@ void swap(node_base &a, node_base &b) {
   }
 }
 
+// x is a newly linked red node, header is the parent of the root
+inline void insert_fixup(node_base *x, node_base *header) {
+  x->red = true;
+  while (x != header->left && x->parent->red) {
+    auto p = x->parent, g = p->parent; // a red node is never the root, so g exists
+    if (p == g->left) {
+      if (auto u = g->right; is_red(u)) {
+        p->red = u->red = false;
+        g->red = true;
+        x = g;
+      } else {
+        if (x == p->right) {
+          x = p;
+          left_rotate(x);
+          p = x->parent;
+        }
+        p->red = false;
+        g->red = true;
+        right_rotate(g);
+      }
+    } else {
+      if (auto u = g->left; is_red(u)) {
+        p->red = u->red = false;
+        g->red = true;
+        x = g;
+      } else {
+        if (x == p->left) {
+          x = p;
+          right_rotate(x);
+          p = x->parent;
+        }
+        p->red = false;
+        g->red = true;
+        left_rotate(g);
+      }
+    }
+  }
+  header->left->red = false;
+}
+
+// a black node was removed from below parent, and x (maybe null) took its place
+inline void erase_fixup(node_base *x, node_base *parent, node_base *header) {
+  while (x != header->left && !is_red(x)) {
+    if (x == parent->left) {
+      auto w = parent->right; // x is short of one black node, so its sibling is not null
+      if (w->red) {
+        w->red = false;
+        parent->red = true;
+        left_rotate(parent);
+        w = parent->right;
+      }
+      if (!is_red(w->left) && !is_red(w->right)) {
+        w->red = true;
+        x = parent;
+        parent = parent->parent;
+      } else {
+        if (!is_red(w->right)) {
+          w->left->red = false;
+          w->red = true;
+          right_rotate(w);
+          w = parent->right;
+        }
+        w->red = parent->red;
+        parent->red = false;
+        w->right->red = false;
+        left_rotate(parent);
+        x = header->left;
+      }
+    } else {
+      auto w = parent->left;
+      if (w->red) {
+        w->red = false;
+        parent->red = true;
+        right_rotate(parent);
+        w = parent->left;
+      }
+      if (!is_red(w->left) && !is_red(w->right)) {
+        w->red = true;
+        x = parent;
+        parent = parent->parent;
+      } else {
+        if (!is_red(w->left)) {
+          w->right->red = false;
+          w->red = true;
+          left_rotate(w);
+          w = parent->left;
+        }
+        w->red = parent->red;
+        parent->red = false;
+        w->left->red = false;
+        right_rotate(parent);
+        x = header->left;
+      }
+    }
+  }
+  if (x)
+    x->red = false;
+}
+
 template <class T> struct node : public node_base {
   template <class... Args> requires is_constructible_v<T, Args...> node(Args &&...args) : value(forward<Args>(args)...) {}
   T &get_value() { return value; }
   T value;
 };
 
-template <class Key, class T> struct Traits {
+template <class Key, class T, class Allocator> struct Traits {
   using value_type = pair<const Key, T>;
   using internal_node_type = node<value_type>;
-  using node_handle_type = node_handle<internal_node_type, _node_handle::map_base<Key, T>>;
+  using node_handle_type = node_handle<internal_node_type, _node_handle::map_base<Key, T>, Allocator>;
   static const auto &get_key(const value_type &val) { return val.first; }
 };
 
-template <class Key> struct Traits<Key, void> {
+template <class Key, class Allocator> struct Traits<Key, void, Allocator> {
   using value_type = Key;
   using internal_node_type = node<value_type>;
-  using node_handle_type = node_handle<internal_node_type, _node_handle::set_base<Key>>;
+  using node_handle_type = node_handle<internal_node_type, _node_handle::set_base<Key>, Allocator>;
   static const auto &get_key(const value_type &val) { return val; }
 };
 
+template <class Key, class T> using value_type_of = conditional_t<is_void_v<T>, Key, pair<const Key, T>>;
 } // namespace _bst
 
 template <class BSTType> class bst_iterator {
@@ -191,9 +315,10 @@ private:
   node_base_type *ptr;
 };
 
-template <class Key, class T, class Compare = less<Key>> class binary_search_tree : public iterable_mixin {
+template <class Key, class T, class Compare = less<Key>, class Allocator = allocator<_bst::value_type_of<Key, T>>>
+class binary_search_tree : public iterable_mixin {
 public:
-  using traits = _bst::Traits<Key, T>;
+  using traits = _bst::Traits<Key, T, Allocator>;
   using key_type = Key;
   using value_type = traits::value_type;
   using pointer = value_type *;
@@ -203,13 +328,15 @@ public:
   using reference = value_type &;
   using const_reference = const value_type &;
   using key_compare = Compare;
-  using iterator = bst_iterator<binary_search_tree<Key, T, Compare>>;
+  using allocator_type = Allocator;
+  using iterator = bst_iterator<binary_search_tree>;
   using const_iterator = basic_const_iterator<iterator>;
   using reverse_iterator = aria::reverse_iterator<iterator>;
   using const_reverse_iterator = aria::reverse_iterator<const_iterator>;
   using node_handle_type = traits::node_handle_type;
 
   binary_search_tree() = default;
+  explicit binary_search_tree(const Allocator &alloc) : m_alloc(alloc) {}
 
   binary_search_tree(initializer_list<value_type> init, const Compare &comp = Compare()) : m_compare(comp) {
     for (auto &x : init)
@@ -221,13 +348,20 @@ public:
       insert(*first);
   }
 
-  ~binary_search_tree() { clear(); }
+  // [first, last) must be sorted and unique, the tree is built in linear time
+  template <input_iterator It>
+  binary_search_tree(sorted_unique_t, It first, It last, const Compare &comp = Compare()) : m_compare(comp) {
+    insert_range(sorted_unique, first, last);
+  }
 
-  binary_search_tree(const binary_search_tree &rhs) {
-    for (auto &value : rhs)
-      insert(value);
+  binary_search_tree(sorted_unique_t, initializer_list<value_type> init, const Compare &comp = Compare()) : m_compare(comp) {
+    insert_range(sorted_unique, init.begin(), init.end());
   }
 
+  ~binary_search_tree() { clear(); }
+
+  binary_search_tree(const binary_search_tree &rhs) : m_compare(rhs.m_compare) { insert_range(sorted_unique, rhs.begin(), rhs.end()); }
+
   binary_search_tree(binary_search_tree &&rhs) noexcept { swap(rhs); }
 
   binary_search_tree &operator=(const binary_search_tree &rhs) {
@@ -248,6 +382,7 @@ public:
 
   constexpr size_type size() const noexcept { return m_size; }
   constexpr bool empty() const noexcept { return m_size == 0; }
+  allocator_type get_allocator() const { return m_alloc; }
 
   void clear() noexcept {
     destroy_tree(root());
@@ -316,18 +451,70 @@ public:
     }
   }
 
+  // [first, last) must be sorted and unique, values whose keys are already in the tree are skipped.
+  // The values are merged with the nodes of the tree, and the tree is rebuilt in O(size() + distance(first, last)).
+  // The tree is left unchanged if a value constructor or the comparator throws.
+  template <input_iterator It> void insert_range(sorted_unique_t, It first, It last) {
+    // create the new nodes in a chain of their own, each new node keeps the tree node it goes before in its left pointer
+    node_base_type head;
+    auto tail = &head;
+    size_type n = m_size;
+    try {
+      auto pos = m_first;
+      for (; first != last; ++first) {
+        const auto &key = traits::get_key(*first);
+        while (compare(pos, key))
+          pos = _bst::next(pos);
+        if (pos != m_root_end && !m_compare(key, get_key(pos)))
+          continue;
+        auto p = create_node(*first);
+        p->left = pos;
+        tail->right = p;
+        tail = p;
+        n++;
+      }
+      tail->right = nullptr;
+    } catch (...) {
+      tail->right = nullptr;
+      destroy_chain(head.right);
+      throw;
+    }
+
+    // nothing throws from here, splice the new nodes into the chain of the existing nodes
+    auto new_nodes = head.right;
+    tail = flatten(root(), &head);
+    tail->right = m_root_end;
+    for (auto pos = &head; new_nodes;) {
+      auto p = new_nodes;
+      new_nodes = p->right;
+      while (pos->right != p->left)
+        pos = pos->right;
+      p->right = pos->right;
+      pos->right = p;
+      pos = p;
+    }
+
+    m_size = n;
+    auto chain = head.right;
+    if (auto r = build(chain, n, 0, bit_width(n + 1) - 1))
+      link(m_root_end, m_root_end->left, r);
+    else
+      m_root_end->left = nullptr;
+    m_first = n ? head.right : m_root_end;
+  }
+
+  // checks the red-black invariants: a black root, no red node with a red child and the same black height on every path
+  bool is_balanced() const noexcept { return !_bst::is_red(root()) && _bst::black_height(root(), m_root_end) >= 0; }
+
   template <class... Args> pair<iterator, bool> emplace(Args &&...args) {
-    return insert(node_handle_type(static_cast<node_type *>(create_node(forward<Args>(args)...))));
+    return insert(node_handle_type(static_cast<node_type *>(create_node(forward<Args>(args)...)), get_allocator()));
   }
 
   iterator erase(iterator pos) {
     if (pos == end())
       return pos;
-    auto p = pos.ptr;
     auto res = next(pos);
-    if (m_first == p)
-      m_first = next(p);
-    erase_node(p);
+    erase_node(pos.ptr);
     return res;
   }
 
@@ -342,7 +529,7 @@ public:
   node_handle_type extract(iterator pos) {
     if (pos == end())
       return {};
-    return node_handle_type(static_cast<node_type *>(extract_node(pos.ptr)));
+    return node_handle_type(static_cast<node_type *>(extract_node(pos.ptr)), get_allocator());
   }
 
   node_handle_type extract(const Key &key) { return extract(find(key)); }
@@ -375,7 +562,12 @@ private:
 
   template <class... Args> node_base_type *create_node(Args &&...args) {
     auto p = m_alloc.allocate(1);
-    construct_at(p, forward<Args>(args)...);
+    try {
+      construct_at(p, forward<Args>(args)...);
+    } catch (...) {
+      m_alloc.deallocate(p, 1);
+      throw;
+    }
     return p;
   }
 
@@ -389,6 +581,15 @@ private:
     m_alloc.deallocate(q, 1);
   }
 
+  // destroys the nodes linked through their right pointers
+  void destroy_chain(node_base_type *p) {
+    while (p) {
+      auto next_p = p->right;
+      destroy_node(p);
+      p = next_p;
+    }
+  }
+
   void destroy_tree(node_base_type *p) {
     if (!p)
       return;
@@ -398,6 +599,35 @@ private:
     m_size--;
   }
 
+  // links the nodes of the subtree p in order through their right pointers after tail, returns the new tail
+  static node_base_type *flatten(node_base_type *p, node_base_type *tail) {
+    while (p) {
+      tail = flatten(p->left, tail);
+      tail->right = p;
+      tail = p;
+      p = p->right;
+    }
+    return tail;
+  }
+
+  // builds a subtree of the first n nodes of the chain, the sizes of the two subtrees of any node differ by at most one,
+  // so all the empty children are on the last two levels, and painting the nodes on red_depth red keeps the black height equal.
+  static node_base_type *build(node_base_type *&chain, size_type n, size_type depth, size_type red_depth) {
+    if (n == 0)
+      return nullptr;
+    auto left = build(chain, n / 2, depth + 1, red_depth);
+    auto p = chain;
+    chain = chain->right;
+    p->left = left;
+    if (left)
+      left->parent = p;
+    p->red = depth == red_depth;
+    p->right = build(chain, n - n / 2 - 1, depth + 1, red_depth);
+    if (p->right)
+      p->right->parent = p;
+    return p;
+  }
+
   void adjust_on_empty() noexcept {
     if (m_size == 0) {
       m_root_end->left = nullptr;
@@ -437,6 +667,7 @@ private:
       m_first = p;
     }
     m_size++;
+    _bst::insert_fixup(p, m_root_end);
   }
 
   template <class U = value_type> pair<node_base_type *, bool> insert(node_base_type *root, U &&value) {
@@ -452,19 +683,21 @@ private:
 
   // the extracted node need to be destroyed or managered by node handle after the call
   node_base_type *extract_node(node_base_type *p) {
+    if (m_first == p)
+      m_first = next(p);
+
     if (p->left && p->right) {
       auto prev_p = prev(p);
-      _bst::swap(*prev_p, *p);
-      return extract_node(p);
+      _bst::swap(*prev_p, *p); // now p has at most one child
     }
 
-    if (!p->left && !p->right) {
+    auto parent = p->parent, child = p->left ? p->left : p->right;
+    if (child)
+      link(parent, _bst::parent_ref(p), child);
+    else
       _bst::parent_ref(p) = nullptr;
-    } else if (p->left && !p->right) {
-      link(p->parent, _bst::parent_ref(p), p->left);
-    } else if (p->right && !p->left) {
-      link(p->parent, _bst::parent_ref(p), p->right);
-    }
+    if (!p->red)
+      _bst::erase_fixup(child, parent, m_root_end);
 
     p->reset_edge();
     --m_size;
@@ -478,7 +711,7 @@ private:
   node_base_type *m_first = m_root_end;
   key_compare m_compare;
   size_type m_size{};
-  allocator<node_type> m_alloc;
+  typename allocator_traits<Allocator>::template rebind_alloc<node_type> m_alloc;
 };
 
 } // namespace aria
\ No newline at end of file
@@ -1,6 +1,6 @@
 #pragma once
-#include "array.h"
 #include "concepts.h"
+#include "utility.h"
 
 // https://en.cppreference.com/w/cpp/header/bit
 
@@ -25,8 +25,12 @@ constexpr To bit_cast(const From &from) {
 }
 
 template <integral T> constexpr T byteswap(T x) noexcept {
-  auto bits = bit_cast<array<char, sizeof(T)>>(x);
-  reverse(begin(bits), end(bits));
+  struct bytes {
+    char b[sizeof(T)];
+  };
+  auto bits = bit_cast<bytes>(x);
+  for (size_t i = 0; i < sizeof(T) / 2; i++)
+    swap(bits.b[i], bits.b[sizeof(T) - 1 - i]);
   return bit_cast<T>(bits);
 }
 
@@ -57,6 +61,8 @@ template <unsigned_integral T> constexpr int popcount(T x) noexcept {
   return static_cast<int>(x >> (bits - 8));
 }
 
+template <unsigned_integral T> constexpr int countr_zero(T x) noexcept { return popcount(static_cast<T>(~x & (x - 1))); }
+
 template <unsigned_integral T> constexpr T bit_ceil(T x) noexcept {
   if (x != 0)
     return T(1) << bit_width(x - 1);
@@ -69,4 +75,28 @@ template <unsigned_integral T> constexpr T bit_floor(T x) noexcept {
   return 0;
 }
 
+namespace _bit {
+// the unsigned integer with N bytes
+template <size_t N>
+using uint_of_size =
+    conditional_t<N == 1, unsigned char, conditional_t<N == 2, unsigned short, conditional_t<N == 4, unsigned int, unsigned long long>>>;
+} // namespace _bit
+
+// Maps x to an unsigned integer of the same size whose order is the order of the values, so they can be sorted by their bits.
+// For the floating points -0.0 goes before 0.0, and the NaNs go to the ends according to their sign bits.
+template <class T> requires(integral<T> || floating_point<T>) && (!same_as<T, bool>) && (sizeof(T) <= 8)
+constexpr auto to_ordered_bits(T x) noexcept {
+  using U = _bit::uint_of_size<sizeof(T)>;
+  constexpr U sign_bit = U(1) << (8 * sizeof(T) - 1);
+  if constexpr (unsigned_integral<T>) {
+    return U(x);
+  } else if constexpr (integral<T>) {
+    return U(U(x) ^ sign_bit);
+  } else {
+    // a negative float is ordered by its magnitude reversed
+    const auto u = bit_cast<U>(x);
+    return U((u & sign_bit) ? ~u : (u | sign_bit));
+  }
+}
+
 } // namespace aria
\ No newline at end of file
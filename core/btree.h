@@ -0,0 +1,707 @@
+#pragma once
+#include "algorithm.h"
+#include "allocator.h"
+#include "iterator.h"
+#include "node_handle.h"
+#include "utility.h"
+
+// btree is used to implement btree_map and btree_set, it is a B+ tree: the values are only stored in the leaves, the leaves are
+// linked in order, and the internal nodes hold copies of the keys to guide the search. Every node takes about NodeSize bytes, so a
+// lookup touches a few cache lines per level and a range scan reads the values sequentially.
+//
+// Unlike map and set, insert and erase invalidate iterators, because values are moved between the slots of the nodes.
+namespace aria {
+
+namespace _btree {
+struct node_base {
+  node_base *parent{};
+  unsigned short position{}; // the index in parent's children
+  unsigned short count{};    // the number of values in a leaf, or the number of keys in an internal node
+  bool leaf{};
+};
+
+template <class Value, size_t Slots> struct leaf_node : node_base {
+  Value *values() noexcept { return reinterpret_cast<Value *>(storage); }
+  Value &value(size_t i) noexcept { return values()[i]; }
+
+  leaf_node *prev{};
+  leaf_node *next{};
+  alignas(Value) unsigned char storage[Slots * sizeof(Value)];
+};
+
+// keys[i] separates the children: keys in children[i] < keys[i] <= keys in children[i + 1]
+template <class Key, size_t Slots> struct internal_node : node_base {
+  Key *keys() noexcept { return reinterpret_cast<Key *>(storage); }
+  Key &key(size_t i) noexcept { return keys()[i]; }
+
+  node_base *children[Slots + 1];
+  alignas(Key) unsigned char storage[Slots * sizeof(Key)];
+};
+
+// a node has one more slot than its maximum count, it is split right after it overflows
+template <class Value> constexpr size_t leaf_slots(size_t node_size) {
+  constexpr size_t header = sizeof(node_base) + 2 * sizeof(void *);
+  return max<size_t>(4, node_size > header ? (node_size - header) / sizeof(Value) : 0);
+}
+
+template <class Key> constexpr size_t internal_slots(size_t node_size) {
+  constexpr size_t header = sizeof(node_base);
+  return max<size_t>(4, node_size > header ? (node_size - header) / (sizeof(Key) + sizeof(void *)) : 0);
+}
+
+// the values are stored inline in the leaves, so an extracted value is moved into a standalone node
+template <class T> struct value_node {
+  template <class... Args> requires is_constructible_v<T, Args...> value_node(Args &&...args) : value(forward<Args>(args)...) {}
+  T &get_value() { return value; }
+  T value;
+};
+
+template <class Key, class T> using value_type_of = conditional_t<is_void_v<T>, Key, pair<const Key, T>>;
+
+template <class Key, class T, class Allocator> struct Traits {
+  using value_type = pair<const Key, T>;
+  using node_handle_type = node_handle<value_node<value_type>, _node_handle::map_base<Key, T>, Allocator>;
+  static const auto &get_key(const value_type &val) { return val.first; }
+};
+
+template <class Key, class Allocator> struct Traits<Key, void, Allocator> {
+  using value_type = Key;
+  using node_handle_type = node_handle<value_node<value_type>, _node_handle::set_base<Key>, Allocator>;
+  static const auto &get_key(const value_type &val) { return val; }
+};
+
+// move n values from src to dst and destroy the sources, the ranges may overlap. The moves are assumed not to throw
+template <class T> void relocate(T *dst, T *src, size_t n) {
+  if constexpr (is_trivially_relocatable_v<T>) {
+    if (n > 0)
+      memmove(static_cast<void *>(dst), src, n * sizeof(T));
+  } else if (dst < src) {
+    for (size_t i = 0; i < n; i++) {
+      construct_at(dst + i, move(src[i]));
+      destroy_at(src + i);
+    }
+  } else if (dst > src) {
+    for (size_t i = n; i-- > 0;) {
+      construct_at(dst + i, move(src[i]));
+      destroy_at(src + i);
+    }
+  }
+}
+
+} // namespace _btree
+
+template <class TreeType> class btree_iterator {
+public:
+  using iterator_concept = bidirectional_iterator_tag;
+  using value_type = typename TreeType::value_type;
+  using pointer = value_type *;
+  using reference = value_type &;
+  using difference_type = ptrdiff_t;
+  using leaf_type = typename TreeType::leaf_type;
+  friend TreeType;
+
+  btree_iterator() = default;
+  btree_iterator(leaf_type *leaf, size_t index) : m_leaf(leaf), m_index(index) {}
+
+  reference operator*() const noexcept { return m_leaf->value(m_index); }
+  pointer operator->() const noexcept { return &m_leaf->value(m_index); }
+
+  btree_iterator &operator++() noexcept {
+    if (++m_index == m_leaf->count && m_leaf->next) {
+      m_leaf = m_leaf->next;
+      m_index = 0;
+    }
+    return *this;
+  }
+
+  btree_iterator operator++(int) noexcept {
+    auto temp = *this;
+    operator++();
+    return temp;
+  }
+
+  btree_iterator &operator--() noexcept {
+    if (m_index == 0) {
+      m_leaf = m_leaf->prev;
+      m_index = m_leaf->count;
+    }
+    --m_index;
+    return *this;
+  }
+
+  btree_iterator operator--(int) noexcept {
+    auto temp = *this;
+    operator--();
+    return temp;
+  }
+
+  bool operator==(const btree_iterator &rhs) const noexcept { return m_leaf == rhs.m_leaf && m_index == rhs.m_index; }
+
+private:
+  leaf_type *m_leaf{};
+  size_t m_index{};
+};
+
+// Allocator comes after NodeSize, so the node size can be given without an allocator
+template <class Key, class T, class Compare = less<Key>, size_t NodeSize = 256, class Allocator = allocator<_btree::value_type_of<Key, T>>>
+class btree : public iterable_mixin {
+public:
+  using traits = _btree::Traits<Key, T, Allocator>;
+  using key_type = Key;
+  using value_type = traits::value_type;
+  using pointer = value_type *;
+  using mapped_type = T;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using key_compare = Compare;
+  using allocator_type = Allocator;
+  using node_handle_type = traits::node_handle_type;
+
+  static constexpr size_type s_leaf_slots = _btree::leaf_slots<value_type>(NodeSize);
+  static constexpr size_type s_internal_slots = _btree::internal_slots<key_type>(NodeSize);
+  using leaf_type = _btree::leaf_node<value_type, s_leaf_slots>;
+  using internal_type = _btree::internal_node<key_type, s_internal_slots>;
+
+  using iterator = btree_iterator<btree>;
+  using const_iterator = basic_const_iterator<iterator>;
+  using reverse_iterator = aria::reverse_iterator<iterator>;
+  using const_reverse_iterator = aria::reverse_iterator<const_iterator>;
+
+  btree() = default;
+  explicit btree(const Allocator &alloc) : m_leaf_alloc(alloc), m_internal_alloc(alloc) {}
+
+  btree(initializer_list<value_type> init, const Compare &comp = Compare()) : m_compare(comp) {
+    for (auto &x : init)
+      insert(x);
+  }
+
+  template <input_iterator It> btree(It first, It last, const Compare &comp = Compare()) : m_compare(comp) {
+    for (; first != last; ++first)
+      insert(*first);
+  }
+
+  ~btree() { clear(); }
+
+  btree(const btree &rhs) : m_compare(rhs.m_compare) {
+    for (auto &value : rhs)
+      insert(value);
+  }
+
+  btree(btree &&rhs) noexcept { swap(rhs); }
+
+  btree &operator=(const btree &rhs) {
+    if (this != &rhs) {
+      auto tmp = rhs;
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  btree &operator=(btree &&rhs) noexcept {
+    if (this != &rhs) {
+      auto tmp = move(rhs);
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  constexpr size_type size() const noexcept { return m_size; }
+  constexpr bool empty() const noexcept { return m_size == 0; }
+  allocator_type get_allocator() const { return m_leaf_alloc; }
+
+  void clear() noexcept {
+    if (m_root)
+      destroy_tree(m_root);
+    m_root = nullptr;
+    m_leftmost = m_rightmost = nullptr;
+    m_size = 0;
+  }
+
+  bool operator==(const btree &rhs) const noexcept {
+    if (this == &rhs)
+      return true;
+    if (size() != rhs.size())
+      return false;
+    return equal(begin(), end(), rhs.begin());
+  }
+
+  void swap(btree &rhs) noexcept {
+    using aria::swap;
+    swap(m_root, rhs.m_root);
+    swap(m_leftmost, rhs.m_leftmost);
+    swap(m_rightmost, rhs.m_rightmost);
+    swap(m_size, rhs.m_size);
+    swap(m_compare, rhs.m_compare);
+    swap(m_leaf_alloc, rhs.m_leaf_alloc);
+    swap(m_internal_alloc, rhs.m_internal_alloc);
+  }
+
+  auto begin() const noexcept { return const_iterator(m_leftmost, 0); }
+  auto end() const noexcept { return const_iterator(m_rightmost, m_rightmost ? m_rightmost->count : 0); }
+  auto begin() noexcept { return iterator(m_leftmost, 0); }
+  auto end() noexcept { return iterator(m_rightmost, m_rightmost ? m_rightmost->count : 0); }
+
+  //--------------------  Lookup--------------------
+  const_iterator find(const key_type &key) const {
+    if (auto it = lower_bound(key); it != end() && !m_compare(key, get_key(*it)))
+      return it;
+    return end();
+  }
+  iterator find(const key_type &key) { return as_const(*this).find(key); }
+  bool contains(const key_type &key) const { return find(key) != end(); }
+
+  const_iterator lower_bound(const key_type &key) const {
+    if (!m_root)
+      return end();
+    auto leaf = find_leaf(key);
+    return const_iterator(normalize(leaf, lower_index(leaf, key)));
+  }
+  iterator lower_bound(const key_type &key) { return as_const(*this).lower_bound(key); }
+
+  const_iterator upper_bound(const key_type &key) const {
+    if (!m_root)
+      return end();
+    auto leaf = find_leaf(key);
+    return const_iterator(normalize(leaf, upper_index(leaf, key)));
+  }
+  iterator upper_bound(const key_type &key) { return as_const(*this).upper_bound(key); }
+
+  pair<const_iterator, const_iterator> equal_range(const key_type &key) const { return {lower_bound(key), upper_bound(key)}; }
+  pair<iterator, iterator> equal_range(const key_type &key) { return {lower_bound(key), upper_bound(key)}; }
+
+  //--------------------Modifiers--------------------
+  pair<iterator, bool> insert(const value_type &value) { return insert_value(value); }
+  pair<iterator, bool> insert(value_type &&value) { return insert_value(move(value)); }
+
+  pair<iterator, bool> insert(node_handle_type &&nh) {
+    if (!nh)
+      return {end(), false};
+    auto res = insert_value(move(nh->get_value()));
+    if (res.second)
+      nh = node_handle_type();
+    return res;
+  }
+
+  template <class... Args> pair<iterator, bool> emplace(Args &&...args) { return insert_value(value_type(forward<Args>(args)...)); }
+
+  iterator erase(iterator pos) {
+    if (pos == end())
+      return pos;
+    auto leaf = pos.m_leaf;
+    const auto index = pos.m_index;
+    destroy_at(leaf->values() + index);
+    _btree::relocate(leaf->values() + index, leaf->values() + index + 1, leaf->count - index - 1);
+    --leaf->count;
+    --m_size;
+
+    if (leaf == m_root) {
+      if (leaf->count == 0) {
+        destroy_leaf(leaf);
+        m_root = m_leftmost = m_rightmost = nullptr;
+        return end();
+      }
+      return normalize(leaf, index);
+    }
+    if (leaf->count >= s_min_leaf_count)
+      return normalize(leaf, index);
+
+    // rebalancing moves the values around, so the next value is searched again by its key
+    auto next_it = normalize(leaf, index);
+    if (next_it == end()) {
+      rebalance_leaf(leaf);
+      return end();
+    }
+    const key_type next_key = get_key(*next_it);
+    rebalance_leaf(leaf);
+    return lower_bound(next_key);
+  }
+
+  size_type erase(const key_type &key) {
+    if (auto it = find(key); it != end()) {
+      erase(it);
+      return 1;
+    }
+    return 0;
+  }
+
+  node_handle_type extract(iterator pos) {
+    if (pos == end())
+      return {};
+    typename allocator_traits<Allocator>::template rebind_alloc<_btree::value_node<value_type>> alloc(m_leaf_alloc);
+    auto p = alloc.allocate(1);
+    try {
+      construct_at(p, move(*pos));
+    } catch (...) {
+      alloc.deallocate(p, 1);
+      throw;
+    }
+    erase(pos);
+    return node_handle_type(p, get_allocator());
+  }
+
+  node_handle_type extract(const key_type &key) { return extract(find(key)); }
+
+private:
+  using node_base_type = _btree::node_base;
+  static constexpr size_type s_min_leaf_count = (s_leaf_slots - 1) / 2;
+  static constexpr size_type s_min_internal_count = (s_internal_slots - 1) / 2;
+
+  static const key_type &get_key(const value_type &value) { return traits::get_key(value); }
+  static leaf_type *as_leaf(node_base_type *p) noexcept { return static_cast<leaf_type *>(p); }
+  static internal_type *as_internal(node_base_type *p) noexcept { return static_cast<internal_type *>(p); }
+  static const key_type &key_at(leaf_type *p, size_type i) { return get_key(p->value(i)); }
+  static const key_type &key_at(internal_type *p, size_type i) { return p->key(i); }
+
+  // the index of the first key >= key
+  template <class Node> size_type lower_index(Node *p, const key_type &key) const {
+    size_type lo = 0, hi = p->count;
+    while (lo < hi) {
+      const auto mid = (lo + hi) / 2;
+      if (m_compare(key_at(p, mid), key))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  // the index of the first key > key
+  template <class Node> size_type upper_index(Node *p, const key_type &key) const {
+    size_type lo = 0, hi = p->count;
+    while (lo < hi) {
+      const auto mid = (lo + hi) / 2;
+      if (m_compare(key, key_at(p, mid)))
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    return lo;
+  }
+
+  leaf_type *find_leaf(const key_type &key) const {
+    auto p = m_root;
+    while (!p->leaf) {
+      auto q = as_internal(p);
+      p = q->children[upper_index(q, key)];
+    }
+    return as_leaf(p);
+  }
+
+  // the position after the last value of a leaf is the first value of the next leaf
+  static iterator normalize(leaf_type *leaf, size_type index) noexcept {
+    if (index == leaf->count && leaf->next)
+      return iterator(leaf->next, 0);
+    return iterator(leaf, index);
+  }
+
+  static void set_child(internal_type *parent, size_type i, node_base_type *child) noexcept {
+    parent->children[i] = child;
+    child->parent = parent;
+    child->position = static_cast<unsigned short>(i);
+  }
+
+  //--------------------  Node allocation--------------------
+  leaf_type *create_leaf() {
+    auto p = construct_at(m_leaf_alloc.allocate(1));
+    p->leaf = true;
+    return p;
+  }
+
+  internal_type *create_internal() { return construct_at(m_internal_alloc.allocate(1)); }
+
+  // the node must be already empty
+  void destroy_leaf(leaf_type *p) {
+    destroy_at(p);
+    m_leaf_alloc.deallocate(p, 1);
+  }
+
+  void destroy_internal(internal_type *p) {
+    destroy_at(p);
+    m_internal_alloc.deallocate(p, 1);
+  }
+
+  void destroy_tree(node_base_type *p) noexcept {
+    if (p->leaf) {
+      auto leaf = as_leaf(p);
+      for (size_type i = 0; i < leaf->count; i++)
+        destroy_at(leaf->values() + i);
+      destroy_leaf(leaf);
+    } else {
+      auto q = as_internal(p);
+      for (size_type i = 0; i <= q->count; i++)
+        destroy_tree(q->children[i]);
+      for (size_type i = 0; i < q->count; i++)
+        destroy_at(q->keys() + i);
+      destroy_internal(q);
+    }
+  }
+
+  //--------------------  Insertion--------------------
+  template <class U> pair<iterator, bool> insert_value(U &&value) {
+    const auto &key = get_key(value);
+    if (!m_root)
+      m_root = m_leftmost = m_rightmost = create_leaf();
+    auto leaf = find_leaf(key);
+    const auto index = lower_index(leaf, key);
+    if (index < leaf->count && !m_compare(key, key_at(leaf, index)))
+      return {iterator(leaf, index), false};
+
+    if (leaf->count + 1 < s_leaf_slots) {
+      construct_in_leaf(leaf, index, forward<U>(value));
+      ++m_size;
+      return {iterator(leaf, index), true};
+    }
+
+    // appending to the rightmost leaf (or prepending to the leftmost one) keeps the old leaf full, so sorted input packs the leaves
+    size_type mid = s_leaf_slots / 2;
+    if (index == leaf->count && !leaf->next)
+      mid = s_leaf_slots - 1;
+    else if (index == 0 && !leaf->prev)
+      mid = 1;
+
+    // the new nodes and the separator key are made before the leaf is changed, and the split doesn't throw, so the tree
+    // is unchanged if an allocation, a key copy or the value constructor throws
+    auto right = allocate_split(leaf);
+    try {
+      key_type separator(mid < index ? key_at(leaf, mid) : mid == index ? key : key_at(leaf, mid - 1));
+      construct_in_leaf(leaf, index, forward<U>(value));
+      ++m_size;
+      split_leaf(leaf, mid, move(separator), right);
+    } catch (...) {
+      destroy_split(right);
+      throw;
+    }
+    return {index < mid ? iterator(leaf, index) : iterator(right, index - mid), true};
+  }
+
+  // shift the tail and construct the value in the gap, the gap is closed again if the constructor throws
+  template <class U> void construct_in_leaf(leaf_type *leaf, size_type index, U &&value) {
+    _btree::relocate(leaf->values() + index + 1, leaf->values() + index, leaf->count - index);
+    try {
+      construct_at(leaf->values() + index, forward<U>(value));
+    } catch (...) {
+      _btree::relocate(leaf->values() + index, leaf->values() + index + 1, leaf->count - index);
+      throw;
+    }
+    ++leaf->count;
+  }
+
+  // The nodes a split of leaf needs: the new leaf, and an internal node for each full ancestor, plus a new root if they are
+  // all full. The internal nodes are chained by parent from the new leaf
+  leaf_type *allocate_split(leaf_type *leaf) {
+    auto right = create_leaf();
+    try {
+      for (node_base_type *p = leaf; p == m_root || p->parent->count + 1 == s_internal_slots; p = p->parent) {
+        auto q = create_internal();
+        q->parent = right->parent;
+        right->parent = q;
+        if (p == m_root)
+          break;
+      }
+    } catch (...) {
+      destroy_split(right);
+      throw;
+    }
+    return right;
+  }
+
+  // frees the nodes of allocate_split, when it isn't done
+  void destroy_split(leaf_type *right) noexcept {
+    for (auto p = right->parent; p;)
+      destroy_internal(as_internal(exchange(p, p->parent)));
+    destroy_leaf(right);
+  }
+
+  static internal_type *take_spare(node_base_type *&spare) noexcept {
+    auto p = as_internal(exchange(spare, spare->parent));
+    p->parent = nullptr;
+    return p;
+  }
+
+  // the leaf has just overflowed, right comes from allocate_split
+  void split_leaf(leaf_type *leaf, size_type mid, key_type &&separator, leaf_type *right) noexcept {
+    auto spare = exchange(right->parent, nullptr);
+    _btree::relocate(right->values(), leaf->values() + mid, leaf->count - mid);
+    right->count = static_cast<unsigned short>(leaf->count - mid);
+    leaf->count = static_cast<unsigned short>(mid);
+
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next)
+      leaf->next->prev = right;
+    else
+      m_rightmost = right;
+    leaf->next = right;
+
+    insert_into_parent(leaf, move(separator), right, spare);
+  }
+
+  // insert key and the new node right next to left, the nodes of the splits are taken from spare
+  void insert_into_parent(node_base_type *left, key_type &&key, node_base_type *right, node_base_type *&spare) noexcept {
+    if (left == m_root) {
+      auto root = take_spare(spare);
+      construct_at(root->keys(), move(key));
+      root->count = 1;
+      set_child(root, 0, left);
+      set_child(root, 1, right);
+      m_root = root;
+      return;
+    }
+
+    auto parent = as_internal(left->parent);
+    const size_type pos = left->position;
+    _btree::relocate(parent->keys() + pos + 1, parent->keys() + pos, parent->count - pos);
+    construct_at(parent->keys() + pos, move(key));
+    for (size_type i = parent->count + 1; i > pos + 1; i--)
+      set_child(parent, i, parent->children[i - 1]);
+    set_child(parent, pos + 1, right);
+    ++parent->count;
+    if (parent->count == s_internal_slots)
+      split_internal(parent, spare);
+  }
+
+  // the middle key moves up to the parent
+  void split_internal(internal_type *node, node_base_type *&spare) noexcept {
+    const size_type mid = node->count / 2;
+    auto right = take_spare(spare);
+    _btree::relocate(right->keys(), node->keys() + mid + 1, node->count - mid - 1);
+    for (size_type i = mid + 1; i <= node->count; i++)
+      set_child(right, i - mid - 1, node->children[i]);
+    right->count = static_cast<unsigned short>(node->count - mid - 1);
+    node->count = static_cast<unsigned short>(mid);
+
+    insert_into_parent(node, move(node->key(mid)), right, spare);
+    destroy_at(node->keys() + mid);
+  }
+
+  //--------------------  Erasure--------------------
+  // the leaf is not the root and has too few values: borrow one value from a sibling, or merge with it
+  void rebalance_leaf(leaf_type *leaf) {
+    auto parent = as_internal(leaf->parent);
+    const size_type pos = leaf->position;
+    if (pos > 0) {
+      if (auto left = as_leaf(parent->children[pos - 1]); left->count > s_min_leaf_count) {
+        _btree::relocate(leaf->values() + 1, leaf->values(), leaf->count);
+        _btree::relocate(leaf->values(), left->values() + left->count - 1, 1);
+        --left->count;
+        ++leaf->count;
+        parent->key(pos - 1) = key_at(leaf, 0);
+        return;
+      }
+    }
+    if (pos < parent->count) {
+      if (auto right = as_leaf(parent->children[pos + 1]); right->count > s_min_leaf_count) {
+        _btree::relocate(leaf->values() + leaf->count, right->values(), 1);
+        _btree::relocate(right->values(), right->values() + 1, right->count - 1);
+        --right->count;
+        ++leaf->count;
+        parent->key(pos) = key_at(right, 0);
+        return;
+      }
+    }
+    if (pos > 0)
+      merge_leaf(as_leaf(parent->children[pos - 1]), leaf);
+    else
+      merge_leaf(leaf, as_leaf(parent->children[pos + 1]));
+  }
+
+  // move all the values of right to left, and remove right
+  void merge_leaf(leaf_type *left, leaf_type *right) {
+    _btree::relocate(left->values() + left->count, right->values(), right->count);
+    left->count += right->count;
+    left->next = right->next;
+    if (right->next)
+      right->next->prev = left;
+    else
+      m_rightmost = left;
+
+    auto parent = as_internal(right->parent);
+    const size_type pos = right->position;
+    destroy_leaf(right);
+    remove_from_internal(parent, pos - 1);
+  }
+
+  // remove the key at index and the child after it
+  void remove_from_internal(internal_type *node, size_type index) {
+    destroy_at(node->keys() + index);
+    _btree::relocate(node->keys() + index, node->keys() + index + 1, node->count - index - 1);
+    for (size_type i = index + 1; i < node->count; i++)
+      set_child(node, i, node->children[i + 1]);
+    --node->count;
+
+    if (node == m_root) {
+      if (node->count == 0) { // the tree becomes one level lower
+        m_root = node->children[0];
+        m_root->parent = nullptr;
+        destroy_internal(node);
+      }
+      return;
+    }
+    if (node->count < s_min_internal_count)
+      rebalance_internal(node);
+  }
+
+  // rotate a key through the parent from a sibling, or merge with it
+  void rebalance_internal(internal_type *node) {
+    auto parent = as_internal(node->parent);
+    const size_type pos = node->position;
+    if (pos > 0) {
+      if (auto left = as_internal(parent->children[pos - 1]); left->count > s_min_internal_count) {
+        _btree::relocate(node->keys() + 1, node->keys(), node->count);
+        for (size_type i = node->count + 1; i > 0; i--)
+          set_child(node, i, node->children[i - 1]);
+        construct_at(node->keys(), move(parent->key(pos - 1)));
+        set_child(node, 0, left->children[left->count]);
+        parent->key(pos - 1) = move(left->key(left->count - 1));
+        destroy_at(left->keys() + left->count - 1);
+        --left->count;
+        ++node->count;
+        return;
+      }
+    }
+    if (pos < parent->count) {
+      if (auto right = as_internal(parent->children[pos + 1]); right->count > s_min_internal_count) {
+        construct_at(node->keys() + node->count, move(parent->key(pos)));
+        set_child(node, node->count + 1, right->children[0]);
+        parent->key(pos) = move(right->key(0));
+        destroy_at(right->keys());
+        _btree::relocate(right->keys(), right->keys() + 1, right->count - 1);
+        for (size_type i = 0; i < right->count; i++)
+          set_child(right, i, right->children[i + 1]);
+        --right->count;
+        ++node->count;
+        return;
+      }
+    }
+    if (pos > 0)
+      merge_internal(as_internal(parent->children[pos - 1]), node);
+    else
+      merge_internal(node, as_internal(parent->children[pos + 1]));
+  }
+
+  // the separator comes down from the parent, followed by all the keys and children of right
+  void merge_internal(internal_type *left, internal_type *right) {
+    auto parent = as_internal(right->parent);
+    const size_type pos = right->position;
+    construct_at(left->keys() + left->count, move(parent->key(pos - 1)));
+    _btree::relocate(left->keys() + left->count + 1, right->keys(), right->count);
+    for (size_type i = 0; i <= right->count; i++)
+      set_child(left, left->count + 1 + i, right->children[i]);
+    left->count += right->count + 1;
+
+    destroy_internal(right);
+    remove_from_internal(parent, pos - 1);
+  }
+
+  node_base_type *m_root = nullptr;
+  leaf_type *m_leftmost = nullptr;
+  leaf_type *m_rightmost = nullptr;
+  size_type m_size = 0;
+  key_compare m_compare;
+  typename allocator_traits<Allocator>::template rebind_alloc<leaf_type> m_leaf_alloc;
+  typename allocator_traits<Allocator>::template rebind_alloc<internal_type> m_internal_alloc;
+};
+
+} // namespace aria
\ No newline at end of file
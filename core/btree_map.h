@@ -0,0 +1,71 @@
+#pragma once
+#include "btree.h"
+#include "stdexcept.h"
+
+namespace aria {
+
+template <class Key, class T, class Compare = less<Key>, size_t NodeSize = 256, class Allocator = allocator<pair<const Key, T>>>
+class btree_map : public btree<Key, T, Compare, NodeSize, Allocator> {
+public:
+  using Base = btree<Key, T, Compare, NodeSize, Allocator>;
+  using key_type = Key;
+  using value_type = typename Base::value_type;
+  using mapped_type = T;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using key_compare = Compare;
+  using allocator_type = Allocator;
+  using iterator = typename Base::iterator;
+  using const_iterator = typename Base::const_iterator;
+  using reverse_iterator = aria::reverse_iterator<iterator>;
+  using const_reverse_iterator = aria::reverse_iterator<const_iterator>;
+
+  using Base::Base;
+
+  T &operator[](const Key &key) {
+    if (auto it = Base::find(key); it != Base::end())
+      return it->second;
+    else
+      return Base::insert(value_type(key, T{})).first->second;
+  }
+
+  const T &at(const Key &key) const {
+    if (auto it = Base::find(key); it == Base::end())
+      throw out_of_range("aria::btree_map::at() key is not found");
+    else
+      return it->second;
+  }
+
+  T &at(const Key &key) { return const_cast<T &>(as_const(*this).at(key)); }
+
+  template <class M> pair<iterator, bool> insert_or_assign(const Key &key, M &&obj) {
+    if (auto it = Base::find(key); it == Base::end()) {
+      return Base::emplace(key, forward<M>(obj));
+    } else {
+      it->second = forward<M>(obj);
+      return {it, false};
+    }
+  }
+};
+
+template <class Key, class T, class Compare, size_t NodeSize, class Alloc>
+void swap(btree_map<Key, T, Compare, NodeSize, Alloc> &lhs, btree_map<Key, T, Compare, NodeSize, Alloc> &rhs) noexcept {
+  lhs.swap(rhs);
+}
+
+// erase invalidates the iterators of btree_map, so the loop continues with the iterator returned by erase
+template <class Key, class T, class Compare, size_t NodeSize, class Alloc, class Pred>
+size_t erase_if(btree_map<Key, T, Compare, NodeSize, Alloc> &c, Pred pred) {
+  size_t old_size = c.size();
+  for (auto it = begin(c); it != end(c);) {
+    if (pred(*it)) {
+      it = c.erase(it);
+    } else
+      ++it;
+  }
+  return old_size - c.size();
+}
+
+} // namespace aria
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include "btree.h"
+
+namespace aria {
+
+template <class Key, class Compare = less<Key>, size_t NodeSize = 256, class Allocator = allocator<Key>>
+class btree_set : public btree<Key, void, Compare, NodeSize, Allocator> {
+public:
+  using Base = btree<Key, void, Compare, NodeSize, Allocator>;
+  using key_type = Key;
+  using value_type = Key;
+  using pointer = value_type *;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using key_compare = Compare;
+  using value_compare = Compare;
+  using allocator_type = Allocator;
+  using iterator = typename Base::iterator;
+  using const_iterator = typename Base::const_iterator;
+  using reverse_iterator = aria::reverse_iterator<iterator>;
+  using const_reverse_iterator = aria::reverse_iterator<const_iterator>;
+
+  using Base::Base;
+};
+
+template <class Key, class Compare, size_t NodeSize, class Alloc>
+void swap(btree_set<Key, Compare, NodeSize, Alloc> &lhs, btree_set<Key, Compare, NodeSize, Alloc> &rhs) noexcept {
+  lhs.swap(rhs);
+}
+
+template <class Key, class Compare, size_t NodeSize, class Alloc, class Pred>
+size_t erase_if(btree_set<Key, Compare, NodeSize, Alloc> &c, Pred pred) {
+  size_t old_size = c.size();
+  for (auto it = begin(c); it != end(c);) {
+    if (pred(*it)) {
+      it = c.erase(it);
+    } else
+      ++it;
+  }
+  return old_size - c.size();
+}
+
+} // namespace aria
\ No newline at end of file
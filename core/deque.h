@@ -2,11 +2,22 @@
 #include "algorithm.h" //aria::max
 #include "allocator.h"
 #include "iterator.h"
+#include "ranges.h"
+#include "small_vector.h"
 #include "utility.h"
-#include "vector.h"
 
+// The elements are stored in fixed size blocks. The map of the blocks is a ring buffer whose capacity is a power of 2,
+// so growing at either end is amortized O(1). Blocks which become empty are kept for reuse (at most s_max_spare_blocks),
+// so a queue which oscillates around a block boundary doesn't allocate.
 namespace aria {
 
+namespace _deque {
+// at least 512 bytes and 16 elements per block
+template <class T> inline constexpr size_t default_block_size = max<size_t>(512 / sizeof(T), 16);
+} // namespace _deque
+
+// The iterator caches the element and its block, so stepping within a block doesn't go through the map.
+// The index orders the iterators, and it finds the block again when a step leaves the current one.
 template <class DequeType> class deque_const_iterator {
 public:
   using iterator_concept = random_access_iterator_tag;
@@ -14,19 +25,17 @@ public:
   using pointer = typename DequeType::const_pointer;
   using reference = const value_type &;
   using difference_type = ptrdiff_t;
-  using bucket_pointer = pointer const *;
 
   deque_const_iterator() = default;
-  deque_const_iterator(bucket_pointer p, difference_type aindex) : ptr(p), index(aindex) {}
+  deque_const_iterator(const DequeType *d, difference_type aindex) : deq(d), index(aindex) { locate(); }
 
-  reference operator*() const noexcept { return *(*ptr + index); }
-  pointer operator->() const noexcept { return *ptr + index; }
+  reference operator*() const noexcept { return *cur; }
+  pointer operator->() const noexcept { return cur; }
 
   deque_const_iterator &operator++() noexcept {
-    if (++index == DequeType::s_bucket_size) {
-      ++ptr;
-      index = 0;
-    }
+    ++index;
+    if (!cur || ++cur == first + DequeType::s_block_size)
+      locate();
     return *this;
   }
 
@@ -37,10 +46,11 @@ public:
   }
 
   deque_const_iterator &operator--() noexcept {
-    if (--index < 0) {
-      --ptr;
-      index = DequeType::s_bucket_size - 1;
-    }
+    --index;
+    if (cur && cur != first)
+      --cur;
+    else
+      locate();
     return *this;
   }
 
@@ -51,18 +61,14 @@ public:
   }
 
   deque_const_iterator &operator+=(const difference_type d) noexcept {
-    ptr += (index + d) / DequeType::s_bucket_size;
-    index = (index + d) % DequeType::s_bucket_size;
+    index += d;
+    locate();
     return *this;
   }
 
   deque_const_iterator &operator-=(const difference_type d) noexcept {
-    ptr += (index - d) / DequeType::s_bucket_size;
-    index = (index - d) % DequeType::s_bucket_size;
-    if (index < 0) {
-      ptr--;
-      index += DequeType::s_bucket_size;
-    }
+    index -= d;
+    locate();
     return *this;
   }
 
@@ -78,18 +84,27 @@ public:
     return temp;
   }
 
-  difference_type operator-(const deque_const_iterator rhs) const noexcept {
-    return (ptr - rhs.ptr) * DequeType::s_bucket_size + index - rhs.index;
-  }
+  difference_type operator-(const deque_const_iterator rhs) const noexcept { return index - rhs.index; }
 
-  auto operator<=>(const deque_const_iterator &) const noexcept = default;
+  bool operator==(const deque_const_iterator &rhs) const noexcept { return index == rhs.index; }
+  auto operator<=>(const deque_const_iterator &rhs) const noexcept { return index <=> rhs.index; }
 
 private:
-  bucket_pointer ptr{};
+  void locate() noexcept {
+    if (deq) {
+      const auto block = deq->locate(index);
+      first = block.first;
+      cur = block.second;
+    }
+  }
+
+  const DequeType *deq{};
   difference_type index{};
+  pointer cur{};   // the element, nullptr if no block holds index
+  pointer first{}; // the first element of its block
 };
 
-template <class T, class Allocator = allocator<T>> class deque : public iterable_mixin {
+template <class T, class Allocator = allocator<T>, size_t BlockSize = _deque::default_block_size<T>> class deque : public iterable_mixin {
 public:
   using size_type = size_t;
   using difference_type = ptrdiff_t;
@@ -99,13 +114,17 @@ public:
   using allocator_type = Allocator;
   using pointer = typename allocator_traits<Allocator>::pointer;
   using const_pointer = typename allocator_traits<Allocator>::const_pointer;
-  using const_iterator = deque_const_iterator<deque<T, Allocator>>;
+  using const_iterator = deque_const_iterator<deque>;
   using iterator = mutable_iterator<const_iterator>;
   using reverse_iterator = aria::reverse_iterator<iterator>;
   using const_reverse_iterator = aria::reverse_iterator<const_iterator>;
-  inline static constexpr int s_bucket_size = max<size_type>(64 / sizeof(T), 16);
+  static constexpr size_type s_block_size = BlockSize;
+  static constexpr size_type s_max_spare_blocks = 2;
+
+  static_assert(BlockSize > 0);
 
   deque() noexcept = default;
+  explicit deque(const Allocator &alloc) noexcept : m_alloc(alloc) {}
 
   deque(initializer_list<T> init) {
     for (const auto &x : init)
@@ -113,21 +132,14 @@ public:
   }
 
   ~deque() {
-    for (int i = 0; i < size(); i++)
-      destroy_at(get(i));
-    for (auto p : m_buckets) {
-      m_alloc.deallocate(p, s_bucket_size);
-    }
+    clear();
+    while (m_n_spare > 0)
+      m_alloc.deallocate(m_spare[--m_n_spare], s_block_size);
   }
 
-  deque(const deque &rhs)
-      : m_buckets(rhs.m_buckets.size()), m_start(rhs.m_start), m_end(rhs.m_end), m_bucket_start_index(rhs.m_bucket_start_index),
-        m_alloc(rhs.m_alloc) {
-    for (int i = m_bucket_start_index; i < m_buckets.size(); i++) {
-      m_buckets[i] = create_bucket();
-    }
-    for (int i = 0; i < rhs.size(); i++)
-      construct_at(get(i), rhs[i]);
+  deque(const deque &rhs) : m_alloc(rhs.m_alloc) {
+    for (const auto &x : rhs)
+      push_back(x);
   }
 
   deque &operator=(const deque &rhs) {
@@ -148,116 +160,261 @@ public:
     return *this;
   }
 
-  void push_back(const_reference val) {
-    if (m_end == s_bucket_size) {
-      m_buckets.push_back(create_bucket());
-      m_end = 0;
+  void push_back(const_reference val) { emplace_back(val); }
+  void push_back(value_type &&val) { emplace_back(move(val)); }
+  void push_front(const_reference val) { emplace_front(val); }
+  void push_front(value_type &&val) { emplace_front(move(val)); }
+
+  template <class... Args> reference emplace_back(Args &&...args) {
+    if (m_start + m_size == m_n_blocks * s_block_size)
+      add_back_block();
+    auto p = get(m_size);
+    construct_at(p, forward<Args>(args)...);
+    m_size++;
+    return *p;
+  }
+
+  template <class... Args> reference emplace_front(Args &&...args) {
+    if (m_start == 0) {
+      add_front_block();
+      m_start = s_block_size;
     }
-    construct_at(&(m_buckets.back()[m_end]), val);
-    m_end++;
+    auto p = get_block(0) + m_start - 1;
+    construct_at(p, forward<Args>(args)...);
+    --m_start;
+    ++m_size;
+    return *p;
   }
 
   void pop_back() {
-    destroy_at(m_buckets.back() + m_end - 1);
-    if (--m_end == 0) {
-      deallocate_bucket(m_buckets.size() - 1);
-      m_buckets.pop_back();
-      m_end = s_bucket_size;
+    destroy_at(get(--m_size));
+    if (m_start + m_size <= (m_n_blocks - 1) * s_block_size)
+      remove_back_block();
+  }
+
+  void pop_front() {
+    destroy_at(get(0));
+    --m_size;
+    if (++m_start == s_block_size) {
+      remove_front_block();
+      m_start = 0;
     }
   }
 
-  void push_front(const_reference val) {
-    if (m_start == 0) {
-      if (m_bucket_start_index == 0) {
-        expand_buckets(1);
+  // the blocks are allocated up front and filled one at a time
+  template <ranges::range R> void append_range(R &&rg) {
+    auto first = ranges::begin(rg);
+    auto last = ranges::end(rg);
+    if constexpr (forward_iterator<decltype(first)>) {
+      const auto n = _vector::range_size(first, last);
+      while (m_n_blocks * s_block_size < m_start + m_size + n)
+        add_back_block();
+      construct_range(m_start + m_size, first, n);
+      m_size += n;
+    } else {
+      for (; first != last; ++first)
+        emplace_back(*first);
+    }
+  }
+
+  // the elements keep their order, rg's first element becomes the front
+  template <ranges::range R> void prepend_range(R &&rg) {
+    auto first = ranges::begin(rg);
+    auto last = ranges::end(rg);
+    if constexpr (forward_iterator<decltype(first)>) {
+      const auto n = _vector::range_size(first, last);
+      while (m_start < n) {
+        add_front_block();
+        m_start += s_block_size;
       }
-      m_buckets[--m_bucket_start_index] = create_bucket();
-      m_start = s_bucket_size;
+      construct_range(m_start - n, first, n);
+      m_start -= n;
+      m_size += n;
+    } else {
+      deque temp(m_alloc);
+      temp.append_range(forward<R>(rg));
+      prepend_range(temp);
     }
-    --m_start;
-    construct_at(&(m_buckets[m_bucket_start_index][m_start]), val);
   }
 
-  void pop_front() {
-    destroy_at(m_buckets[m_bucket_start_index] + m_start);
-    if (++m_start == s_bucket_size) {
-      deallocate_bucket(m_bucket_start_index);
-      ++m_bucket_start_index;
-      m_start = 0;
+  // moves at most n elements from the front to out, and removes them
+  template <class OutputIt> OutputIt pop_front_n(size_type n, OutputIt out) {
+    n = min(n, m_size);
+    while (n > 0) {
+      const auto count = min(n, s_block_size - m_start);
+      auto p = get_block(0) + m_start;
+      if constexpr (contiguous_iterator<OutputIt> && is_trivially_copyable_v<T> && is_same_v<iter_value_t<OutputIt>, T>) {
+        memcpy(static_cast<void *>(to_address(out)), p, sizeof(value_type) * count);
+        out += count;
+      } else {
+        for (size_type i = 0; i < count; i++, ++out) {
+          *out = move(p[i]);
+          destroy_at(p + i);
+        }
+      }
+      m_start += count;
+      m_size -= count;
+      n -= count;
+      if (m_start == s_block_size) {
+        remove_front_block();
+        m_start = 0;
+      }
     }
+    return out;
   }
 
-  bool empty() const noexcept { return size() == 0; }
-  size_type size() const noexcept {
-    if (m_buckets.empty())
-      return 0;
-    return (m_buckets.size() - m_bucket_start_index - 1) * s_bucket_size + m_end - m_start;
+  void clear() noexcept {
+    for (size_type i = 0; i < m_size; i++)
+      destroy_at(get(i));
+    while (m_n_blocks > 0)
+      remove_back_block();
+    m_start = 0;
+    m_size = 0;
+    m_head = 0;
   }
 
+  bool empty() const noexcept { return size() == 0; }
+  size_type size() const noexcept { return m_size; }
+
   const_reference operator[](size_type i) const { return *get(i); }
-  reference operator[](size_type i) { return const_cast<reference>(*get(i)); }
+  reference operator[](size_type i) { return *get(i); }
 
-  reference back() noexcept { return m_buckets.back()[m_end - 1]; }
-  const_reference back() const noexcept { return m_buckets.back()[m_end - 1]; }
-  reference front() noexcept { return m_buckets[m_bucket_start_index][m_start]; }
-  const_reference front() const noexcept { m_buckets[m_bucket_start_index][m_start]; }
+  reference back() noexcept { return *get(m_size - 1); }
+  const_reference back() const noexcept { return *get(m_size - 1); }
+  reference front() noexcept { return *get(0); }
+  const_reference front() const noexcept { return *get(0); }
 
-  const_iterator begin() const noexcept { return const_iterator(&m_buckets[m_bucket_start_index], m_start); }
-  const_iterator end() const noexcept { return const_iterator(&m_buckets.back(), m_end); }
-  iterator begin() noexcept { return iterator(&m_buckets[m_bucket_start_index], m_start); }
-  iterator end() noexcept { return iterator(&m_buckets.back(), m_end); }
+  const_iterator begin() const noexcept { return const_iterator(this, 0); }
+  const_iterator end() const noexcept { return const_iterator(this, m_size); }
+  iterator begin() noexcept { return iterator(this, 0); }
+  iterator end() noexcept { return iterator(this, m_size); }
 
   void swap(deque &rhs) noexcept {
     using aria::swap;
-    swap(m_buckets, rhs.m_buckets);
+    swap(m_map, rhs.m_map);
+    swap(m_head, rhs.m_head);
+    swap(m_n_blocks, rhs.m_n_blocks);
     swap(m_start, rhs.m_start);
-    swap(m_end, rhs.m_end);
-    swap(m_bucket_start_index, rhs.m_bucket_start_index);
+    swap(m_size, rhs.m_size);
+    swap(m_spare, rhs.m_spare);
+    swap(m_n_spare, rhs.m_n_spare);
     swap(m_alloc, rhs.m_alloc);
   }
 
 private:
-  pointer create_bucket() { return m_alloc.allocate(s_bucket_size); }
-
-  void deallocate_bucket(size_type i) {
-    m_alloc.deallocate(m_buckets[i], s_bucket_size);
-    m_buckets[i] = nullptr;
+  friend const_iterator;
+
+  // {the block which holds the i-th element, the element}, nullptrs if no block holds it
+  pair<pointer, pointer> locate(difference_type i) const noexcept {
+    const auto pos = static_cast<difference_type>(m_start) + i;
+    if (pos < 0 || pos >= static_cast<difference_type>(m_n_blocks * s_block_size))
+      return {nullptr, nullptr};
+    auto block = get_block(pos / s_block_size);
+    return {block, block + pos % s_block_size};
   }
 
+  // the i-th block from the front
+  pointer get_block(size_type i) const { return m_map[(m_head + i) & (m_map.size() - 1)]; }
+
   pointer get(size_type i) const {
-    auto index = (m_start + i) % s_bucket_size;
-    auto bucket_index = m_bucket_start_index + (m_start + i) / s_bucket_size;
-    return m_buckets[bucket_index] + index;
+    const auto pos = m_start + i;
+    return get_block(pos / s_block_size) + pos % s_block_size;
   }
 
-  pointer get_bucket(size_type i) const { return m_buckets[i + m_bucket_start_index]; }
-  size_type buckets_size() const { return m_buckets.size() - m_bucket_start_index; }
+  // constructs n elements from first at the positions [pos, pos + n) counted from the first block, a block at a time
+  template <class It> void construct_range(size_type pos, It first, size_type n) {
+    while (n > 0) {
+      const auto offset = pos % s_block_size;
+      const auto count = min(n, s_block_size - offset);
+      auto p = get_block(pos / s_block_size) + offset;
+      if constexpr (contiguous_iterator<It> && is_trivially_copyable_v<T> && is_same_v<remove_cv_t<iter_value_t<It>>, T>) {
+        memcpy(static_cast<void *>(p), to_address(first), sizeof(value_type) * count);
+        first += count;
+      } else {
+        for (size_type i = 0; i < count; ++i, ++first)
+          construct_at(p + i, *first);
+      }
+      pos += count;
+      n -= count;
+    }
+  }
+
+  pointer create_block() {
+    if (m_n_spare > 0)
+      return m_spare[--m_n_spare];
+    return m_alloc.allocate(s_block_size);
+  }
 
-  void expand_buckets(size_type n) {
-    auto new_size = buckets_size() + n;
-    vector<pointer> new_buckets(new_size, nullptr);
-    new_buckets.reserve(new_size * 3);
-    for (int i = 0; i < buckets_size(); i++)
-      new_buckets.push_back(get_bucket(i));
-    m_buckets = new_buckets;
-    m_bucket_start_index = new_size;
+  void free_block(pointer p) {
+    if (m_n_spare < s_max_spare_blocks)
+      m_spare[m_n_spare++] = p;
+    else
+      m_alloc.deallocate(p, s_block_size);
   }
 
-  vector<pointer> m_buckets;
-  size_type m_start{};
-  size_type m_end{s_bucket_size};
-  size_type m_bucket_start_index{};
+  void add_back_block() {
+    if (m_n_blocks == m_map.size())
+      grow_map();
+    m_map[(m_head + m_n_blocks) & (m_map.size() - 1)] = create_block();
+    ++m_n_blocks;
+  }
+
+  void add_front_block() {
+    if (m_n_blocks == m_map.size())
+      grow_map();
+    const auto head = (m_head + m_map.size() - 1) & (m_map.size() - 1);
+    m_map[head] = create_block();
+    m_head = head;
+    ++m_n_blocks;
+  }
+
+  void remove_back_block() {
+    --m_n_blocks;
+    free_block(get_block(m_n_blocks));
+  }
+
+  void remove_front_block() {
+    free_block(get_block(0));
+    m_head = (m_head + 1) & (m_map.size() - 1);
+    --m_n_blocks;
+  }
+
+  // doubles the ring, the blocks are moved to the beginning of the new one
+  void grow_map() {
+    bucket_map new_map(max<size_type>(m_map.size() * 2, bucket_map::s_inline_capacity), nullptr);
+    for (size_type i = 0; i < m_n_blocks; i++)
+      new_map[i] = get_block(i);
+    m_map = move(new_map);
+    m_head = 0;
+  }
+
+  // small deques don't allocate the map
+  using bucket_map = small_vector<pointer, 8>;
+
+  bucket_map m_map;
+  size_type m_head{};     // position of the first block in m_map
+  size_type m_n_blocks{}; // number of blocks in use
+  size_type m_start{};    // position of the first element in the first block
+  size_type m_size{};
+  pointer m_spare[s_max_spare_blocks]{};
+  size_type m_n_spare{};
   Allocator m_alloc;
 };
 
-template <class T, class Allocator> void swap(deque<T, Allocator> &a, deque<T, Allocator> &b) { a.swap(b); }
+template <class T, class Alloc, size_t B> void swap(deque<T, Alloc, B> &a, deque<T, Alloc, B> &b) { a.swap(b); }
 
-template <class T, class Alloc> [[nodiscard]] constexpr bool operator==(const deque<T, Alloc> &a, const deque<T, Alloc> &b) {
+template <class T, class Alloc, size_t B>
+[[nodiscard]] constexpr bool operator==(const deque<T, Alloc, B> &a, const deque<T, Alloc, B> &b) {
   return equal(a.begin(), a.end(), b.begin(), b.end());
 }
 
-template <class T, class Alloc> [[nodiscard]] constexpr auto operator<=>(const deque<T, Alloc> &a, const deque<T, Alloc> &b) {
+template <class T, class Alloc, size_t B>
+[[nodiscard]] constexpr auto operator<=>(const deque<T, Alloc, B> &a, const deque<T, Alloc, B> &b) {
   return lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end());
 }
 
+namespace pmr {
+template <class T> using deque = aria::deque<T, polymorphic_allocator<T>>;
+}
+
 } // namespace aria
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include "flat_hash_table.h"
+#include "stdexcept.h"
+
+namespace aria {
+
+template <class Key, class T, class Hash = hash<Key>, class KeyEqual = equal_to<Key>>
+class flat_hash_map : public flat_hash_table<Key, T, Hash, KeyEqual> {
+public:
+  using Base = flat_hash_table<Key, T, Hash, KeyEqual>;
+  using key_type = Key;
+  using value_type = typename Base::value_type;
+  using mapped_type = T;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using iterator = typename Base::iterator;
+  using const_iterator = typename Base::const_iterator;
+
+  using Base::Base;
+
+  T &operator[](const Key &key) { return try_emplace(key).first->second; }
+
+  const T &at(const Key &key) const {
+    auto it = Base::find(key);
+    if (it == Base::end())
+      throw out_of_range("flat_hash_map::at() key is not found");
+    else
+      return it->second;
+  }
+
+  T &at(const Key &key) { return const_cast<T &>(as_const(*this).at(key)); }
+
+  // unlike emplace, the mapped value is only constructed if the key is not found
+  template <class... Args> pair<iterator, bool> try_emplace(const Key &key, Args &&...args) {
+    auto [index, inserted] = Base::find_or_prepare_insert(key);
+    if (inserted)
+      Base::construct_prepared(index, [&](value_type *p) { construct_at(p, key, T(forward<Args>(args)...)); });
+    return {Base::iterator_at(index), inserted};
+  }
+
+  template <class M> pair<iterator, bool> insert_or_assign(const Key &key, M &&obj) {
+    auto [index, inserted] = Base::find_or_prepare_insert(key);
+    if (inserted)
+      Base::construct_prepared(index, [&](value_type *p) { construct_at(p, key, forward<M>(obj)); });
+    else
+      Base::slot(index)->second = forward<M>(obj);
+    return {Base::iterator_at(index), inserted};
+  }
+};
+
+template <class Key, class T, class Hash, class KeyEqual>
+void swap(flat_hash_map<Key, T, Hash, KeyEqual> &lhs, flat_hash_map<Key, T, Hash, KeyEqual> &rhs) noexcept {
+  lhs.swap(rhs);
+}
+
+template <class Key, class T, class Hash, class KeyEqual>
+bool operator==(const flat_hash_map<Key, T, Hash, KeyEqual> &lhs, const flat_hash_map<Key, T, Hash, KeyEqual> &rhs) {
+  if (&lhs == &rhs)
+    return true;
+  if (lhs.size() != rhs.size())
+    return false;
+  return all_of(begin(lhs), end(lhs), [&](const auto &kv) {
+    const auto &[k, v] = kv;
+    auto it = rhs.find(k);
+    return (it != rhs.end()) && (it->second == v);
+  });
+}
+
+template <class Key, class T, class Hash, class KeyEqual, class Pred> size_t erase_if(flat_hash_map<Key, T, Hash, KeyEqual> &c, Pred pred) {
+  size_t old_size = c.size();
+  for (auto it = begin(c); it != end(c);) {
+    if (pred(*it)) {
+      it = c.erase(it);
+    } else
+      ++it;
+  }
+  return old_size - c.size();
+}
+
+} // namespace aria
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include "flat_hash_table.h"
+
+namespace aria {
+
+template <class Key, class Hash = hash<Key>, class KeyEqual = equal_to<Key>>
+class flat_hash_set : public flat_hash_table<Key, void, Hash, KeyEqual> {
+public:
+  using Base = flat_hash_table<Key, void, Hash, KeyEqual>;
+  using key_type = Key;
+  using value_type = typename Base::value_type;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using iterator = typename Base::iterator;
+  using const_iterator = typename Base::const_iterator;
+  static_assert(is_same_v<key_type, value_type>);
+
+  using Base::Base;
+};
+
+template <class Key, class Hash, class KeyEqual>
+void swap(flat_hash_set<Key, Hash, KeyEqual> &lhs, flat_hash_set<Key, Hash, KeyEqual> &rhs) noexcept {
+  lhs.swap(rhs);
+}
+
+template <class Key, class Hash, class KeyEqual>
+bool operator==(const flat_hash_set<Key, Hash, KeyEqual> &lhs, const flat_hash_set<Key, Hash, KeyEqual> &rhs) {
+  if (&lhs == &rhs)
+    return true;
+  if (lhs.size() != rhs.size())
+    return false;
+  return all_of(begin(lhs), end(lhs), [&](const auto &key) { return rhs.contains(key); });
+}
+
+template <class Key, class Hash, class KeyEqual, class Pred> size_t erase_if(flat_hash_set<Key, Hash, KeyEqual> &c, Pred pred) {
+  size_t old_size = c.size();
+  for (auto it = begin(c); it != end(c);) {
+    if (pred(*it)) {
+      it = c.erase(it);
+    } else
+      ++it;
+  }
+  return old_size - c.size();
+}
+
+} // namespace aria
\ No newline at end of file
@@ -0,0 +1,548 @@
+#pragma once
+
+#include "algorithm.h"
+#include "allocator.h"
+#include "bit.h"
+#include "functional.h"
+#include "iterator.h"
+#include "simd.h"
+#include "utility.h"
+#include <cassert>
+
+// flat_hash_table is used to implement flat_hash_set and flat_hash_map.
+// It is an open addressing (SwissTable style) hash table: all elements are stored inline in one slab of slots, and every slot has a
+// one byte control word which is either empty, deleted or the low 7 bits (H2) of the element's hash. A lookup loads a whole group of
+// control bytes at a time and only compares the keys whose H2 matches, so most probes never touch the slots at all.
+namespace aria {
+
+namespace _flat_hash_table {
+using ctrl_t = signed char;
+using h2_t = unsigned char;
+
+inline constexpr ctrl_t ctrl_empty = -128;  // 0b10000000
+inline constexpr ctrl_t ctrl_deleted = -2;  // 0b11111110
+inline constexpr ctrl_t ctrl_sentinel = -1; // 0b11111111, marks the end of the slots for iteration
+
+constexpr bool is_empty(ctrl_t c) noexcept { return c == ctrl_empty; }
+constexpr bool is_full(ctrl_t c) noexcept { return c >= 0; }
+constexpr bool is_deleted(ctrl_t c) noexcept { return c == ctrl_deleted; }
+constexpr bool is_empty_or_deleted(ctrl_t c) noexcept { return c < ctrl_sentinel; }
+
+constexpr size_t h1(size_t hash) noexcept { return hash >> 7; }
+constexpr h2_t h2(size_t hash) noexcept { return hash & 0x7F; }
+
+// the result of matching a group, each matched control byte sets one bit (or one byte when Shift is 3)
+template <class T, int Width, int Shift> class bit_mask {
+public:
+  explicit constexpr bit_mask(T mask) noexcept : m_mask(mask) {}
+
+  bit_mask &operator++() noexcept {
+    m_mask &= (m_mask - 1);
+    return *this;
+  }
+  int operator*() const noexcept { return lowest_bit_set(); }
+  bit_mask begin() const noexcept { return *this; }
+  bit_mask end() const noexcept { return bit_mask(0); }
+  bool operator==(const bit_mask &) const noexcept = default;
+  explicit operator bool() const noexcept { return m_mask != 0; }
+
+  int lowest_bit_set() const noexcept { return trailing_zeros(); }
+  int trailing_zeros() const noexcept { return countr_zero(m_mask) >> Shift; }
+  int leading_zeros() const noexcept {
+    constexpr int extra_bits = sizeof(T) * 8 - (Width << Shift);
+    return countl_zero(static_cast<T>(m_mask << extra_bits)) >> Shift;
+  }
+
+private:
+  T m_mask;
+};
+
+// portable implementation: 8 control bytes are packed into one 64 bit word and matched with bit tricks
+struct group_portable {
+  static constexpr size_t width = 8;
+  using mask_type = bit_mask<size_t, width, 3>;
+
+  explicit group_portable(const ctrl_t *pos) noexcept { memcpy(&ctrl, pos, sizeof(ctrl)); } // assume little endian
+
+  mask_type match(h2_t hash) const noexcept {
+    const auto x = ctrl ^ (lsbs * hash);
+    return mask_type((x - lsbs) & ~x & msbs);
+  }
+
+  mask_type mask_empty() const noexcept { return mask_type((ctrl & ~(ctrl << 6)) & msbs); }
+  mask_type mask_empty_or_deleted() const noexcept { return mask_type((ctrl & ~(ctrl << 7)) & msbs); }
+
+  static constexpr size_t msbs = 0x8080'8080'8080'8080ull;
+  static constexpr size_t lsbs = 0x0101'0101'0101'0101ull;
+  size_t ctrl;
+};
+
+#if ARIA_HAS_SSE2
+// SSE2 implementation: 16 control bytes are compared with one instruction, and movemask turns the result into one bit per byte
+struct group_sse2 {
+  static constexpr size_t width = 16;
+  using mask_type = bit_mask<unsigned int, width, 0>;
+
+  explicit group_sse2(const ctrl_t *pos) noexcept : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos))) {}
+
+  mask_type match(h2_t hash) const noexcept { return to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(hash)), ctrl)); }
+  mask_type mask_empty() const noexcept { return to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(ctrl_empty), ctrl)); }
+  mask_type mask_empty_or_deleted() const noexcept { return to_mask(_mm_cmpgt_epi8(_mm_set1_epi8(ctrl_sentinel), ctrl)); }
+
+  static mask_type to_mask(__m128i x) noexcept { return mask_type(static_cast<unsigned int>(_mm_movemask_epi8(x))); }
+  __m128i ctrl;
+};
+#endif
+
+#if ARIA_HAS_AVX2
+// AVX2 implementation: the same as SSE2 but 32 control bytes at a time
+struct group_avx2 {
+  static constexpr size_t width = 32;
+  using mask_type = bit_mask<unsigned int, width, 0>;
+
+  explicit group_avx2(const ctrl_t *pos) noexcept : ctrl(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(pos))) {}
+
+  mask_type match(h2_t hash) const noexcept { return to_mask(_mm256_cmpeq_epi8(_mm256_set1_epi8(static_cast<char>(hash)), ctrl)); }
+  mask_type mask_empty() const noexcept { return to_mask(_mm256_cmpeq_epi8(_mm256_set1_epi8(ctrl_empty), ctrl)); }
+  mask_type mask_empty_or_deleted() const noexcept { return to_mask(_mm256_cmpgt_epi8(_mm256_set1_epi8(ctrl_sentinel), ctrl)); }
+
+  static mask_type to_mask(__m256i x) noexcept { return mask_type(static_cast<unsigned int>(_mm256_movemask_epi8(x))); }
+  __m256i ctrl;
+};
+#endif
+
+// the widest implementation available is chosen at compile time
+#if ARIA_HAS_AVX2
+using group = group_avx2;
+#elif ARIA_HAS_SSE2
+using group = group_sse2;
+#else
+using group = group_portable;
+#endif
+
+// the sequence of group offsets visited for a hash: triangular probing over groups, which visits every group once
+template <size_t Width> class probe_seq {
+public:
+  probe_seq(size_t hash, size_t mask) noexcept : m_mask(mask), m_offset(hash & mask) {}
+
+  size_t offset() const noexcept { return m_offset; }
+  size_t offset(size_t i) const noexcept { return (m_offset + i) & m_mask; }
+  size_t index() const noexcept { return m_index; }
+
+  void next() noexcept {
+    m_index += Width;
+    m_offset = (m_offset + m_index) & m_mask;
+  }
+
+private:
+  size_t m_mask;
+  size_t m_offset;
+  size_t m_index = 0;
+};
+
+// capacity is always 2^n - 1, so that it can be used as the probing mask
+constexpr size_t normalize_capacity(size_t n) noexcept { return n ? ~size_t{} >> countl_zero(n) : 1; }
+
+// the table grows when it is 7/8 full
+constexpr size_t capacity_to_growth(size_t capacity) noexcept {
+  if (group::width == 8 && capacity == 7)
+    return 6;
+  return capacity - capacity / 8;
+}
+
+constexpr size_t growth_to_lower_bound_capacity(size_t growth) noexcept {
+  if (group::width == 8 && growth == 7)
+    return 8;
+  return growth + (growth == 0 ? 0 : (growth - 1) / 7);
+}
+
+template <class Key, class T> struct Traits {
+  using value_type = pair<const Key, T>;
+  static const auto &get_key(const value_type &val) { return val.first; }
+};
+
+template <class Key> struct Traits<Key, void> {
+  using value_type = Key;
+  static const auto &get_key(const value_type &val) { return val; }
+};
+} // namespace _flat_hash_table
+
+template <class TableType> class flat_hash_table_const_iterator {
+public:
+  using iterator_concept = forward_iterator_tag;
+  using value_type = typename TableType::value_type;
+  using pointer = const value_type *;
+  using reference = const value_type &;
+  using difference_type = ptrdiff_t;
+  using ctrl_t = _flat_hash_table::ctrl_t;
+  friend TableType;
+
+  flat_hash_table_const_iterator() = default;
+  flat_hash_table_const_iterator(const ctrl_t *ctrl, const value_type *slot) : m_ctrl(ctrl), m_slot(slot) {}
+
+  reference operator*() const noexcept { return *m_slot; }
+  pointer operator->() const noexcept { return m_slot; }
+
+  flat_hash_table_const_iterator &operator++() noexcept {
+    ++m_ctrl;
+    ++m_slot;
+    skip_empty_or_deleted();
+    return *this;
+  }
+
+  flat_hash_table_const_iterator operator++(int) noexcept {
+    auto temp = *this;
+    operator++();
+    return temp;
+  }
+
+  bool operator==(const flat_hash_table_const_iterator &rhs) const noexcept { return m_ctrl == rhs.m_ctrl; }
+
+private:
+  // stops at a full slot or at the sentinel
+  void skip_empty_or_deleted() noexcept {
+    while (_flat_hash_table::is_empty_or_deleted(*m_ctrl)) {
+      ++m_ctrl;
+      ++m_slot;
+    }
+  }
+
+  const ctrl_t *m_ctrl = nullptr;
+  const value_type *m_slot = nullptr;
+};
+
+template <class Key, class T, class Hash = hash<Key>, class KeyEqual = equal_to<Key>> class flat_hash_table : public iterable_mixin {
+public:
+  using traits = _flat_hash_table::Traits<Key, T>;
+  using key_type = Key;
+  using value_type = traits::value_type;
+  using mapped_type = T;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using const_iterator = flat_hash_table_const_iterator<flat_hash_table>;
+  using iterator = mutable_iterator<const_iterator>;
+
+  flat_hash_table() noexcept = default;
+  ~flat_hash_table() { release(); }
+
+  explicit flat_hash_table(size_type bucket_count) { rehash(bucket_count); }
+
+  flat_hash_table(initializer_list<value_type> ilist) {
+    reserve(ilist.size());
+    for (auto &x : ilist)
+      insert(x);
+  }
+
+  template <input_iterator InputIt> flat_hash_table(InputIt first, InputIt last) {
+    for (; first != last; ++first)
+      insert(*first);
+  }
+
+  flat_hash_table(const flat_hash_table &rhs) : m_hasher(rhs.m_hasher), m_key_equal(rhs.m_key_equal) {
+    reserve(rhs.size());
+    for (auto &x : rhs)
+      insert(x);
+  }
+
+  flat_hash_table(flat_hash_table &&rhs) noexcept { swap(rhs); }
+
+  flat_hash_table &operator=(const flat_hash_table &rhs) {
+    if (&rhs != this) {
+      auto temp = rhs;
+      swap(temp);
+    }
+    return *this;
+  }
+
+  flat_hash_table &operator=(flat_hash_table &&rhs) noexcept {
+    if (&rhs != this) {
+      auto temp = aria::move(rhs);
+      swap(temp);
+    }
+    return *this;
+  }
+
+  //--------------------  Iterators (cbegin and rebegin are derived from iterable_mixin )--------------------
+  const_iterator begin() const noexcept {
+    if (empty())
+      return end();
+    auto it = const_iterator(m_ctrl, m_slots);
+    it.skip_empty_or_deleted();
+    return it;
+  }
+  const_iterator end() const noexcept { return const_iterator(m_ctrl + m_capacity, m_slots + m_capacity); }
+  iterator begin() noexcept { return as_const(*this).begin(); }
+  iterator end() noexcept { return as_const(*this).end(); }
+
+  //--------------------  Capacity--------------------
+  size_type size() const noexcept { return m_size; }
+  bool empty() const noexcept { return m_size == 0; }
+
+  //--------------------  Lookup--------------------
+  const_iterator find(const key_type &key) const {
+    if (m_capacity == 0)
+      return end();
+    const auto hash = hash_of(key);
+    for (auto seq = probe(hash);; seq.next()) {
+      const group g(m_ctrl + seq.offset());
+      for (int i : g.match(_flat_hash_table::h2(hash))) {
+        const auto index = seq.offset(i);
+        if (m_key_equal(traits::get_key(m_slots[index]), key))
+          return iterator_at(index);
+      }
+      if (g.mask_empty())
+        return end();
+      assert(seq.index() <= m_capacity && "full table");
+    }
+  }
+
+  iterator find(const key_type &key) { return as_const(*this).find(key); }
+  bool contains(const key_type &key) const { return find(key) != end(); }
+
+  //--------------------  Bucket interface--------------------
+  size_type bucket_count() const noexcept { return m_capacity; }
+
+  //--------------------Hash policy--------------------
+  void rehash(size_type bucket_count) {
+    const auto new_capacity = _flat_hash_table::normalize_capacity(max(bucket_count, growth_to_capacity(size())));
+    if (bucket_count > 0 && new_capacity > m_capacity)
+      resize(new_capacity);
+  }
+
+  void reserve(size_type count) {
+    if (count > size() + m_growth_left)
+      rehash(growth_to_capacity(count));
+  }
+
+  float load_factor() const noexcept { return m_capacity == 0 ? 0.0f : float(size()) / m_capacity; }
+  // the maximum load factor is fixed to 7/8, setting it is a no-op
+  float max_load_factor() const noexcept { return 7.0f / 8; }
+  void max_load_factor(float) noexcept {}
+
+  //--------------------Modifiers--------------------
+  pair<iterator, bool> insert(const_reference value) { return emplace_value(value); }
+  pair<iterator, bool> insert(value_type &&value) { return emplace_value(move(value)); }
+
+  template <class... Args> pair<iterator, bool> emplace(Args &&...args) { return emplace_value(value_type(forward<Args>(args)...)); }
+
+  iterator erase(const_iterator pos) {
+    if (pos == end())
+      return pos;
+    erase_at(index_of(pos));
+    ++pos;
+    return pos;
+  }
+
+  size_type erase(const key_type &key) {
+    if (auto it = find(key); it != end()) {
+      erase_at(index_of(it));
+      return 1;
+    }
+    return 0;
+  }
+
+  void clear() noexcept {
+    destroy_slots();
+    if (m_capacity > 0)
+      reset_ctrl();
+    m_size = 0;
+  }
+
+  void swap(flat_hash_table &rhs) noexcept {
+    using aria::swap;
+    swap(m_ctrl, rhs.m_ctrl);
+    swap(m_slots, rhs.m_slots);
+    swap(m_size, rhs.m_size);
+    swap(m_capacity, rhs.m_capacity);
+    swap(m_growth_left, rhs.m_growth_left);
+    swap(m_hasher, rhs.m_hasher);
+    swap(m_key_equal, rhs.m_key_equal);
+  }
+
+protected:
+  using ctrl_t = _flat_hash_table::ctrl_t;
+  using group = _flat_hash_table::group;
+  using probe_seq = _flat_hash_table::probe_seq<group::width>;
+  static constexpr size_type s_num_cloned_bytes = group::width - 1;
+  static_assert(alignof(value_type) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+  // the hash is mixed so that both H1 and H2 get enough entropy even if the hasher is weak in the low or high bits
+  size_type hash_of(const key_type &key) const {
+    const size_type h = m_hasher(key) * 0x9E37'79B9'7F4A'7C15ull;
+    return h ^ (h >> 32);
+  }
+
+  probe_seq probe(size_type hash) const noexcept { return probe_seq(_flat_hash_table::h1(hash), m_capacity); }
+
+  static size_type growth_to_capacity(size_type growth) noexcept { return _flat_hash_table::growth_to_lower_bound_capacity(growth); }
+
+  iterator iterator_at(size_type index) const noexcept { return const_iterator(m_ctrl + index, m_slots + index); }
+  value_type *slot(size_type index) const noexcept { return m_slots + index; }
+  size_type index_of(const_iterator it) const noexcept { return it.m_ctrl - m_ctrl; }
+
+  // the last group_width - 1 control bytes mirror the first ones, so a group can be loaded at any offset
+  void set_ctrl(size_type index, ctrl_t c) noexcept {
+    m_ctrl[index] = c;
+    m_ctrl[((index - s_num_cloned_bytes) & m_capacity) + (s_num_cloned_bytes & m_capacity)] = c;
+  }
+
+  // return the index of the first empty or deleted slot in the probe sequence of hash
+  size_type find_first_non_full(size_type hash) const noexcept {
+    for (auto seq = probe(hash);; seq.next()) {
+      const group g(m_ctrl + seq.offset());
+      if (auto mask = g.mask_empty_or_deleted())
+        return seq.offset(mask.lowest_bit_set());
+    }
+  }
+
+  // return {index, true} if key is not found, the control byte at index is already marked as full
+  // and the caller must construct the element in slot(index) with construct_prepared
+  pair<size_type, bool> find_or_prepare_insert(const key_type &key) {
+    const auto hash = hash_of(key);
+    if (m_capacity > 0) {
+      for (auto seq = probe(hash);; seq.next()) {
+        const group g(m_ctrl + seq.offset());
+        for (int i : g.match(_flat_hash_table::h2(hash))) {
+          const auto index = seq.offset(i);
+          if (m_key_equal(traits::get_key(m_slots[index]), key))
+            return {index, false};
+        }
+        if (g.mask_empty())
+          break;
+      }
+    }
+    return {prepare_insert(hash), true};
+  }
+
+  size_type prepare_insert(size_type hash) {
+    if (m_capacity == 0)
+      resize(1);
+    auto target = find_first_non_full(hash);
+    if (m_growth_left == 0 && !_flat_hash_table::is_deleted(m_ctrl[target])) {
+      rehash_and_grow();
+      target = find_first_non_full(hash);
+    }
+    ++m_size;
+    m_growth_left -= _flat_hash_table::is_empty(m_ctrl[target]);
+    set_ctrl(target, _flat_hash_table::h2(hash));
+    return target;
+  }
+
+  // construct the element of a prepared slot with make(slot), and give the slot back if it throws
+  template <class F> void construct_prepared(size_type index, F &&make) {
+    try {
+      make(slot(index));
+    } catch (...) {
+      release_slot(index);
+      throw;
+    }
+  }
+
+  template <class U> pair<iterator, bool> emplace_value(U &&value) {
+    auto [index, inserted] = find_or_prepare_insert(traits::get_key(value));
+    if (inserted)
+      construct_prepared(index, [&](value_type *p) { construct_at(p, forward<U>(value)); });
+    return {iterator_at(index), inserted};
+  }
+
+  void erase_at(size_type index) {
+    destroy_at(slot(index));
+    release_slot(index);
+  }
+
+  // a slot can be marked empty again only if no probe sequence ever passed over it as part of a full group
+  void release_slot(size_type index) noexcept {
+    --m_size;
+    const auto index_before = (index - group::width) & m_capacity;
+    const auto empty_after = group(m_ctrl + index).mask_empty();
+    const auto empty_before = group(m_ctrl + index_before).mask_empty();
+    const bool was_never_full =
+        empty_before && empty_after && (empty_after.trailing_zeros() + empty_before.leading_zeros()) < int(group::width);
+    set_ctrl(index, was_never_full ? _flat_hash_table::ctrl_empty : _flat_hash_table::ctrl_deleted);
+    m_growth_left += was_never_full;
+  }
+
+  // squash the tombstones if they take a lot of space, otherwise double the capacity
+  void rehash_and_grow() {
+    if (m_capacity > group::width && size() * 32 <= m_capacity * 25)
+      resize(m_capacity);
+    else
+      resize(m_capacity * 2 + 1);
+  }
+
+  void resize(size_type new_capacity) {
+    auto old_ctrl = m_ctrl;
+    auto old_slots = m_slots;
+    const auto old_capacity = m_capacity;
+    allocate(new_capacity);
+    for (size_type i = 0; i < old_capacity; i++) {
+      if (_flat_hash_table::is_full(old_ctrl[i])) {
+        const auto hash = hash_of(traits::get_key(old_slots[i]));
+        const auto target = find_first_non_full(hash);
+        set_ctrl(target, _flat_hash_table::h2(hash));
+        construct_at(slot(target), move(old_slots[i]));
+        destroy_at(old_slots + i);
+      }
+    }
+    m_growth_left -= m_size;
+    deallocate(old_ctrl, old_capacity);
+  }
+
+  // control bytes and slots live in one allocation: [ctrl bytes | sentinel | cloned bytes | padding | slots]
+  static size_type slot_offset(size_type capacity) noexcept {
+    constexpr auto align = alignof(value_type);
+    return (capacity + 1 + s_num_cloned_bytes + align - 1) & ~(align - 1);
+  }
+  static size_type alloc_size(size_type capacity) noexcept { return slot_offset(capacity) + capacity * sizeof(value_type); }
+
+  void allocate(size_type capacity) {
+    auto p = m_alloc.allocate(alloc_size(capacity));
+    m_ctrl = reinterpret_cast<ctrl_t *>(p);
+    m_slots = reinterpret_cast<value_type *>(p + slot_offset(capacity));
+    m_capacity = capacity;
+    reset_ctrl();
+  }
+
+  void deallocate(ctrl_t *ctrl, size_type capacity) noexcept {
+    if (ctrl)
+      m_alloc.deallocate(reinterpret_cast<byte *>(ctrl), alloc_size(capacity));
+  }
+
+  void reset_ctrl() noexcept {
+    memset(m_ctrl, _flat_hash_table::ctrl_empty, m_capacity + 1 + s_num_cloned_bytes);
+    m_ctrl[m_capacity] = _flat_hash_table::ctrl_sentinel;
+    m_growth_left = _flat_hash_table::capacity_to_growth(m_capacity);
+  }
+
+  void destroy_slots() noexcept {
+    if constexpr (!is_trivially_destructible_v<value_type>) {
+      for (size_type i = 0; i < m_capacity; i++) {
+        if (_flat_hash_table::is_full(m_ctrl[i]))
+          destroy_at(slot(i));
+      }
+    }
+  }
+
+  void release() noexcept {
+    destroy_slots();
+    deallocate(m_ctrl, m_capacity);
+    m_ctrl = nullptr;
+    m_slots = nullptr;
+    m_size = m_capacity = m_growth_left = 0;
+  }
+
+  ctrl_t *m_ctrl = nullptr;
+  value_type *m_slots = nullptr;
+  size_type m_size = 0;
+  size_type m_capacity = 0;
+  size_type m_growth_left = 0;
+  hasher m_hasher;
+  key_equal m_key_equal;
+  allocator<byte> m_alloc;
+};
+
+} // namespace aria
\ No newline at end of file
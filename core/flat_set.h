@@ -7,11 +7,6 @@
 
 namespace aria {
 
-struct sorted_unique_t {
-  explicit sorted_unique_t() = default;
-};
-inline constexpr sorted_unique_t sorted_unique{};
-
 template <bool IsMulti, class Key, class Compare, class KeyContainer> class flat_set_base : public iterable_mixin {
 public:
   using container_type = KeyContainer;
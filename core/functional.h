@@ -1,4 +1,5 @@
 #pragma once
+#include "allocator.h" //construct_at
 #include "unique_ptr.h"
 #include "utility.h"
 
@@ -91,6 +92,11 @@ template <> struct negate<void> {
   template <class T> constexpr T operator()(const T &a) const { return -a; }
 };
 
+//-----------------------identity-----------------------
+struct identity {
+  template <class T> constexpr T &&operator()(T &&t) const noexcept { return forward<T>(t); }
+};
+
 //-----------------------reference_wrapper, cref, cref-----------------------
 template <class T> class reference_wrapper;
 template <class T> struct is_reference_wrapper : false_type {};
@@ -198,68 +204,254 @@ constexpr decltype(auto) invoke_memptr(Pointed C::*member, Object &&object, Args
 
 } // namespace functional
 
-template <class F, class... Args> constexpr auto invoke(F &&f, Args &&...args) {
+template <class F, class... Args> constexpr decltype(auto) invoke(F &&f, Args &&...args) {
   if constexpr (is_member_pointer_v<remove_cvref_t<F>>)
     return functional::invoke_memptr(f, forward<Args>(args)...);
   else
     return forward<F>(f)(forward<Args>(args)...);
 }
 
-//-----------------------aria::function-----------------------
+//-----------------------aria::move_only_function-----------------------
+namespace _function {
+inline constexpr size_t default_buffer_size = 3 * sizeof(void *);
+
+// a function is stored as a pointer
+template <class F> using stored_type = conditional_t<is_function_v<remove_cvref_t<F>>, remove_cvref_t<F> *, remove_cvref_t<F>>;
+
+// the stored callable is called by aria::invoke, so a member pointer is callable too
+template <class T, class R, class... Args>
+concept invocable_as = requires(T &t, Args &&...args) { static_cast<R>(aria::invoke(t, forward<Args>(args)...)); };
+
+// moving a function moves the callable, so it must not throw to be stored inline
+template <class T, size_t BufferSize>
+inline constexpr bool is_stored_inline =
+    sizeof(T) <= BufferSize && alignof(T) <= alignof(max_align_t) && is_nothrow_constructible_v<T, T &&>;
+} // namespace _function
+
+// A callable which fits in BufferSize bytes is stored inline, a bigger one is allocated. operator() is dispatched
+// through a static table of function pointers per callable type, not a virtual call on a heap object.
+template <class Signature, size_t BufferSize = _function::default_buffer_size> class move_only_function;
+template <typename> class copyable_function;
+
+template <class R, class... Args, size_t BufferSize> class move_only_function<R(Args...), BufferSize> {
+public:
+  using result_type = R;
+
+  static_assert(BufferSize >= sizeof(void *));
+
+  // whether a callable of type F is stored without allocating
+  template <class F> static constexpr bool is_stored_inline = _function::is_stored_inline<_function::stored_type<F>, BufferSize>;
+
+  move_only_function() noexcept = default;
+  move_only_function(nullptr_t) noexcept {}
+
+  template <class F>
+    requires(!is_same_v<remove_cvref_t<F>, move_only_function> && _function::invocable_as<_function::stored_type<F>, R, Args...>)
+  move_only_function(F &&f) {
+    using T = _function::stored_type<F>;
+    // a function reference is never null
+    if constexpr (is_pointer_v<remove_cvref_t<F>> || is_member_pointer_v<remove_cvref_t<F>>) {
+      if (f == nullptr)
+        return;
+    }
+    if constexpr (is_stored_inline<F>)
+      construct_at(reinterpret_cast<T *>(m_buffer), forward<F>(f));
+    else
+      *reinterpret_cast<T **>(m_buffer) = new T(forward<F>(f));
+    m_ops = &s_ops<T>;
+  }
+
+  ~move_only_function() { reset(); }
+
+  move_only_function(const move_only_function &) = delete;
+  move_only_function &operator=(const move_only_function &) = delete;
+
+  move_only_function(move_only_function &&rhs) noexcept { take(rhs); }
+
+  move_only_function &operator=(move_only_function &&rhs) noexcept {
+    if (this != &rhs) {
+      reset();
+      take(rhs);
+    }
+    return *this;
+  }
+
+  move_only_function &operator=(nullptr_t) noexcept {
+    reset();
+    return *this;
+  }
+
+  template <class F> move_only_function &operator=(F &&f) {
+    move_only_function(forward<F>(f)).swap(*this);
+    return *this;
+  }
+
+  R operator()(Args... args) { return m_ops->invoke(m_buffer, forward<Args>(args)...); }
+
+  explicit operator bool() const noexcept { return m_ops != nullptr; }
+  bool operator==(nullptr_t) const noexcept { return m_ops == nullptr; }
+
+  void swap(move_only_function &rhs) noexcept {
+    move_only_function temp(move(rhs));
+    rhs = move(*this);
+    *this = move(temp);
+  }
+
+private:
+  template <typename> friend class copyable_function;
+
+  struct operations {
+    R (*invoke)(void *, Args &&...);
+    void (*relocate)(void *dst, void *src) noexcept; // moves the callable and destroys the source
+    void (*destroy)(void *) noexcept;
+  };
+
+  template <class T> static T &get(void *buffer) noexcept {
+    if constexpr (_function::is_stored_inline<T, BufferSize>)
+      return *static_cast<T *>(buffer);
+    else
+      return **static_cast<T **>(buffer);
+  }
+
+  template <class T>
+  static constexpr operations s_ops = {
+      [](void *buffer, Args &&...args) -> R { return static_cast<R>(aria::invoke(get<T>(buffer), forward<Args>(args)...)); },
+      [](void *dst, void *src) noexcept {
+        if constexpr (_function::is_stored_inline<T, BufferSize>) {
+          construct_at(static_cast<T *>(dst), move(get<T>(src)));
+          destroy_at(static_cast<T *>(src));
+        } else {
+          *static_cast<T **>(dst) = *static_cast<T **>(src);
+        }
+      },
+      [](void *buffer) noexcept {
+        if constexpr (_function::is_stored_inline<T, BufferSize>)
+          destroy_at(static_cast<T *>(buffer));
+        else
+          delete *static_cast<T **>(buffer);
+      },
+  };
 
+  // the stored callable, which must be of type T
+  template <class T> const T &target() const noexcept { return get<T>(const_cast<aria::byte *>(m_buffer)); }
+
+  void reset() noexcept {
+    if (m_ops) {
+      m_ops->destroy(m_buffer);
+      m_ops = nullptr;
+    }
+  }
+
+  void take(move_only_function &rhs) noexcept {
+    if (rhs.m_ops) {
+      rhs.m_ops->relocate(m_buffer, rhs.m_buffer);
+      m_ops = exchange(rhs.m_ops, nullptr);
+    }
+  }
+
+  alignas(max_align_t) aria::byte m_buffer[BufferSize];
+  const operations *m_ops = nullptr;
+};
+
+template <class R, class... Args, size_t BufferSize>
+void swap(move_only_function<R(Args...), BufferSize> &a, move_only_function<R(Args...), BufferSize> &b) noexcept {
+  a.swap(b);
+}
+
+//-----------------------aria::function-----------------------
+// move only as well, the callable is stored by move_only_function
 template <typename> class function {};
 
 template <class R, class... Args> class function<R(Args...)> {
 public:
   using result_type = R;
 
-  template <class F> function(F &&f) : ptr(make_unique<Callable<F>>(forward<F>(f))) {}
+  template <class F> requires(!is_same_v<remove_cvref_t<F>, function>) function(F &&f) : m_f(forward<F>(f)) {}
 
   function() noexcept = default;
   function(nullptr_t) noexcept {}
   ~function() = default;
   function(const function &) = delete;
-  function(function &&rhs) noexcept : ptr(move(rhs.ptr)) {}
+  function(function &&rhs) noexcept = default;
   function &operator=(const function &) = delete;
-  function &operator=(function &&rhs) noexcept {
-    ptr = move(rhs.ptr);
+  function &operator=(function &&rhs) noexcept = default;
+
+  function &operator=(nullptr_t) noexcept {
+    m_f = nullptr;
     return *this;
   }
 
-  function &operator=(nullptr_t) noexcept { ptr.reset(); }
-
-  template <class F> function &operator=(F &&f) {
+  template <class F> requires(!is_same_v<remove_cvref_t<F>, function>) function &operator=(F &&f) {
     function(forward<F>(f)).swap(*this);
     return *this;
   }
 
-  result_type operator()(Args... args) const { return ptr->invoke(forward<Args>(args)...); }
+  // like std::function, the callable is invoked as non-const
+  result_type operator()(Args... args) const { return m_f(forward<Args>(args)...); }
 
-  operator bool() const noexcept { return ptr; }
+  operator bool() const noexcept { return bool(m_f); }
 
-  void swap(function &rhs) noexcept { aria::swap(ptr, rhs.ptr); }
+  void swap(function &rhs) noexcept { m_f.swap(rhs.m_f); }
 
 private:
-  struct ICallable {
-  public:
-    ICallable() = default;
-    virtual ~ICallable() = default;
-    virtual R invoke(Args...) const = 0;
-  };
+  mutable move_only_function<R(Args...)> m_f;
+};
 
-  template <class T> struct Callable : public ICallable {
-    Callable(T &&at) : t(forward<T>(at)) {}
-    ~Callable() = default;
+template <class R, class... Args> void swap(function<R(Args...)> &a, function<R(Args...)> &b) noexcept { a.swap(b); }
 
-    R invoke(Args... args) const override { return t(forward<Args>(args)...); }
+//-----------------------aria::copyable_function-----------------------
+// like function, but copyable: the callable must be copyable, and is copied by a function pointer stored along with it
+template <typename> class copyable_function {};
 
-  private:
-    T t;
-  };
+template <class R, class... Args> class copyable_function<R(Args...)> {
+public:
+  using result_type = R;
+
+  template <class F> requires(!is_same_v<remove_cvref_t<F>, copyable_function> && is_copy_constructible_v<_function::stored_type<F>>)
+  copyable_function(F &&f) : m_f(forward<F>(f)), m_copy(&copy_callable<_function::stored_type<F>>) {}
 
-  unique_ptr<ICallable> ptr;
+  copyable_function() noexcept = default;
+  copyable_function(nullptr_t) noexcept {}
+  ~copyable_function() = default;
+  copyable_function(const copyable_function &rhs) : m_f(rhs.m_f ? rhs.m_copy(rhs.m_f) : callable_t()), m_copy(rhs.m_copy) {}
+  copyable_function(copyable_function &&rhs) noexcept = default;
+
+  copyable_function &operator=(const copyable_function &rhs) {
+    if (this != &rhs)
+      copyable_function(rhs).swap(*this);
+    return *this;
+  }
+
+  copyable_function &operator=(copyable_function &&rhs) noexcept = default;
+
+  copyable_function &operator=(nullptr_t) noexcept {
+    m_f = nullptr;
+    return *this;
+  }
+
+  template <class F> requires(!is_same_v<remove_cvref_t<F>, copyable_function>) copyable_function &operator=(F &&f) {
+    copyable_function(forward<F>(f)).swap(*this);
+    return *this;
+  }
+
+  result_type operator()(Args... args) const { return m_f(forward<Args>(args)...); }
+
+  operator bool() const noexcept { return bool(m_f); }
+
+  void swap(copyable_function &rhs) noexcept {
+    m_f.swap(rhs.m_f);
+    aria::swap(m_copy, rhs.m_copy);
+  }
+
+private:
+  using callable_t = move_only_function<R(Args...)>;
+
+  template <class T> static callable_t copy_callable(const callable_t &f) { return callable_t(f.template target<T>()); }
+
+  mutable callable_t m_f;
+  callable_t (*m_copy)(const callable_t &) = nullptr;
 };
 
-template <class R, class... Args> void swap(function<R(Args...)> &a, function<R(Args...)> &b) noexcept { a.swap(b); }
+template <class R, class... Args> void swap(copyable_function<R(Args...)> &a, copyable_function<R(Args...)> &b) noexcept { a.swap(b); }
 
-} // namespace aria
\ No newline at end of file
+} // namespace aria
@@ -11,27 +11,35 @@
 #include <cmath> //ceil
 
 // hash_table is used to implement unordered_set and unordered_map
+// All the nodes live in one list, and the nodes of a bucket are adjacent in it. A bucket only records its first node and its size.
+//
+// By default the table is rebuilt in one go when it grows. With incremental_rehash(true), growing only allocates the new bucket array,
+// and the old buckets are moved over a few at a time by the following inserts, so no single insert pays for the whole table.
 namespace aria {
 
 namespace _hash_table {
-template <class Key, class T> struct Traits {
+template <class Key, class T, class Allocator> struct Traits {
   using value_type = pair<const Key, T>;
   using internal_node_type = _list::node<value_type>;
-  using node_handle_type = node_handle<internal_node_type, _node_handle::map_base<Key, T>>;
+  using node_handle_type = node_handle<internal_node_type, _node_handle::map_base<Key, T>, Allocator>;
   static const auto &get_key(const value_type &val) { return val.first; }
 };
 
-template <class Key> struct Traits<Key, void> {
+template <class Key, class Allocator> struct Traits<Key, void, Allocator> {
   using value_type = Key;
   using internal_node_type = _list::node<value_type>;
-  using node_handle_type = node_handle<internal_node_type, _node_handle::set_base<Key>>;
+  using node_handle_type = node_handle<internal_node_type, _node_handle::set_base<Key>, Allocator>;
   static const auto &get_key(const value_type &val) { return val; }
 };
+template <class Key, class T> using value_type_of = conditional_t<is_void_v<T>, Key, pair<const Key, T>>;
 } // namespace _hash_table
 
-template <class Key, class T, class Hash = hash<Key>, class KeyEqual = equal_to<Key>> class hash_table : iterable_mixin {
+// Allocator only allocates the nodes, the bucket arrays use the default allocator
+template <class Key, class T, class Hash = hash<Key>, class KeyEqual = equal_to<Key>,
+          class Allocator = allocator<_hash_table::value_type_of<Key, T>>>
+class hash_table : iterable_mixin {
 public:
-  using traits = _hash_table::Traits<Key, T>;
+  using traits = _hash_table::Traits<Key, T, Allocator>;
   using key_type = Key;
   using value_type = traits::value_type;
   using mapped_type = T;
@@ -41,14 +49,16 @@ public:
   using const_reference = const value_type &;
   using hasher = Hash;
   using key_equal = KeyEqual;
-  using iterator = list<value_type>::iterator;
-  using const_iterator = list<value_type>::const_iterator;
+  using allocator_type = Allocator;
+  using iterator = list<value_type, Allocator>::iterator;
+  using const_iterator = list<value_type, Allocator>::const_iterator;
   using node_handle_type = traits::node_handle_type;
 
   hash_table() = default;
   ~hash_table() = default;
 
   explicit hash_table(size_type bucket_count) : m_buckets(bucket_count) {}
+  explicit hash_table(const Allocator &alloc) : m_list(alloc) {}
 
   hash_table(initializer_list<value_type> ilist) : m_buckets(ilist.size()) {
     for (auto &x : ilist)
@@ -60,9 +70,13 @@ public:
       insert(*first);
   }
 
+  // the buckets point into the list, so they are rebuilt rather than copied
   hash_table(const hash_table &rhs)
-      : m_max_load_factor(rhs.m_max_load_factor), m_list(rhs.m_list), m_buckets(rhs.m_buckets), m_hasher(rhs.m_hasher),
-        m_key_equal(rhs.m_key_equal) {}
+      : m_max_load_factor(rhs.m_max_load_factor), m_incremental_rehash(rhs.m_incremental_rehash), m_buckets(rhs.bucket_count()),
+        m_hasher(rhs.m_hasher), m_key_equal(rhs.m_key_equal) {
+    for (auto &x : rhs)
+      insert(x);
+  }
 
   hash_table(hash_table &&rhs) noexcept { swap(rhs); }
 
@@ -90,6 +104,7 @@ public:
 
   //--------------------  Capacity--------------------
   size_type size() const noexcept { return m_list.size(); }
+  allocator_type get_allocator() const { return m_list.get_allocator(); }
   bool empty() const noexcept { return m_list.empty(); }
 
   //--------------------  Lookup--------------------
@@ -114,6 +129,15 @@ public:
   float max_load_factor() const noexcept { return m_max_load_factor; }
   void max_load_factor(float ml) noexcept { m_max_load_factor = ml; }
 
+  bool incremental_rehash() const noexcept { return m_incremental_rehash; }
+  void incremental_rehash(bool enable) {
+    m_incremental_rehash = enable;
+    if (!enable)
+      migrate_buckets(m_old_buckets.size());
+  }
+  // true if some nodes are still in the old buckets
+  bool is_rehashing() const noexcept { return !m_old_buckets.empty(); }
+
   //--------------------Modifiers--------------------
   pair<iterator, bool> insert(const_reference value) {
     auto [bucket_ptr, insert_pos] = find_insert_position(value);
@@ -138,7 +162,7 @@ public:
   }
 
   template <class... Args> pair<iterator, bool> emplace(Args &&...args) {
-    return insert(node_handle_type(m_list.create_node(forward<Args>(args)...)));
+    return insert(node_handle_type(m_list.create_node(forward<Args>(args)...), get_allocator()));
   }
 
   iterator erase(const_iterator pos) {
@@ -157,13 +181,21 @@ public:
     return 0;
   }
 
-  void clear() noexcept { hash_table().swap(*this); }
+  void clear() noexcept {
+    m_list.clear();
+    m_buckets = {};
+    m_old_buckets = {};
+    m_migrate_pos = 0;
+  }
 
   void swap(hash_table &rhs) noexcept {
     using aria::swap;
     swap(m_max_load_factor, rhs.m_max_load_factor);
+    swap(m_incremental_rehash, rhs.m_incremental_rehash);
     swap(m_list, rhs.m_list);
     swap(m_buckets, rhs.m_buckets);
+    swap(m_old_buckets, rhs.m_old_buckets);
+    swap(m_migrate_pos, rhs.m_migrate_pos);
     swap(m_hasher, rhs.m_hasher);
     swap(m_key_equal, rhs.m_key_equal);
   }
@@ -198,9 +230,15 @@ protected:
     size_t m_size{};
   };
 
+  // the bucket which holds key now: during an incremental rehash, the old buckets before m_migrate_pos are already moved
   template <class Self> decltype(auto) get_bucket(this Self &&self, const key_type &key) {
     assert(!self.m_buckets.empty());
-    return self.m_buckets[self.bucket(key)];
+    const auto h = self.m_hasher(key);
+    if (self.is_rehashing()) {
+      if (const auto i = h % self.m_old_buckets.size(); i >= self.m_migrate_pos)
+        return self.m_old_buckets[i];
+    }
+    return self.m_buckets[h % self.m_buckets.size()];
   }
 
   const_iterator find(const bucket_type &bucket, const key_type &key) const {
@@ -213,7 +251,10 @@ protected:
   }
 
   pair<bucket_type *, iterator> find_insert_position(const_reference value) {
-    reserve(size() + 1);
+    if (m_incremental_rehash)
+      grow_incrementally();
+    else
+      reserve(size() + 1);
     const auto &key = traits::get_key(value);
     auto &bucket = get_bucket(key);
     if (auto it = find(bucket, key); it != end()) // already inserted
@@ -225,14 +266,59 @@ protected:
   void force_rehash(size_t bucket_count) {
     bucket_count = bit_ceil(bucket_count); // always power of 2
     m_buckets = vector<bucket_type>(bucket_count);
+    m_old_buckets = {};
+    m_migrate_pos = 0;
     auto input = move(m_list);
     while (!input.empty())
       insert(input.extract(input.begin()));
   }
 
+  // a growth leaves size() / max_load_factor() old buckets and at least size() inserts until the next one,
+  // so moving s_migrate_step / max_load_factor() buckets per insert finishes the migration well before that
+  void grow_incrementally() {
+    migrate_buckets(static_cast<size_type>(std::ceil(s_migrate_step / max_load_factor())));
+    const auto num_buckets = static_cast<size_type>(std::ceil((size() + 1) / max_load_factor()));
+    if (num_buckets <= m_buckets.size())
+      return;
+    if (empty()) {
+      force_rehash(num_buckets);
+      return;
+    }
+
+    // only happens if max_load_factor() was lowered during the migration
+    migrate_buckets(m_old_buckets.size());
+    m_old_buckets = move(m_buckets);
+    m_buckets = vector<bucket_type>(bit_ceil(max(num_buckets, m_old_buckets.size() * 2)));
+    m_migrate_pos = 0;
+  }
+
+  // move the nodes of the next count old buckets to the new buckets, the nodes are relinked so iterators stay valid
+  void migrate_buckets(size_type count) {
+    for (; count > 0 && is_rehashing(); --count) {
+      auto &old_bucket = m_old_buckets[m_migrate_pos++];
+      auto it = old_bucket.first();
+      for (auto n = old_bucket.size(); n > 0; --n) {
+        auto &new_bucket = m_buckets[bucket(traits::get_key(*it))];
+        auto next_it = next(it);
+        m_list.splice(new_bucket.empty() ? end() : new_bucket.first(), m_list, it);
+        new_bucket.add(it);
+        it = next_it;
+      }
+      if (m_migrate_pos == m_old_buckets.size()) {
+        m_old_buckets = {};
+        m_migrate_pos = 0;
+      }
+    }
+  }
+
+  static constexpr size_type s_migrate_step = 4;
+
   float m_max_load_factor = 1.0;
-  list<value_type> m_list;
+  bool m_incremental_rehash = false;
+  list<value_type, Allocator> m_list;
   vector<bucket_type> m_buckets;
+  vector<bucket_type> m_old_buckets;
+  size_type m_migrate_pos = 0;
   hasher m_hasher;
   key_equal m_key_equal;
 };
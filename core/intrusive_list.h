@@ -0,0 +1,205 @@
+#pragma once
+#include "cstddef.h"
+#include "iterator.h"
+#include "utility.h"
+
+// intrusive_list links objects through a list_hook member instead of allocating nodes. The list doesn't own the objects:
+// it never allocates, copies or destroys them, and an object can be unlinked in O(1) given only a reference to it.
+// An object must outlive its membership, and can be in as many intrusive containers as it has hooks.
+//
+//   struct session {
+//     int id;
+//     list_hook lru_hook;
+//   };
+//   intrusive_list<session, &session::lru_hook> lru;
+namespace aria {
+
+namespace _intrusive {
+// the object which contains the hook, Member is the pointer to the hook member of T
+template <class T, class Hook, Hook T::*Member> T *owner_of(const Hook *hook) noexcept {
+  alignas(T) static aria::byte buffer[sizeof(T)];
+  const auto offset = reinterpret_cast<const aria::byte *>(&(reinterpret_cast<T *>(buffer)->*Member)) - buffer;
+  return reinterpret_cast<T *>(const_cast<aria::byte *>(reinterpret_cast<const aria::byte *>(hook) - offset));
+}
+} // namespace _intrusive
+
+// copying an object doesn't copy its membership
+struct list_hook {
+  list_hook() noexcept = default;
+  list_hook(const list_hook &) noexcept {}
+  list_hook &operator=(const list_hook &) noexcept { return *this; }
+
+  bool is_linked() const noexcept { return next != nullptr; }
+
+  list_hook *prev = nullptr;
+  list_hook *next = nullptr;
+};
+
+template <class ListType> class intrusive_list_const_iterator {
+public:
+  using iterator_concept = bidirectional_iterator_tag;
+  using value_type = typename ListType::value_type;
+  using pointer = typename ListType::const_pointer;
+  using reference = const value_type &;
+  using difference_type = ptrdiff_t;
+  friend ListType;
+
+  intrusive_list_const_iterator() = default;
+  explicit intrusive_list_const_iterator(const list_hook *p) : ptr(p) {}
+
+  reference operator*() const noexcept { return *ListType::owner_of(ptr); }
+  pointer operator->() const noexcept { return ListType::owner_of(ptr); }
+
+  intrusive_list_const_iterator &operator++() noexcept {
+    ptr = ptr->next;
+    return *this;
+  }
+  intrusive_list_const_iterator operator++(int) noexcept {
+    auto temp = *this;
+    operator++();
+    return temp;
+  }
+  intrusive_list_const_iterator &operator--() noexcept {
+    ptr = ptr->prev;
+    return *this;
+  }
+  intrusive_list_const_iterator operator--(int) noexcept {
+    auto temp = *this;
+    operator--();
+    return temp;
+  }
+
+  bool operator==(const intrusive_list_const_iterator &rhs) const noexcept { return ptr == rhs.ptr; }
+
+protected:
+  const list_hook *ptr = nullptr;
+};
+
+// a circular list around m_head, so inserting and unlinking never branch on the ends
+template <class T, list_hook T::*Hook> class intrusive_list : public iterable_mixin {
+public:
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using value_type = T;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using pointer = value_type *;
+  using const_pointer = const value_type *;
+  using const_iterator = intrusive_list_const_iterator<intrusive_list>;
+  using iterator = mutable_iterator<const_iterator>;
+  using reverse_iterator = aria::reverse_iterator<iterator>;
+  using const_reverse_iterator = aria::reverse_iterator<const_iterator>;
+  friend const_iterator;
+
+  intrusive_list() noexcept { m_head.prev = m_head.next = &m_head; }
+  ~intrusive_list() noexcept { clear(); }
+
+  intrusive_list(const intrusive_list &) = delete;
+  intrusive_list &operator=(const intrusive_list &) = delete;
+
+  intrusive_list(intrusive_list &&rhs) noexcept : intrusive_list() { swap(rhs); }
+
+  intrusive_list &operator=(intrusive_list &&rhs) noexcept {
+    if (this != &rhs) {
+      clear();
+      swap(rhs);
+    }
+    return *this;
+  }
+
+  void push_back(reference value) noexcept { link_before(&m_head, &(value.*Hook)); }
+  void push_front(reference value) noexcept { link_before(m_head.next, &(value.*Hook)); }
+  void pop_back() noexcept { unlink(m_head.prev); }
+  void pop_front() noexcept { unlink(m_head.next); }
+
+  reference front() noexcept { return *owner_of(m_head.next); }
+  const_reference front() const noexcept { return *owner_of(m_head.next); }
+  reference back() noexcept { return *owner_of(m_head.prev); }
+  const_reference back() const noexcept { return *owner_of(m_head.prev); }
+  bool empty() const noexcept { return m_size == 0; }
+  size_type size() const noexcept { return m_size; }
+
+  auto begin() const noexcept { return const_iterator(m_head.next); }
+  auto end() const noexcept { return const_iterator(&m_head); }
+  auto begin() noexcept { return iterator(m_head.next); }
+  auto end() noexcept { return iterator(&m_head); }
+
+  // value must not be linked by this hook
+  iterator insert(const_iterator pos, reference value) noexcept {
+    auto p = &(value.*Hook);
+    link_before(get_ptr(pos), p);
+    return iterator(p);
+  }
+
+  iterator erase(const_iterator pos) noexcept {
+    auto p = get_ptr(pos);
+    auto res = p->next;
+    unlink(p);
+    return iterator(res);
+  }
+
+  // value must be in this list
+  void erase(reference value) noexcept { unlink(&(value.*Hook)); }
+
+  // moves value, which must be in this list, to pos
+  void splice(const_iterator pos, reference value) noexcept {
+    auto p = &(value.*Hook);
+    if (p == get_ptr(pos))
+      return;
+    unlink(p);
+    link_before(get_ptr(pos), p);
+  }
+
+  iterator iterator_to(reference value) noexcept { return iterator(&(value.*Hook)); }
+  const_iterator iterator_to(const_reference value) const noexcept { return const_iterator(&(value.*Hook)); }
+
+  void clear() noexcept {
+    while (!empty())
+      pop_back();
+  }
+
+  void swap(intrusive_list &rhs) noexcept {
+    using aria::swap;
+    swap(m_head.prev, rhs.m_head.prev);
+    swap(m_head.next, rhs.m_head.next);
+    swap(m_size, rhs.m_size);
+    fix_head();
+    rhs.fix_head();
+  }
+
+private:
+  static pointer owner_of(const list_hook *p) noexcept { return _intrusive::owner_of<T, list_hook, Hook>(p); }
+  static list_hook *get_ptr(const_iterator it) noexcept { return const_cast<list_hook *>(it.ptr); }
+
+  void link_before(list_hook *pos, list_hook *p) noexcept {
+    p->prev = pos->prev;
+    p->next = pos;
+    pos->prev->next = p;
+    pos->prev = p;
+    m_size++;
+  }
+
+  void unlink(list_hook *p) noexcept {
+    p->prev->next = p->next;
+    p->next->prev = p->prev;
+    p->prev = p->next = nullptr;
+    m_size--;
+  }
+
+  // the neighbours of the head still point to the head of the other list after a swap
+  void fix_head() noexcept {
+    if (m_size == 0) {
+      m_head.prev = m_head.next = &m_head;
+    } else {
+      m_head.next->prev = &m_head;
+      m_head.prev->next = &m_head;
+    }
+  }
+
+  list_hook m_head;
+  size_type m_size = 0;
+};
+
+template <class T, list_hook T::*Hook> void swap(intrusive_list<T, Hook> &a, intrusive_list<T, Hook> &b) noexcept { a.swap(b); }
+
+} // namespace aria
\ No newline at end of file
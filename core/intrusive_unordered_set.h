@@ -0,0 +1,251 @@
+#pragma once
+#include "algorithm.h"
+#include "functional.h"
+#include "intrusive_list.h"
+#include "utility.h"
+#include "vector.h"
+#include <cmath> //ceil
+
+// intrusive_unordered_set links objects through an unordered_set_hook member, like intrusive_list. Each bucket is a singly linked chain,
+// and a hook also records where it is linked from, so erasing an object is O(1) without searching its bucket.
+// Inserting doesn't allocate, except when the bucket array grows. reserve() up front makes the set allocation free.
+//
+// The lookup takes any key which Hash and KeyEqual accept, e.g. a session id for a set of sessions:
+//   struct session_hash {
+//     size_t operator()(const session &s) const { return hash<int>()(s.id); }
+//     size_t operator()(int id) const { return hash<int>()(id); }
+//   };
+namespace aria {
+
+// copying an object doesn't copy its membership
+struct unordered_set_hook {
+  unordered_set_hook() noexcept = default;
+  unordered_set_hook(const unordered_set_hook &) noexcept {}
+  unordered_set_hook &operator=(const unordered_set_hook &) noexcept { return *this; }
+
+  bool is_linked() const noexcept { return pprev != nullptr; }
+
+  unordered_set_hook *next = nullptr;
+  unordered_set_hook **pprev = nullptr; // the bucket or the next pointer of the previous hook
+  size_t hash = 0;                      // rehashing doesn't call the hasher again
+};
+
+template <class SetType> class intrusive_unordered_set_const_iterator {
+public:
+  using iterator_concept = forward_iterator_tag;
+  using value_type = typename SetType::value_type;
+  using pointer = typename SetType::const_pointer;
+  using reference = const value_type &;
+  using difference_type = ptrdiff_t;
+  using size_type = size_t;
+  friend SetType;
+
+  intrusive_unordered_set_const_iterator() = default;
+  intrusive_unordered_set_const_iterator(const SetType *s, size_type bucket, const unordered_set_hook *p) : set(s), index(bucket), ptr(p) {}
+
+  reference operator*() const noexcept { return *SetType::owner_of(ptr); }
+  pointer operator->() const noexcept { return SetType::owner_of(ptr); }
+
+  intrusive_unordered_set_const_iterator &operator++() noexcept {
+    ptr = ptr->next;
+    while (!ptr && ++index < set->bucket_count())
+      ptr = set->m_buckets[index];
+    return *this;
+  }
+
+  intrusive_unordered_set_const_iterator operator++(int) noexcept {
+    auto temp = *this;
+    operator++();
+    return temp;
+  }
+
+  bool operator==(const intrusive_unordered_set_const_iterator &rhs) const noexcept { return ptr == rhs.ptr; }
+
+protected:
+  const SetType *set = nullptr;
+  size_type index = 0;
+  const unordered_set_hook *ptr = nullptr;
+};
+
+template <class T, unordered_set_hook T::*Hook, class Hash = hash<T>, class KeyEqual = equal_to<T>> class intrusive_unordered_set {
+public:
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using key_type = T;
+  using value_type = T;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using pointer = value_type *;
+  using const_pointer = const value_type *;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using const_iterator = intrusive_unordered_set_const_iterator<intrusive_unordered_set>;
+  using iterator = mutable_iterator<const_iterator>;
+  friend const_iterator;
+
+  intrusive_unordered_set() = default;
+  explicit intrusive_unordered_set(size_type bucket_count, const Hash &hash = Hash(), const KeyEqual &equal = KeyEqual())
+      : m_buckets(bucket_count), m_hasher(hash), m_key_equal(equal) {}
+  ~intrusive_unordered_set() noexcept { clear(); }
+
+  intrusive_unordered_set(const intrusive_unordered_set &) = delete;
+  intrusive_unordered_set &operator=(const intrusive_unordered_set &) = delete;
+
+  // the hooks point into the bucket array, which is moved along with its buffer
+  intrusive_unordered_set(intrusive_unordered_set &&rhs) noexcept { swap(rhs); }
+
+  intrusive_unordered_set &operator=(intrusive_unordered_set &&rhs) noexcept {
+    if (this != &rhs) {
+      clear();
+      swap(rhs);
+    }
+    return *this;
+  }
+
+  //--------------------  Iterators--------------------
+  const_iterator begin() const noexcept {
+    for (size_type i = 0; i < bucket_count(); i++)
+      if (m_buckets[i])
+        return const_iterator(this, i, m_buckets[i]);
+    return end();
+  }
+  const_iterator end() const noexcept { return const_iterator(this, bucket_count(), nullptr); }
+  iterator begin() noexcept { return as_const(*this).begin(); }
+  iterator end() noexcept { return as_const(*this).end(); }
+
+  iterator iterator_to(reference value) noexcept { return as_const(*this).iterator_to(value); }
+  const_iterator iterator_to(const_reference value) const noexcept {
+    auto p = &(value.*Hook);
+    return const_iterator(this, p->hash % bucket_count(), p);
+  }
+
+  //--------------------  Capacity--------------------
+  size_type size() const noexcept { return m_size; }
+  bool empty() const noexcept { return m_size == 0; }
+
+  //--------------------  Lookup--------------------
+  template <class K> iterator find(const K &key) { return as_const(*this).find(key); }
+
+  template <class K> const_iterator find(const K &key) const {
+    if (empty())
+      return end();
+    const size_t h = m_hasher(key);
+    const auto index = h % bucket_count();
+    for (auto p = m_buckets[index]; p; p = p->next)
+      if (p->hash == h && m_key_equal(*owner_of(p), key))
+        return const_iterator(this, index, p);
+    return end();
+  }
+
+  template <class K> bool contains(const K &key) const { return find(key) != end(); }
+  template <class K> size_type count(const K &key) const { return contains(key) ? 1 : 0; }
+
+  //--------------------  Bucket interface--------------------
+  size_type bucket_count() const noexcept { return m_buckets.size(); }
+
+  //--------------------Hash policy--------------------
+  void rehash(size_type bucket_count) {
+    auto num_buckets = max<size_type>(bucket_count, std::ceil(size() / max_load_factor()));
+    if (num_buckets > m_buckets.size())
+      force_rehash(num_buckets);
+  }
+
+  void reserve(size_type count) { rehash(std::ceil(count / max_load_factor())); }
+  float load_factor() const noexcept { return empty() ? 1.0 : float(size()) / bucket_count(); }
+  float max_load_factor() const noexcept { return m_max_load_factor; }
+  void max_load_factor(float ml) noexcept { m_max_load_factor = ml; }
+
+  //--------------------Modifiers--------------------
+  // value must not be linked by this hook. If an equal element exists, value is not inserted
+  pair<iterator, bool> insert(reference value) {
+    if (auto it = find(value); it != end())
+      return {it, false};
+    if (size() + 1 > bucket_count() * max_load_factor())
+      rehash(max<size_type>(bucket_count() * 2, 16));
+
+    auto p = &(value.*Hook);
+    p->hash = m_hasher(value);
+    const auto index = p->hash % bucket_count();
+    link(&m_buckets[index], p);
+    m_size++;
+    return {iterator(this, index, p), true};
+  }
+
+  iterator erase(const_iterator pos) noexcept {
+    auto next_pos = next(pos);
+    unlink(const_cast<unordered_set_hook *>(pos.ptr));
+    return next_pos;
+  }
+  iterator erase(iterator pos) noexcept { return erase(const_iterator(pos)); }
+
+  // value must be in this set
+  void erase(reference value) noexcept { unlink(&(value.*Hook)); }
+
+  template <class K> size_type erase(const K &key) {
+    auto it = find(key);
+    if (it == end())
+      return 0;
+    erase(it);
+    return 1;
+  }
+
+  void clear() noexcept {
+    for (auto &bucket : m_buckets) {
+      while (bucket)
+        unlink(bucket);
+    }
+  }
+
+  void swap(intrusive_unordered_set &rhs) noexcept {
+    using aria::swap;
+    swap(m_buckets, rhs.m_buckets);
+    swap(m_size, rhs.m_size);
+    swap(m_max_load_factor, rhs.m_max_load_factor);
+    swap(m_hasher, rhs.m_hasher);
+    swap(m_key_equal, rhs.m_key_equal);
+  }
+
+private:
+  static pointer owner_of(const unordered_set_hook *p) noexcept { return _intrusive::owner_of<T, unordered_set_hook, Hook>(p); }
+
+  static void link(unordered_set_hook **pprev, unordered_set_hook *p) noexcept {
+    p->next = *pprev;
+    p->pprev = pprev;
+    if (p->next)
+      p->next->pprev = &p->next;
+    *pprev = p;
+  }
+
+  void unlink(unordered_set_hook *p) noexcept {
+    *p->pprev = p->next;
+    if (p->next)
+      p->next->pprev = p->pprev;
+    p->next = nullptr;
+    p->pprev = nullptr;
+    m_size--;
+  }
+
+  void force_rehash(size_type num_buckets) {
+    vector<unordered_set_hook *> buckets(num_buckets);
+    for (auto &bucket : m_buckets) {
+      while (auto p = bucket) {
+        bucket = p->next;
+        link(&buckets[p->hash % num_buckets], p);
+      }
+    }
+    m_buckets.swap(buckets);
+  }
+
+  vector<unordered_set_hook *> m_buckets;
+  size_type m_size = 0;
+  float m_max_load_factor = 1.0;
+  Hash m_hasher;
+  KeyEqual m_key_equal;
+};
+
+template <class T, unordered_set_hook T::*Hook, class Hash, class KeyEqual>
+void swap(intrusive_unordered_set<T, Hook, Hash, KeyEqual> &a, intrusive_unordered_set<T, Hook, Hash, KeyEqual> &b) noexcept {
+  a.swap(b);
+}
+
+} // namespace aria
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "iterator.h"
 #include "node_handle.h"
 #include "utility.h"
+#include "vector.h"
 
 namespace aria {
 namespace _list {
@@ -64,7 +65,7 @@ protected:
   const node_base_type *ptr;
 };
 
-template <class Key, class T, class Hash, class KeyEqual> class hash_table;
+template <class Key, class T, class Hash, class KeyEqual, class Allocator> class hash_table;
 
 template <class T, class Allocator = allocator<T>> class list : public iterable_mixin {
 public:
@@ -80,9 +81,10 @@ public:
   using iterator = mutable_iterator<const_iterator>;
   using reverse_iterator = reverse_iterator<iterator>;
   using const_reverse_iterator = aria::reverse_iterator<iterator>;
-  using node_handle_type = node_handle<_list::node<T>, _node_handle::set_base<T>>;
+  using node_handle_type = node_handle<_list::node<T>, _node_handle::set_base<T>, Allocator>;
 
   list() noexcept = default;
+  explicit list(const Allocator &alloc) noexcept : m_alloc(alloc) {}
   ~list() noexcept { clear(); }
 
   list(initializer_list<value_type> init) {
@@ -185,9 +187,56 @@ public:
 
   void merge(list &rhs) { merge(rhs, less()); }
 
-  template <class Compare> void sort(Compare comp) { m_first = sort(m_first, m_end, size(), comp); }
+  // stable bottom-up merge sort, the nodes are relinked and never walked to find a midpoint
+  template <class Compare> void sort(Compare comp) {
+    if (size() < 2)
+      return;
+
+    // bins[i] is a sorted run of 2^i nodes or empty, a lower bin holds later nodes
+    node_base_type *bins[64]{};
+    last()->next = nullptr;
+    for (auto p = m_first; p;) {
+      auto carry = p;
+      p = p->next;
+      carry->next = nullptr;
+      size_t i = 0;
+      for (; bins[i]; i++) {
+        carry = merge_runs(bins[i], carry, comp);
+        bins[i] = nullptr;
+      }
+      bins[i] = carry;
+    }
+
+    node_base_type *head = nullptr;
+    for (auto bin : bins) {
+      if (bin)
+        head = merge_runs(bin, head, comp);
+    }
+    relink(head);
+  }
+
   void sort() { sort(less()); }
 
+  // sorts an array of the node pointers with aria::sort and relinks the nodes in one pass.
+  // It uses O(n) extra memory and is not stable, but compares contiguous pointers instead of chasing the links of a large list.
+  template <class Compare> void sort_by_pointers(Compare comp) {
+    if (size() < 2)
+      return;
+
+    vector<node_type *> nodes;
+    nodes.reserve(size());
+    for (auto p = m_first; p != m_end; p = p->next)
+      nodes.push_back(cast(p));
+    aria::sort(nodes.begin(), nodes.end(), [&comp](const node_type *a, const node_type *b) { return comp(a->value, b->value); });
+
+    for (size_type i = 0; i + 1 < nodes.size(); i++)
+      nodes[i]->next = nodes[i + 1];
+    nodes.back()->next = nullptr;
+    relink(nodes[0]);
+  }
+
+  void sort_by_pointers() { sort_by_pointers(less()); }
+
   template <class BinaryPredicate> size_type unique(BinaryPredicate pred) {
     if (size() <= 1)
       return 0;
@@ -232,7 +281,7 @@ public:
     if (it == end())
       return {};
     auto p = extract_node(get_ptr(it));
-    return node_handle_type(cast(p));
+    return node_handle_type(cast(p), get_allocator());
   }
 
   iterator insert(const_iterator pos, node_handle_type &&nh) noexcept {
@@ -247,7 +296,7 @@ private:
   using node_type = _list::node<value_type>;
   using node_base_type = _list::node_base;
   using node_allocator_type = typename allocator_traits<Allocator>::template rebind_alloc<node_type>;
-  template <class Key, class T, class Hash, class KeyEqual> friend class hash_table;
+  template <class Key, class U, class Hash, class KeyEqual, class Alloc> friend class hash_table;
 
   node_type *cast(node_base_type *p) const noexcept { return static_cast<node_type *>(p); }
   node_type *last() const noexcept { return cast(m_end->prev); }
@@ -349,22 +398,32 @@ private:
     return fake_head.next;
   }
 
-  node_base_type *advance(node_base_type *p, size_t n) {
-    while (n--)
-      p = p->next;
-    return p;
+  // merges two sorted runs linked by next only, on a tie the node of a goes first
+  template <class Compare> static node_base_type *merge_runs(node_base_type *a, node_base_type *b, const Compare &cmp) {
+    node_base_type head{};
+    auto tail = &head;
+    while (a && b) {
+      if (cmp(static_cast<node_type *>(b)->value, static_cast<node_type *>(a)->value)) {
+        tail->next = b;
+        b = b->next;
+      } else {
+        tail->next = a;
+        a = a->next;
+      }
+      tail = tail->next;
+    }
+    tail->next = a ? a : b;
+    return head.next;
   }
 
-  template <class Compare> node_base_type *sort(node_base_type *start, node_base_type *end, size_type n, Compare cmp) {
-    if (n <= 1)
-      return start;
-
-    node_base_type fake_end1{};
-    auto mid = advance(start, n / 2);
-    auto start1 = sort(start, mid, n / 2, cmp);
-    link(mid->prev, &fake_end1);
-    auto start2 = sort(mid, end, n - (n / 2), cmp);
-    return merge(start2, end, start1, &fake_end1, cmp);
+  // restores the prev links of a chain linked by next only, which holds all the nodes
+  void relink(node_base_type *head) noexcept {
+    head->prev = nullptr;
+    m_first = head;
+    auto p = head;
+    for (; p->next; p = p->next)
+      p->next->prev = p;
+    link(p, m_end);
   }
 
   node_base_type m_end_node;
@@ -386,4 +445,8 @@ template <class T, class Alloc, class U> list<T, Alloc>::size_type erase(list<T,
 
 template <class T, class Alloc, class Pred> list<T, Alloc>::size_type erase_if(list<T, Alloc> &a, Pred pred) { return a.remove_if(pred); }
 
+namespace pmr {
+template <class T> using list = aria::list<T, polymorphic_allocator<T>>;
+}
+
 } // namespace aria
\ No newline at end of file
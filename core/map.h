@@ -4,9 +4,10 @@
 
 namespace aria {
 
-template <class Key, class T, class Compare = less<Key>> class map : public binary_search_tree<Key, T, Compare> {
+template <class Key, class T, class Compare = less<Key>, class Allocator = allocator<pair<const Key, T>>>
+class map : public binary_search_tree<Key, T, Compare, Allocator> {
 public:
-  using Base = binary_search_tree<Key, T, Compare>;
+  using Base = binary_search_tree<Key, T, Compare, Allocator>;
   using key_type = Key;
   using value_type = typename Base::value_type;
   using mapped_type = T;
@@ -15,6 +16,7 @@ public:
   using reference = value_type &;
   using const_reference = const value_type &;
   using key_compare = Compare;
+  using allocator_type = Allocator;
   using iterator = typename Base::iterator;
   using const_iterator = typename Base::const_iterator;
   using reverse_iterator = aria::reverse_iterator<iterator>;
@@ -50,9 +52,12 @@ public:
 private:
 };
 
-template <class Key, class T, class Compare> void swap(map<Key, T, Compare> &lhs, map<Key, T, Compare> &rhs) noexcept { lhs.swap(rhs); }
+template <class Key, class T, class Compare, class Alloc>
+void swap(map<Key, T, Compare, Alloc> &lhs, map<Key, T, Compare, Alloc> &rhs) noexcept {
+  lhs.swap(rhs);
+}
 
-template <class Key, class T, class Compare, class Pred> size_t erase_if(map<Key, T, Compare> &c, Pred pred) {
+template <class Key, class T, class Compare, class Alloc, class Pred> size_t erase_if(map<Key, T, Compare, Alloc> &c, Pred pred) {
   size_t old_size = c.size();
   for (auto it = begin(c); it != end(c);) {
     if (pred(*it)) {
@@ -63,4 +68,8 @@ template <class Key, class T, class Compare, class Pred> size_t erase_if(map<Key
   return old_size - c.size();
 }
 
+namespace pmr {
+template <class Key, class T, class Compare = less<Key>> using map = aria::map<Key, T, Compare, polymorphic_allocator<pair<const Key, T>>>;
+}
+
 } // namespace aria
\ No newline at end of file
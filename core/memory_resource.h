@@ -0,0 +1,401 @@
+#pragma once
+#include "algorithm.h"
+#include "allocator.h"
+#include "bit.h"
+#include "exception.h"
+#include <atomic>
+#include <mutex>
+#include <new>
+
+// https://en.cppreference.com/w/cpp/header/memory_resource
+// The containers take polymorphic_allocator through their Allocator parameter, the aliases like pmr::vector are declared
+// in the headers of the containers. Unlike std::pmr::polymorphic_allocator, it is assignable, since the containers swap their allocators.
+namespace aria {
+
+namespace pmr {
+
+//------------------------- memory_resource -------------------------//
+class memory_resource {
+public:
+  static constexpr size_t max_align = 16;
+
+  virtual ~memory_resource() = default;
+
+  [[nodiscard]] void *allocate(size_t bytes, size_t alignment = max_align) { return do_allocate(bytes, alignment); }
+  void deallocate(void *p, size_t bytes, size_t alignment = max_align) { do_deallocate(p, bytes, alignment); }
+  bool is_equal(const memory_resource &other) const noexcept { return do_is_equal(other); }
+
+private:
+  virtual void *do_allocate(size_t bytes, size_t alignment) = 0;
+  virtual void do_deallocate(void *p, size_t bytes, size_t alignment) = 0;
+  virtual bool do_is_equal(const memory_resource &other) const noexcept = 0;
+};
+
+inline bool operator==(const memory_resource &a, const memory_resource &b) noexcept { return &a == &b || a.is_equal(b); }
+
+namespace _pmr {
+class new_delete_resource_type : public memory_resource {
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      return ::operator new(bytes, std::align_val_t(alignment));
+    return ::operator new(bytes);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      return ::operator delete(p, bytes, std::align_val_t(alignment));
+    ::operator delete(p, bytes);
+  }
+
+  bool do_is_equal(const memory_resource &other) const noexcept override { return this == &other; }
+};
+
+class null_memory_resource_type : public memory_resource {
+  void *do_allocate(size_t, size_t) override { throw bad_alloc(); }
+  void do_deallocate(void *, size_t, size_t) override {}
+  bool do_is_equal(const memory_resource &other) const noexcept override { return this == &other; }
+};
+
+constexpr size_t align_up(size_t n, size_t alignment) noexcept { return (n + alignment - 1) & ~(alignment - 1); }
+} // namespace _pmr
+
+inline memory_resource *new_delete_resource() noexcept {
+  static _pmr::new_delete_resource_type resource;
+  return &resource;
+}
+
+inline memory_resource *null_memory_resource() noexcept {
+  static _pmr::null_memory_resource_type resource;
+  return &resource;
+}
+
+namespace _pmr {
+inline std::atomic<memory_resource *> &default_resource() noexcept {
+  static std::atomic<memory_resource *> resource = new_delete_resource();
+  return resource;
+}
+} // namespace _pmr
+
+inline memory_resource *get_default_resource() noexcept { return _pmr::default_resource().load(); }
+
+// return the previous default resource, nullptr means new_delete_resource()
+inline memory_resource *set_default_resource(memory_resource *r) noexcept {
+  return _pmr::default_resource().exchange(r ? r : new_delete_resource());
+}
+
+//------------------------- polymorphic_allocator -------------------------//
+template <class T> class polymorphic_allocator {
+public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+
+  template <class U> using rebind_alloc = polymorphic_allocator<U>;
+
+  polymorphic_allocator() noexcept : m_resource(get_default_resource()) {}
+  polymorphic_allocator(memory_resource *r) noexcept : m_resource(r) {}
+  template <class U> polymorphic_allocator(const polymorphic_allocator<U> &other) noexcept : m_resource(other.resource()) {}
+
+  [[nodiscard]] T *allocate(size_type n) { return static_cast<T *>(m_resource->allocate(n * sizeof(T), alignof(T))); }
+  void deallocate(T *p, size_type n) { m_resource->deallocate(p, n * sizeof(T), alignof(T)); }
+
+  memory_resource *resource() const noexcept { return m_resource; }
+  polymorphic_allocator select_on_container_copy_construction() const { return {}; }
+
+private:
+  memory_resource *m_resource;
+};
+
+template <class T1, class T2> bool operator==(const polymorphic_allocator<T1> &lhs, const polymorphic_allocator<T2> &rhs) noexcept {
+  return *lhs.resource() == *rhs.resource();
+}
+
+//------------------------- monotonic_buffer_resource -------------------------//
+// Allocation bumps a pointer, deallocation does nothing, and the memory is only given back by release() or the destructor,
+// so dropping everything allocated from it costs one call no matter how many objects there are.
+class monotonic_buffer_resource : public memory_resource {
+public:
+  monotonic_buffer_resource() noexcept : monotonic_buffer_resource(get_default_resource()) {}
+  explicit monotonic_buffer_resource(memory_resource *upstream) noexcept : m_upstream(upstream) {}
+
+  explicit monotonic_buffer_resource(size_t initial_size, memory_resource *upstream = get_default_resource()) noexcept
+      : m_upstream(upstream), m_next_size(max<size_t>(initial_size, 1)) {}
+
+  // the chunks taken from upstream start at twice the size of buffer
+  monotonic_buffer_resource(void *buffer, size_t buffer_size, memory_resource *upstream = get_default_resource()) noexcept
+      : m_upstream(upstream), m_buffer(buffer), m_buffer_size(buffer_size), m_current(static_cast<char *>(buffer)), m_space(buffer_size),
+        m_next_size(max<size_t>(buffer_size * 2, s_min_chunk_size)) {}
+
+  monotonic_buffer_resource(const monotonic_buffer_resource &) = delete;
+  monotonic_buffer_resource &operator=(const monotonic_buffer_resource &) = delete;
+
+  ~monotonic_buffer_resource() override { release(); }
+
+  void release() noexcept {
+    while (m_chunks) {
+      auto next = m_chunks->next;
+      m_upstream->deallocate(m_chunks, m_chunks->bytes, m_chunks->alignment);
+      m_chunks = next;
+    }
+    m_current = static_cast<char *>(m_buffer);
+    m_space = m_buffer_size;
+  }
+
+  memory_resource *upstream_resource() const noexcept { return m_upstream; }
+
+private:
+  struct chunk {
+    chunk *next;
+    size_t bytes;
+    size_t alignment;
+  };
+
+  static constexpr size_t s_min_chunk_size = 1024;
+  static constexpr size_t s_header_size = _pmr::align_up(sizeof(chunk), max_align);
+
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    if (auto p = allocate_from_current(bytes, alignment))
+      return p;
+
+    alignment = max(alignment, max_align);
+    const size_t chunk_size = max(m_next_size, _pmr::align_up(s_header_size, alignment) + bytes);
+    auto c = static_cast<chunk *>(m_upstream->allocate(chunk_size, alignment));
+    c->next = m_chunks;
+    c->bytes = chunk_size;
+    c->alignment = alignment;
+    m_chunks = c;
+    m_current = reinterpret_cast<char *>(c) + s_header_size;
+    m_space = chunk_size - s_header_size;
+    m_next_size = chunk_size * 2;
+    return allocate_from_current(bytes, alignment);
+  }
+
+  void do_deallocate(void *, size_t, size_t) override {}
+  bool do_is_equal(const memory_resource &other) const noexcept override { return this == &other; }
+
+  void *allocate_from_current(size_t bytes, size_t alignment) noexcept {
+    const auto address = reinterpret_cast<size_t>(m_current);
+    const auto padding = _pmr::align_up(address, alignment) - address;
+    if (!m_current || padding + bytes > m_space)
+      return nullptr;
+    auto p = m_current + padding;
+    m_current = p + bytes;
+    m_space -= padding + bytes;
+    return p;
+  }
+
+  memory_resource *m_upstream;
+  void *m_buffer = nullptr;
+  size_t m_buffer_size = 0;
+  char *m_current = nullptr;
+  size_t m_space = 0;
+  size_t m_next_size = s_min_chunk_size;
+  chunk *m_chunks = nullptr;
+};
+
+//------------------------- pool resources -------------------------//
+struct pool_options {
+  size_t max_blocks_per_chunk = 0;
+  size_t largest_required_pool_block = 0;
+};
+
+namespace _pmr {
+// free list of blocks of one size, the chunks come from upstream and double in size until max_blocks_per_chunk
+class pool {
+public:
+  void init(size_t block_size) noexcept { m_block_size = block_size; }
+  size_t block_size() const noexcept { return m_block_size; }
+
+  void *allocate(memory_resource *upstream, size_t max_blocks_per_chunk) {
+    if (!m_free)
+      add_chunk(upstream, max_blocks_per_chunk);
+    auto p = m_free;
+    m_free = p->next;
+    return p;
+  }
+
+  void deallocate(void *p) noexcept {
+    auto b = static_cast<block *>(p);
+    b->next = m_free;
+    m_free = b;
+  }
+
+  void release(memory_resource *upstream) noexcept {
+    while (m_chunks) {
+      auto next = m_chunks->next;
+      upstream->deallocate(m_chunks, m_chunks->bytes, memory_resource::max_align);
+      m_chunks = next;
+    }
+    m_free = nullptr;
+    m_blocks_per_chunk = 1;
+  }
+
+private:
+  struct block {
+    block *next;
+  };
+
+  struct chunk {
+    chunk *next;
+    size_t bytes;
+  };
+
+  static constexpr size_t s_header_size = align_up(sizeof(chunk), memory_resource::max_align);
+
+  void add_chunk(memory_resource *upstream, size_t max_blocks_per_chunk) {
+    const size_t bytes = s_header_size + m_blocks_per_chunk * m_block_size;
+    auto c = static_cast<chunk *>(upstream->allocate(bytes, memory_resource::max_align));
+    c->next = m_chunks;
+    c->bytes = bytes;
+    m_chunks = c;
+    auto first = reinterpret_cast<char *>(c) + s_header_size;
+    for (size_t i = m_blocks_per_chunk; i > 0; i--)
+      deallocate(first + (i - 1) * m_block_size);
+    m_blocks_per_chunk = min(m_blocks_per_chunk * 2, max_blocks_per_chunk);
+  }
+
+  size_t m_block_size = 0;
+  size_t m_blocks_per_chunk = 1;
+  block *m_free = nullptr;
+  chunk *m_chunks = nullptr;
+};
+} // namespace _pmr
+
+// Blocks up to largest_required_pool_block come from pools of power of two sizes, larger or over-aligned ones come from
+// upstream directly. Not thread safe, see synchronized_pool_resource.
+class unsynchronized_pool_resource : public memory_resource {
+public:
+  unsynchronized_pool_resource() : unsynchronized_pool_resource(pool_options(), get_default_resource()) {}
+  explicit unsynchronized_pool_resource(memory_resource *upstream) : unsynchronized_pool_resource(pool_options(), upstream) {}
+  explicit unsynchronized_pool_resource(const pool_options &opts) : unsynchronized_pool_resource(opts, get_default_resource()) {}
+
+  unsynchronized_pool_resource(const pool_options &opts, memory_resource *upstream) : m_upstream(upstream), m_options(opts) {
+    if (m_options.max_blocks_per_chunk == 0 || m_options.max_blocks_per_chunk > s_max_blocks_per_chunk)
+      m_options.max_blocks_per_chunk = s_max_blocks_per_chunk;
+    if (m_options.largest_required_pool_block == 0)
+      m_options.largest_required_pool_block = s_default_largest_block;
+    m_options.largest_required_pool_block = bit_ceil(
+        min(max(m_options.largest_required_pool_block, s_smallest_block), s_smallest_block << (s_max_pools - 1)));
+    m_num_pools = countr_zero(m_options.largest_required_pool_block / s_smallest_block) + 1;
+    for (size_t i = 0; i < m_num_pools; i++)
+      m_pools[i].init(s_smallest_block << i);
+  }
+
+  unsynchronized_pool_resource(const unsynchronized_pool_resource &) = delete;
+  unsynchronized_pool_resource &operator=(const unsynchronized_pool_resource &) = delete;
+
+  ~unsynchronized_pool_resource() override { release(); }
+
+  void release() noexcept {
+    for (size_t i = 0; i < m_num_pools; i++)
+      m_pools[i].release(m_upstream);
+    while (m_large) {
+      auto next = m_large->next;
+      m_upstream->deallocate(reinterpret_cast<char *>(m_large) + sizeof(large_header) - m_large->offset, m_large->bytes,
+                             m_large->alignment);
+      m_large = next;
+    }
+  }
+
+  memory_resource *upstream_resource() const noexcept { return m_upstream; }
+  pool_options options() const noexcept { return m_options; }
+
+private:
+  // put right before a block which comes from upstream directly, the blocks are linked so release() can free them
+  struct large_header {
+    large_header *prev;
+    large_header *next;
+    size_t bytes;
+    size_t alignment;
+    size_t offset;
+  };
+
+  static constexpr size_t s_smallest_block = 16;
+  static constexpr size_t s_max_pools = 16;
+  static constexpr size_t s_default_largest_block = 4096;
+  static constexpr size_t s_max_blocks_per_chunk = 1024 * 1024;
+
+  _pmr::pool *find_pool(size_t bytes, size_t alignment) noexcept {
+    if (bytes > m_options.largest_required_pool_block || alignment > max_align)
+      return nullptr;
+    const auto block_size = bit_ceil(max(bytes, s_smallest_block));
+    return &m_pools[countr_zero(block_size / s_smallest_block)];
+  }
+
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    if (auto pool = find_pool(bytes, alignment))
+      return pool->allocate(m_upstream, m_options.max_blocks_per_chunk);
+
+    alignment = max(alignment, alignof(large_header));
+    const auto offset = _pmr::align_up(sizeof(large_header), alignment);
+    auto base = static_cast<char *>(m_upstream->allocate(offset + bytes, alignment));
+    auto header = reinterpret_cast<large_header *>(base + offset - sizeof(large_header));
+    *header = {nullptr, m_large, offset + bytes, alignment, offset};
+    if (m_large)
+      m_large->prev = header;
+    m_large = header;
+    return base + offset;
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    if (auto pool = find_pool(bytes, alignment))
+      return pool->deallocate(p);
+
+    auto header = reinterpret_cast<large_header *>(static_cast<char *>(p) - sizeof(large_header));
+    if (header->prev)
+      header->prev->next = header->next;
+    else
+      m_large = header->next;
+    if (header->next)
+      header->next->prev = header->prev;
+    m_upstream->deallocate(static_cast<char *>(p) - header->offset, header->bytes, header->alignment);
+  }
+
+  bool do_is_equal(const memory_resource &other) const noexcept override { return this == &other; }
+
+  memory_resource *m_upstream;
+  pool_options m_options;
+  _pmr::pool m_pools[s_max_pools];
+  size_t m_num_pools = 0;
+  large_header *m_large = nullptr;
+};
+
+// unsynchronized_pool_resource behind a mutex
+class synchronized_pool_resource : public memory_resource {
+public:
+  synchronized_pool_resource() = default;
+  explicit synchronized_pool_resource(memory_resource *upstream) : m_resource(upstream) {}
+  explicit synchronized_pool_resource(const pool_options &opts) : m_resource(opts) {}
+  synchronized_pool_resource(const pool_options &opts, memory_resource *upstream) : m_resource(opts, upstream) {}
+
+  synchronized_pool_resource(const synchronized_pool_resource &) = delete;
+  synchronized_pool_resource &operator=(const synchronized_pool_resource &) = delete;
+
+  void release() {
+    std::lock_guard lock(m_mutex);
+    m_resource.release();
+  }
+
+  memory_resource *upstream_resource() const noexcept { return m_resource.upstream_resource(); }
+  pool_options options() const noexcept { return m_resource.options(); }
+
+private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    std::lock_guard lock(m_mutex);
+    return m_resource.allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    std::lock_guard lock(m_mutex);
+    m_resource.deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const memory_resource &other) const noexcept override { return this == &other; }
+
+  std::mutex m_mutex;
+  unsynchronized_pool_resource m_resource;
+};
+
+} // namespace pmr
+
+} // namespace aria
\ No newline at end of file
@@ -21,6 +21,7 @@ public:
   using const_pointer = const value_type *;
   using reference = value_type &;
   using const_reference = const value_type &;
+  using allocator_type = Allocator;
   using iterator = array_iterator<CharT>;
   using const_iterator = basic_const_iterator<iterator>;
   using reverse_iterator = aria::reverse_iterator<iterator>;
@@ -28,10 +29,12 @@ public:
   static constexpr size_type npos = -1;
 
   basic_string() = default;
+  explicit basic_string(const Allocator &alloc) noexcept : m_alloc(alloc) {}
   ~basic_string() noexcept { reset(); }
 
   basic_string(const_pointer str) : basic_string(str, strlen(str)) {}
-  basic_string(const basic_string &rhs) : basic_string(rhs.m_ptr, rhs.size(), rhs.capacity()) {}
+  basic_string(const_pointer str, const Allocator &alloc) : m_alloc(alloc) { append(str, strlen(str)); }
+  basic_string(const basic_string &rhs) : basic_string(rhs.data(), rhs.size(), rhs.capacity()) {}
 
   basic_string(basic_string &&rhs) noexcept { swap(rhs); }
 
@@ -53,25 +56,18 @@ public:
 
   void swap(basic_string &rhs) noexcept {
     using aria::swap;
-
-    const bool lhs_on_stack = on_stack(), rhs_on_stack = rhs.on_stack();
     swap(m_small_str, rhs.m_small_str);
     swap(m_alloc, rhs.m_alloc);
     swap(m_ptr, rhs.m_ptr);
     swap(m_size, rhs.m_size);
     swap(m_capacity, rhs.m_capacity);
-    if (lhs_on_stack) {
-      rhs.m_ptr = rhs.m_small_str;
-    }
-    if (rhs_on_stack) {
-      m_ptr = m_small_str;
-    }
   }
 
   size_type size() const noexcept { return m_size; }
   size_type length() const noexcept { return size(); }
   size_type capacity() const noexcept { return (m_capacity == 0) ? 0 : m_capacity - 1; }
   bool empty() const noexcept { return size() == 0; }
+  allocator_type get_allocator() const { return m_alloc; }
   reference back() noexcept { return *get(size() - 1); }
   const_reference back() const noexcept { return *get(size() - 1); }
   reference operator[](size_type i) { return *get(i); }
@@ -79,9 +75,9 @@ public:
   void clear() noexcept { set_size(0); }
   void pop_back() { add_size(-1); }
   void push_back(CharT ch) { operator+=(ch); }
-  const CharT *data() const noexcept { return m_ptr; }
-  CharT *data() noexcept { return m_ptr; }
-  const CharT *c_str() const noexcept { return m_ptr; }
+  const CharT *data() const noexcept { return on_stack() ? m_small_str : m_ptr; }
+  CharT *data() noexcept { return on_stack() ? m_small_str : m_ptr; }
+  const CharT *c_str() const noexcept { return data(); }
 
   auto begin() const noexcept { return const_iterator(get(0)); }
   auto end() const noexcept { return const_iterator(get(size())); }
@@ -92,7 +88,7 @@ public:
     if (new_cap <= m_capacity)
       return;
     auto new_ptr = m_alloc.allocate(new_cap);
-    memcpy(new_ptr, m_ptr, (size() + 1) * sizeof(value_type));
+    memcpy(new_ptr, data(), (size() + 1) * sizeof(value_type));
     if (!on_stack())
       m_alloc.deallocate(m_ptr, m_capacity);
     m_capacity = new_cap;
@@ -110,7 +106,7 @@ public:
       throw out_of_range("basic_string::substr pos >= size()");
 
     count = min(count, size() - pos);
-    return basic_string(m_ptr + pos, count, count);
+    return basic_string(data() + pos, count, count);
   }
 
   basic_string &operator+=(CharT ch) {
@@ -120,26 +116,26 @@ public:
     return *this;
   }
 
-  basic_string &operator+=(const basic_string &rhs) { return append(rhs.m_ptr, rhs.size()); }
+  basic_string &operator+=(const basic_string &rhs) { return append(rhs.data(), rhs.size()); }
   basic_string &operator+=(const_pointer rhs) { return append(rhs, strlen(rhs)); }
 
   size_type find(const basic_string &str, size_type pos = 0) const {
     if (pos + str.size() > size())
       return npos;
     const auto ptr = strstr(data() + pos, str.data());
-    return ptr ? (ptr - m_ptr) : npos;
+    return ptr ? (ptr - data()) : npos;
   }
 
   size_type find(const CharT *s, size_type pos = 0) const {
     if (pos + strlen(s) > size())
       return npos;
     const auto ptr = strstr(data() + pos, s);
-    return ptr ? (ptr - m_ptr) : npos;
+    return ptr ? (ptr - data()) : npos;
   }
 
 private:
-  pointer get(size_type i) { return m_ptr + i; }
-  const pointer get(size_type i) const { return m_ptr + i; }
+  pointer get(size_type i) { return data() + i; }
+  const_pointer get(size_type i) const { return data() + i; }
 
   basic_string(const_pointer str, size_type size, size_type cap = 0) {
     cap = max(cap, size + 1);
@@ -150,7 +146,7 @@ private:
 
   basic_string &append(const_pointer rhs, size_t added_size) {
     reserve_more(added_size);
-    memcpy(m_ptr + size(), rhs, added_size * sizeof(value_type));
+    memcpy(data() + size(), rhs, added_size * sizeof(value_type));
     add_size(added_size);
     return *this;
   }
@@ -159,14 +155,14 @@ private:
     if (!on_stack()) {
       m_alloc.deallocate(m_ptr, m_capacity);
     }
-    m_ptr = m_small_str;
-    set_size(0);
+    m_ptr = nullptr;
     m_capacity = s_stack_cap;
+    set_size(0);
   }
 
   void copy(const_pointer src, size_type size) {
     if (src) {
-      memcpy(m_ptr, src, size * sizeof(value_type));
+      memcpy(data(), src, size * sizeof(value_type));
       set_size(size);
     }
   }
@@ -188,17 +184,25 @@ private:
 
   void add_null_teminate() noexcept { *get(size()) = value_type(0); }
 
-  bool on_stack() const noexcept { return m_ptr == m_small_str; }
+  // a heap buffer is always larger than the small buffer
+  bool on_stack() const noexcept { return m_capacity == s_stack_cap; }
 
   static constexpr size_t s_stack_cap = 16;
   value_type m_small_str[s_stack_cap]{};
-  pointer m_ptr = m_small_str;
+  pointer m_ptr = nullptr; // not pointing to m_small_str, so that the string is trivially relocatable
   size_type m_size = 0;
   size_type m_capacity = s_stack_cap;
   Allocator m_alloc;
 };
 
+template <class CharT, class Alloc> struct is_trivially_relocatable<basic_string<CharT, Alloc>> : is_trivially_relocatable<Alloc> {};
+
+using string = basic_string<char>;
+
+namespace pmr {
+template <class CharT> using basic_string = aria::basic_string<CharT, polymorphic_allocator<CharT>>;
 using string = basic_string<char>;
+} // namespace pmr
 
 template <class CharT, class Alloc> void swap(basic_string<CharT, Alloc> &a, basic_string<CharT, Alloc> &b) noexcept { a.swap(b); }
 
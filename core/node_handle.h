@@ -1,4 +1,5 @@
 #pragma once
+#include "allocator.h"
 #include "concepts.h"
 #include "utility.h"
 
@@ -25,37 +26,49 @@ template <class T> concept base = is_specialization_of_v<T, set_base> || is_spec
 
 } // namespace _node_handle
 
-template <_node_handle::node Node, _node_handle::base Base> class node_handle : public Base {
+// Allocator is the allocator of the container, the node is destroyed and deallocated with it rebound to Node
+template <_node_handle::node Node, _node_handle::base Base, class Allocator = allocator<Node>> class node_handle : public Base {
 public:
   using pointer = Node *;
+  using allocator_type = Allocator;
 
   node_handle() = default;
-  explicit node_handle(pointer const p) : ptr(p) {}
+  explicit node_handle(pointer const p, const Allocator &alloc = Allocator()) : ptr(p), m_alloc(alloc) {}
 
   virtual ~node_handle() {
-    if (ptr)
-      delete (ptr); // todo use allocator
+    if (ptr) {
+      destroy_at(ptr);
+      m_alloc.deallocate(ptr, 1);
+    }
   }
 
   node_handle(const node_handle &) = delete;
   node_handle(node_handle &&rhs) noexcept { swap(rhs); }
   node_handle &operator=(const node_handle &) = delete;
-  node_handle &operator=(const node_handle &&rhs) noexcept {
+  node_handle &operator=(node_handle &&rhs) noexcept {
     node_handle(move(rhs)).swap(*this);
     return *this;
   }
 
-  template <_node_handle::base Base2> requires(not_same<Base2, Base>) node_handle(node_handle<Node, Base2> &&rhs) : ptr(rhs.release()) {}
+  template <_node_handle::base Base2> requires(not_same<Base2, Base>)
+  node_handle(node_handle<Node, Base2, Allocator> &&rhs) : ptr(rhs.release()), m_alloc(rhs.get_allocator()) {}
 
   bool empty() const noexcept { return ptr; }
   explicit operator bool() const noexcept { return ptr; }
-  void swap(node_handle &rhs) noexcept { aria::swap(ptr, rhs.ptr); }
+  allocator_type get_allocator() const { return m_alloc; }
+  void swap(node_handle &rhs) noexcept {
+    aria::swap(ptr, rhs.ptr);
+    aria::swap(m_alloc, rhs.m_alloc);
+  }
   pointer release() noexcept { return exchange(ptr, nullptr); }
   pointer get() const noexcept { return ptr; }
   pointer operator->() const noexcept { return ptr; }
 
 private:
+  using node_allocator_type = typename allocator_traits<Allocator>::template rebind_alloc<Node>;
+
   pointer ptr{};
+  node_allocator_type m_alloc;
 };
 
 } // namespace aria
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
-#include "utility.h" //aria::move
+#include "functional.h" //aria::plus
+#include "iterator.h"
+#include "utility.h"   //aria::move
 
 namespace aria {
 
@@ -41,19 +43,63 @@ template <class ForwardIt, class T> constexpr void iota(ForwardIt first, Forward
   }
 }
 
-template <class InputIt, class T> constexpr T reduce(InputIt first, InputIt last, T init) {
+template <input_iterator InputIt, class T> constexpr T reduce(InputIt first, InputIt last, T init) {
   for (; first != last; ++first)
     init = move(init) + *first;
   return init;
 }
 
-template <class InputIt> constexpr auto reduce(InputIt first, InputIt last) { return reduce(first, last, typename InputIt::value_type{}); }
+template <input_iterator InputIt> constexpr auto reduce(InputIt first, InputIt last) {
+  return reduce(first, last, typename InputIt::value_type{});
+}
 
-template <class InputIt, class T, class BinaryOp> constexpr T reduce(InputIt first, InputIt last, T init, BinaryOp op) {
+template <input_iterator InputIt, class T, class BinaryOp> constexpr T reduce(InputIt first, InputIt last, T init, BinaryOp op) {
   for (; first != last; ++first)
     init = op(move(init), *first);
 
   return init;
 }
 
+template <input_iterator InputIt, class T, class BinaryReduceOp, class UnaryTransformOp>
+constexpr T transform_reduce(InputIt first, InputIt last, T init, BinaryReduceOp reduce, UnaryTransformOp transform) {
+  for (; first != last; ++first)
+    init = reduce(move(init), transform(*first));
+  return init;
+}
+
+template <input_iterator InputIt1, input_iterator InputIt2, class T, class BinaryReduceOp, class BinaryTransformOp>
+constexpr T transform_reduce(InputIt1 first1, InputIt1 last1, InputIt2 first2, T init, BinaryReduceOp reduce, BinaryTransformOp transform) {
+  for (; first1 != last1; ++first1, ++first2)
+    init = reduce(move(init), transform(*first1, *first2));
+  return init;
+}
+
+// the inner product
+template <input_iterator InputIt1, input_iterator InputIt2, class T>
+constexpr T transform_reduce(InputIt1 first1, InputIt1 last1, InputIt2 first2, T init) {
+  return transform_reduce(first1, last1, first2, move(init), plus{}, multiplies{});
+}
+
+template <input_iterator InputIt, class OutputIt, class BinaryOp, class T>
+constexpr OutputIt inclusive_scan(InputIt first, InputIt last, OutputIt d_first, BinaryOp op, T init) {
+  for (; first != last; ++first, ++d_first) {
+    init = op(move(init), *first);
+    *d_first = init;
+  }
+  return d_first;
+}
+
+template <input_iterator InputIt, class OutputIt, class BinaryOp>
+constexpr OutputIt inclusive_scan(InputIt first, InputIt last, OutputIt d_first, BinaryOp op) {
+  if (first == last)
+    return d_first;
+  iter_value_t<InputIt> init = *first;
+  *d_first = init;
+  return inclusive_scan(++first, last, ++d_first, op, move(init));
+}
+
+template <input_iterator InputIt, class OutputIt> constexpr OutputIt inclusive_scan(InputIt first, InputIt last, OutputIt d_first) {
+  return inclusive_scan(first, last, d_first, plus{});
+}
+
 } // namespace aria
\ No newline at end of file
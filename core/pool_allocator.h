@@ -0,0 +1,231 @@
+#pragma once
+#include "algorithm.h"
+#include "allocator.h"
+#include "utility.h"
+#include <mutex>
+#include <new> //align_val_t
+
+// pool_allocator hands out single objects from free lists of fixed size blocks, the blocks are carved out of large slabs.
+// It is meant for node based containers (list, map, set, unordered_map ...), which allocate one node at a time:
+// a node allocation becomes popping a free list, and nodes allocated together are adjacent in memory.
+//
+// The sizes are rounded up to multiples of 16 bytes, and every size class has one pool per thread, so no locking is needed.
+// A block may be deallocated by another thread, then it joins the free list of that thread. So a free list can hold
+// blocks of any thread's slabs, and the slabs are never released. The free blocks of an exiting thread, and the surplus
+// of a thread which frees more blocks than it allocates, go to a depot shared by the threads, where the pools refill from.
+// Once the pool of a thread is destroyed, e.g. when a static container is destroyed after the thread_locals of the main
+// thread, that thread allocates from and frees to the depot directly.
+// Arrays (n > 1), blocks larger than s_max_block_size and over-aligned types go to operator new directly.
+namespace aria {
+
+namespace _pool_allocator {
+
+inline constexpr size_t s_granularity = 16;
+inline constexpr size_t s_max_block_size = 512;
+inline constexpr size_t s_min_blocks_per_slab = 16;
+inline constexpr size_t s_max_blocks_per_slab = 4096;
+inline constexpr size_t s_max_free_blocks = 2 * s_max_blocks_per_slab;
+
+constexpr size_t block_size_of(size_t size) noexcept { return (size + s_granularity - 1) / s_granularity * s_granularity; }
+
+struct block {
+  block *next;
+};
+
+// free blocks of one size shared by the threads, handed over in whole lists
+class depot {
+public:
+  void push(block *first, block *last, size_t count) {
+    std::lock_guard lock(m_mutex);
+    last->next = m_free;
+    m_free = first;
+    m_count += count;
+  }
+
+  // returns the whole list and its length
+  pair<block *, size_t> take() {
+    std::lock_guard lock(m_mutex);
+    return {exchange(m_free, nullptr), exchange(m_count, 0)};
+  }
+
+  // returns one block, or null if there is none
+  block *take_one() {
+    std::lock_guard lock(m_mutex);
+    auto b = m_free;
+    if (b) {
+      m_free = b->next;
+      --m_count;
+    }
+    return b;
+  }
+
+private:
+  std::mutex m_mutex;
+  block *m_free = nullptr;
+  size_t m_count = 0;
+};
+
+// never destroyed, so the pools can return their blocks whatever the order of the thread_local and static destructors
+template <size_t BlockSize> depot &shared_depot() {
+  static auto d = new depot;
+  return *d;
+}
+
+// blocks of one size, the slabs double in size until s_max_blocks_per_slab
+class fixed_pool {
+public:
+  fixed_pool(size_t block_size, depot &d) noexcept : m_block_size(block_size), m_depot(d) {}
+  fixed_pool(const fixed_pool &) = delete;
+  fixed_pool &operator=(const fixed_pool &) = delete;
+
+  ~fixed_pool() {
+    if (m_free)
+      give_away(m_free, m_free_count);
+  }
+
+  [[nodiscard]] void *allocate() {
+    if (!m_free)
+      refill();
+    auto p = m_free;
+    m_free = p->next;
+    --m_free_count;
+    ++m_in_use;
+    return p;
+  }
+
+  void deallocate(void *p) noexcept {
+    auto b = static_cast<block *>(p);
+    b->next = m_free;
+    m_free = b;
+    --m_in_use;
+    if (++m_free_count > s_max_free_blocks)
+      trim();
+  }
+
+  size_t block_size() const noexcept { return m_block_size; }
+  // the blocks allocated minus the blocks deallocated by this thread, negative if it frees the blocks of other threads
+  ptrdiff_t in_use() const noexcept { return m_in_use; }
+
+private:
+  void refill() {
+    auto [free, count] = m_depot.take();
+    m_free = free;
+    m_free_count = count;
+    if (!m_free)
+      add_slab();
+  }
+
+  void add_slab() {
+    auto first = static_cast<char *>(::operator new(m_blocks_per_slab * m_block_size));
+
+    // the blocks are linked in address order, so consecutive allocations are adjacent
+    for (size_t i = m_blocks_per_slab; i > 0; i--) {
+      auto b = reinterpret_cast<block *>(first + (i - 1) * m_block_size);
+      b->next = m_free;
+      m_free = b;
+    }
+    m_free_count += m_blocks_per_slab;
+    m_blocks_per_slab = min(m_blocks_per_slab * 2, s_max_blocks_per_slab);
+  }
+
+  // keep the s_max_blocks_per_slab most recently freed blocks, and give the rest to the depot
+  void trim() {
+    auto last_kept = m_free;
+    for (size_t i = 1; i < s_max_blocks_per_slab; i++)
+      last_kept = last_kept->next;
+    give_away(last_kept->next, m_free_count - s_max_blocks_per_slab);
+    last_kept->next = nullptr;
+    m_free_count = s_max_blocks_per_slab;
+  }
+
+  void give_away(block *first, size_t count) {
+    auto last = first;
+    while (last->next)
+      last = last->next;
+    m_depot.push(first, last, count);
+  }
+
+  size_t m_block_size;
+  depot &m_depot;
+  size_t m_blocks_per_slab = s_min_blocks_per_slab;
+  block *m_free = nullptr;
+  size_t m_free_count = 0;
+  ptrdiff_t m_in_use = 0;
+};
+
+// set when the pool of the thread is destroyed, it is trivially destructible so it can be read until the thread ends
+template <size_t BlockSize> inline thread_local bool t_pool_destroyed = false;
+
+// the pool of the calling thread, null once it is destroyed
+template <size_t BlockSize> fixed_pool *local_pool() {
+  struct thread_pool : fixed_pool {
+    thread_pool() : fixed_pool(BlockSize, shared_depot<BlockSize>()) {}
+    ~thread_pool() { t_pool_destroyed<BlockSize> = true; }
+  };
+  if (t_pool_destroyed<BlockSize>)
+    return nullptr;
+  thread_local thread_pool pool;
+  return &pool;
+}
+
+template <size_t BlockSize> void *allocate_block() {
+  if (auto pool = local_pool<BlockSize>())
+    return pool->allocate();
+  // a block from operator new is never released, it joins the free lists like the blocks of the slabs
+  if (auto b = shared_depot<BlockSize>().take_one())
+    return b;
+  return ::operator new(BlockSize);
+}
+
+template <size_t BlockSize> void deallocate_block(void *p) noexcept {
+  if (auto pool = local_pool<BlockSize>())
+    return pool->deallocate(p);
+  auto b = static_cast<block *>(p);
+  shared_depot<BlockSize>().push(b, b, 1);
+}
+
+} // namespace _pool_allocator
+
+template <allocatable T> struct pool_allocator {
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using propagate_on_container_move_assignment = true_type;
+  using is_always_equal = true_type;
+
+  template <allocatable U> using rebind_alloc = pool_allocator<U>;
+
+  static constexpr size_t s_block_size = _pool_allocator::block_size_of(sizeof(T));
+  static constexpr bool s_pooled = s_block_size <= _pool_allocator::s_max_block_size && alignof(T) <= _pool_allocator::s_granularity;
+  static constexpr bool s_over_aligned = alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+  constexpr pool_allocator() noexcept = default;
+  template <class U> constexpr pool_allocator(const pool_allocator<U> &) noexcept {}
+
+  [[nodiscard]] T *allocate(size_type n) {
+    if constexpr (s_pooled) {
+      if (n == 1)
+        return static_cast<T *>(_pool_allocator::allocate_block<s_block_size>());
+    }
+    if constexpr (s_over_aligned)
+      return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    else
+      return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T *p, size_type n) noexcept {
+    if constexpr (s_pooled) {
+      if (n == 1)
+        return _pool_allocator::deallocate_block<s_block_size>(p);
+    }
+    if constexpr (s_over_aligned)
+      ::operator delete(p, n * sizeof(T), std::align_val_t(alignof(T)));
+    else
+      ::operator delete(p, n * sizeof(T));
+  }
+
+};
+
+template <class T1, class T2> constexpr bool operator==(const pool_allocator<T1> &, const pool_allocator<T2> &) noexcept { return true; }
+
+} // namespace aria
\ No newline at end of file
@@ -18,7 +18,9 @@ public:
   explicit priority_queue(const Compare &compare) : m_cmp(compare) {}
 
   template <input_iterator It>
-  priority_queue(It first, It last, const Compare &compare = Compare()) : m_cmp(compare), m_data(first, last) {}
+  priority_queue(It first, It last, const Compare &compare = Compare()) : m_data(first, last), m_cmp(compare) {
+    make_heap(begin(m_data), end(m_data), m_cmp);
+  }
 
   template <class... Args> void emplace(Args &&...args) {
     m_data.emplace_back(forward<Args>(args)...);
@@ -32,7 +34,7 @@ public:
   size_type size() const { return m_data.size(); }
 
   void pop() {
-    pop_heap(begin(m_data), end(m_data));
+    pop_heap(begin(m_data), end(m_data), m_cmp);
     m_data.pop_back();
   }
 
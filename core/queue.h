@@ -14,7 +14,12 @@ public:
   queue() = default;
 
   void push(const_reference val) { m_container.push_back(val); }
+  void push(value_type &&val) { m_container.push_back(move(val)); }
+  template <class... Args> decltype(auto) emplace(Args &&...args) { return m_container.emplace_back(forward<Args>(args)...); }
+  template <ranges::range R> void push_range(R &&rg) { m_container.append_range(forward<R>(rg)); }
   void pop() { m_container.pop_front(); }
+  // moves at most n elements from the front to out
+  template <class OutputIt> OutputIt pop_n(size_type n, OutputIt out) { return m_container.pop_front_n(n, out); }
   reference front() { return m_container.front(); }
   const_reference front() const { return m_container.front(); }
   reference back() { return m_container.back(); }
@@ -3,9 +3,10 @@
 
 namespace aria {
 
-template <class Key, class Compare = less<Key>> class set : public binary_search_tree<Key, void, Compare> {
+template <class Key, class Compare = less<Key>, class Allocator = allocator<Key>>
+class set : public binary_search_tree<Key, void, Compare, Allocator> {
 public:
-  using Base = binary_search_tree<Key, void, Compare>;
+  using Base = binary_search_tree<Key, void, Compare, Allocator>;
   using key_type = Key;
   using value_type = Key;
   using pointer = value_type *;
@@ -15,6 +16,7 @@ public:
   using const_reference = const value_type &;
   using key_compare = Compare;
   using value_compare = Compare;
+  using allocator_type = Allocator;
   using iterator = typename Base::iterator;
   using const_iterator = typename Base::const_iterator;
   using reverse_iterator = aria::reverse_iterator<iterator>;
@@ -23,9 +25,11 @@ public:
   using Base::Base;
 };
 
-template <class Key, class Compare> void swap(set<Key, Compare> &lhs, set<Key, Compare> &rhs) noexcept { lhs.swap(rhs); }
+template <class Key, class Compare, class Alloc> void swap(set<Key, Compare, Alloc> &lhs, set<Key, Compare, Alloc> &rhs) noexcept {
+  lhs.swap(rhs);
+}
 
-template <class Key, class Compare, class Pred> size_t erase_if(set<Key, Compare> &c, Pred pred) {
+template <class Key, class Compare, class Alloc, class Pred> size_t erase_if(set<Key, Compare, Alloc> &c, Pred pred) {
   size_t old_size = c.size();
   for (auto it = begin(c); it != end(c);) {
     if (pred(*it)) {
@@ -36,4 +40,8 @@ template <class Key, class Compare, class Pred> size_t erase_if(set<Key, Compare
   return old_size - c.size();
 }
 
+namespace pmr {
+template <class Key, class Compare = less<Key>> using set = aria::set<Key, Compare, polymorphic_allocator<Key>>;
+}
+
 } // namespace aria
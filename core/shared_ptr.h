@@ -286,6 +286,9 @@ private:
 template <class T> void swap(shared_ptr<T> &a, shared_ptr<T> &b) noexcept { a.swap(b); }
 template <class T> void swap(weak_ptr<T> &a, weak_ptr<T> &b) noexcept { a.swap(b); }
 
+template <class T> struct is_trivially_relocatable<shared_ptr<T>> : true_type {};
+template <class T> struct is_trivially_relocatable<weak_ptr<T>> : true_type {};
+
 template <class T, class... Args> requires(!is_array_v<T>) shared_ptr<T> make_shared(Args &&...args) {
   return shared_ptr<T>(new T(forward<Args>(args)...));
 }
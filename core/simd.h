@@ -0,0 +1,31 @@
+#pragma once
+
+// Compile time detection of the SIMD instruction sets, based on the predefined macros of MSVC, GCC and Clang.
+// Define ARIA_DISABLE_SIMD to force the portable implementations.
+
+#if !defined(ARIA_DISABLE_SIMD) && defined(__AVX2__)
+#define ARIA_HAS_AVX2 1
+#else
+#define ARIA_HAS_AVX2 0
+#endif
+
+#if !defined(ARIA_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ARIA_HAS_SSE2 1
+#else
+#define ARIA_HAS_SSE2 0
+#endif
+
+#if ARIA_HAS_AVX2
+#include <immintrin.h>
+#elif ARIA_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace aria {
+
+namespace simd {
+inline constexpr bool has_sse2 = ARIA_HAS_SSE2;
+inline constexpr bool has_avx2 = ARIA_HAS_AVX2;
+} // namespace simd
+
+} // namespace aria
\ No newline at end of file
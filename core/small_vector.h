@@ -0,0 +1,365 @@
+#pragma once
+
+#include "algorithm.h"
+#include "allocator.h"
+#include "bit.h"
+#include "iterator.h"
+#include "ranges.h"
+#include "stdexcept.h"
+#include "utility.h"
+#include "vector.h"
+
+// small_vector keeps up to N elements in an inline buffer and moves them to the heap when it grows beyond that.
+// It has the interface and the iterators of vector. Moving or swapping a small_vector whose elements are inline moves the elements,
+// so unlike vector it invalidates the iterators.
+namespace aria {
+
+template <class T, size_t N, class Allocator = allocator<T>> class small_vector : public iterable_mixin {
+public:
+  static_assert(N > 0);
+
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using value_type = T;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using allocator_type = Allocator;
+  using pointer = typename allocator_traits<Allocator>::pointer;
+  using const_pointer = typename allocator_traits<Allocator>::const_pointer;
+  using iterator = array_iterator<T>;
+  using const_iterator = basic_const_iterator<iterator>;
+  using reverse_iterator = aria::reverse_iterator<iterator>;
+  using const_reverse_iterator = aria::reverse_iterator<const_iterator>;
+  static constexpr size_type s_inline_capacity = N;
+
+  small_vector() noexcept = default;
+  explicit small_vector(const Allocator &alloc) noexcept : m_alloc(alloc) {}
+
+  small_vector(initializer_list<T> init) { append_range(init); }
+
+  explicit small_vector(size_type n, const T &value = T()) {
+    reserve(n);
+    for (size_type i = 0; i < n; i++)
+      construct_at(get(i), value);
+    m_size = n;
+  }
+
+  template <input_iterator It> small_vector(It first, It last) {
+    if constexpr (forward_iterator<It>)
+      reserve(distance(first, last));
+    for (; first != last; ++first)
+      emplace_back(*first);
+  }
+
+  small_vector(const small_vector &rhs) : m_alloc(rhs.m_alloc) { append_range(rhs); }
+
+  small_vector(small_vector &&rhs) noexcept : m_alloc(rhs.m_alloc) { steal(rhs); }
+
+  ~small_vector() {
+    clear();
+    release();
+  }
+
+  small_vector &operator=(const small_vector &rhs) {
+    if (this != &rhs) {
+      auto v = rhs;
+      *this = move(v);
+    }
+    return *this;
+  }
+
+  small_vector &operator=(small_vector &&rhs) noexcept {
+    if (this != &rhs) {
+      clear();
+      release();
+      m_alloc = rhs.m_alloc;
+      steal(rhs);
+    }
+    return *this;
+  }
+
+  void push_back(const T &value) { emplace_back(value); }
+
+  template <class... Args> reference emplace_back(Args &&...args) {
+    if (m_size < m_capacity) {
+      construct_at(get(m_size), forward<Args>(args)...);
+    } else {
+      // the new element is constructed first, args may refer to an element of this vector
+      const auto cap = bit_ceil(m_capacity + 1);
+      auto p = m_alloc.allocate(cap);
+      construct_at(p + m_size, forward<Args>(args)...);
+      _vector::relocate(p, m_ptr, m_size);
+      release();
+      m_ptr = p;
+      m_capacity = cap;
+    }
+    return *get(m_size++);
+  }
+
+  void pop_back() {
+    if (m_size > 0)
+      destroy_at(get(--m_size));
+  }
+
+  void reserve(size_type new_cap) {
+    if (new_cap > capacity())
+      reallocate(new_cap);
+  }
+
+  void clear() {
+    for (size_type i = 0; i < m_size; i++)
+      destroy_at(get(i));
+    m_size = 0;
+  }
+
+  // moves the elements back to the inline buffer if they fit
+  void shrink_to_fit() {
+    if (is_inline() || capacity() == size())
+      return;
+    if (size() <= N) {
+      auto p = m_ptr;
+      _vector::relocate(inline_data(), p, m_size);
+      m_alloc.deallocate(p, m_capacity);
+      m_ptr = inline_data();
+      m_capacity = N;
+    } else {
+      reallocate(size());
+    }
+  }
+
+  size_type size() const noexcept { return m_size; }
+  size_type capacity() const noexcept { return m_capacity; }
+  bool empty() const noexcept { return size() == 0; }
+  bool is_inline() const noexcept { return m_ptr == inline_data(); }
+  reference front() noexcept { return *get(0); }
+  const_reference front() const noexcept { return *get(0); }
+  reference back() noexcept { return *get(m_size - 1); }
+  const_reference back() const noexcept { return *get(m_size - 1); }
+  reference operator[](size_type i) { return *get(i); }
+  const_reference operator[](size_type i) const { return *get(i); }
+  allocator_type get_allocator() const noexcept { return m_alloc; }
+
+  reference at(size_type i) {
+    check_position(i);
+    return *get(i);
+  }
+  const_reference at(size_type i) const {
+    check_position(i);
+    return *get(i);
+  }
+
+  pointer data() noexcept { return m_ptr; }
+  const_pointer data() const noexcept { return m_ptr; }
+
+  void swap(small_vector &rhs) noexcept {
+    using aria::swap;
+    if (is_inline() || rhs.is_inline()) {
+      auto temp = move(rhs);
+      rhs = move(*this);
+      *this = move(temp);
+      return;
+    }
+    swap(m_ptr, rhs.m_ptr);
+    swap(m_size, rhs.m_size);
+    swap(m_capacity, rhs.m_capacity);
+    swap(m_alloc, rhs.m_alloc);
+  }
+
+  void resize(size_type count) requires is_default_constructible_v<T> { resize_helper(count); }
+
+  void resize(size_type count, const value_type &value) requires is_copy_constructible_v<T> { resize_helper(count, value); }
+
+  auto begin() const noexcept { return const_iterator(get(0)); }
+  auto end() const noexcept { return const_iterator(get(m_size)); }
+  auto begin() noexcept { return iterator(get(0)); }
+  auto end() noexcept { return iterator(get(m_size)); }
+
+  iterator erase(const_iterator first, const_iterator last) requires is_move_assignable_v<T> {
+    const size_type idx = first - begin();
+    const size_type d = last - first;
+    auto p = get(idx);
+    if (d == 0)
+      return p;
+    if constexpr (is_trivially_relocatable_v<T>) {
+      for (auto q = p; q != p + d; ++q)
+        destroy_at(q);
+      memmove(static_cast<void *>(p), p + d, sizeof(value_type) * (size() - idx - d));
+      m_size -= d;
+    } else {
+      for (auto q = p + d; q != get(m_size); ++q)
+        *(q - d) = move(*q);
+      for (size_type i = 0; i < d; i++)
+        pop_back();
+    }
+    return p;
+  }
+
+  iterator erase(const_iterator pos) requires is_move_assignable_v<T> { return erase(pos, pos + 1); }
+  iterator erase(iterator pos) requires is_move_assignable_v<T> { return erase(const_iterator(pos), const_iterator(pos + 1)); }
+
+  template <class U> requires same_as<value_type, remove_cvref_t<U>> iterator insert(const_iterator pos, U &&value) {
+    const size_type idx = pos - begin();
+    value_type tmp(forward<U>(value)); // value may be an element of this vector
+    if (m_size == m_capacity)
+      reallocate(bit_ceil(m_capacity + 1));
+    auto p = get(idx);
+    if constexpr (is_trivially_relocatable_v<T>) {
+      memmove(static_cast<void *>(p + 1), p, sizeof(value_type) * (size() - idx));
+      construct_at(p, move(tmp));
+    } else if (idx == size()) {
+      construct_at(p, move(tmp));
+    } else {
+      construct_at(get(m_size), move(*get(m_size - 1)));
+      for (auto q = get(m_size - 1); q != p; --q)
+        *q = move(*(q - 1));
+      *p = move(tmp);
+    }
+    m_size++;
+    return p;
+  }
+
+  template <ranges::range R> void append_range(R &&rg) {
+    auto first = ranges::begin(rg);
+    auto last = ranges::end(rg);
+    if constexpr (forward_iterator<decltype(first)>) {
+      const auto n = _vector::range_size(first, last);
+      if (m_size + n > m_capacity)
+        reallocate(bit_ceil(m_size + n));
+      _vector::construct_n(get(m_size), first, n);
+      m_size += n;
+    } else {
+      for (; first != last; ++first)
+        emplace_back(*first);
+    }
+  }
+
+  template <ranges::range R> iterator insert_range(const_iterator pos, R &&rg) {
+    const size_type idx = pos - begin();
+    auto first = ranges::begin(rg);
+    auto last = ranges::end(rg);
+    if constexpr (forward_iterator<decltype(first)>) {
+      const auto n = _vector::range_size(first, last);
+      if (m_size + n > m_capacity)
+        reallocate(bit_ceil(m_size + n));
+      auto p = get(idx);
+      const auto old_end = get(m_size);
+      const size_type tail = m_size - idx;
+      if constexpr (is_trivially_relocatable_v<T> && is_nothrow_constructible_v<T, ranges::range_reference_t<R>>) {
+        // open a gap and construct the new elements in it
+        memmove(static_cast<void *>(p + n), p, sizeof(value_type) * tail);
+        _vector::construct_n(p, first, n);
+        m_size += n;
+      } else if (tail > n) {
+        // the last n elements move to uninitialized memory, the others are shifted by assignment
+        for (auto q = old_end - n; q != old_end; ++q, ++m_size)
+          construct_at(get(m_size), move(*q));
+        for (auto q = old_end; q != p + n;) {
+          --q;
+          *q = move(*(q - n));
+        }
+        copy_n(first, n, p);
+      } else {
+        // the new elements which go past the old end are constructed there, followed by the moved tail
+        auto mid = next(first, tail);
+        for (auto it = mid; it != last; ++it, ++m_size)
+          construct_at(get(m_size), *it);
+        for (auto q = p; q != old_end; ++q, ++m_size)
+          construct_at(get(m_size), move(*q));
+        copy(first, mid, p);
+      }
+    } else {
+      const auto old_size = size();
+      append_range(forward<R>(rg));
+      rotate(begin() + idx, begin() + old_size, end());
+    }
+    return get(idx);
+  }
+
+private:
+  alignas(T) aria::byte m_buffer[sizeof(T) * N];
+  pointer m_ptr = inline_data();
+  size_type m_size = 0;
+  size_type m_capacity = N;
+  Allocator m_alloc;
+
+  pointer inline_data() noexcept { return reinterpret_cast<pointer>(m_buffer); }
+  const_pointer inline_data() const noexcept { return reinterpret_cast<const_pointer>(m_buffer); }
+  pointer get(size_type i) { return m_ptr + i; }
+  const_pointer get(size_type i) const { return m_ptr + i; }
+
+  void check_position(size_type i) const {
+    if (i >= m_size)
+      throw out_of_range("");
+  }
+
+  void reallocate(size_type cap) {
+    auto p = m_alloc.allocate(cap);
+    _vector::relocate(p, m_ptr, m_size);
+    release();
+    m_ptr = p;
+    m_capacity = cap;
+  }
+
+  // frees the heap buffer, the elements must have been destroyed or moved
+  void release() noexcept {
+    if (!is_inline())
+      m_alloc.deallocate(m_ptr, m_capacity);
+    m_ptr = inline_data();
+    m_capacity = N;
+  }
+
+  // takes the elements of rhs and leaves it empty, this must be empty and inline
+  void steal(small_vector &rhs) noexcept {
+    if (rhs.is_inline()) {
+      _vector::relocate(inline_data(), rhs.inline_data(), rhs.m_size);
+    } else {
+      m_ptr = rhs.m_ptr;
+      m_capacity = rhs.m_capacity;
+      rhs.m_ptr = rhs.inline_data();
+      rhs.m_capacity = N;
+    }
+    m_size = exchange(rhs.m_size, 0);
+  }
+
+  template <class... Args> void resize_helper(size_type count, Args... args) {
+    if (count < size()) {
+      erase(begin() + count, end());
+      return;
+    }
+    reserve(count);
+    while (size() < count)
+      emplace_back(forward<Args>(args)...);
+  }
+};
+
+template <class T, size_t N, class Alloc>
+[[nodiscard]] bool operator==(const small_vector<T, N, Alloc> &a, const small_vector<T, N, Alloc> &b) {
+  return equal(a.begin(), a.end(), b.begin(), b.end());
+}
+
+template <class T, size_t N, class Alloc>
+[[nodiscard]] auto operator<=>(const small_vector<T, N, Alloc> &a, const small_vector<T, N, Alloc> &b) {
+  return lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end());
+}
+
+template <class T, size_t N, class A> void swap(small_vector<T, N, A> &a, small_vector<T, N, A> &b) { a.swap(b); }
+
+template <class T, size_t N, class Alloc, class U = T>
+small_vector<T, N, Alloc>::size_type erase(small_vector<T, N, Alloc> &v, const U &value) {
+  return erase_if(v, [&value](const T &x) { return x == value; });
+}
+
+template <class T, size_t N, class Alloc, class Pred>
+small_vector<T, N, Alloc>::size_type erase_if(small_vector<T, N, Alloc> &v, Pred pred) {
+  typename small_vector<T, N, Alloc>::size_type i = 0, index = 0;
+  for (; i < v.size(); ++i) {
+    if (!pred(v[i])) {
+      v[index++] = move(v[i]);
+    }
+  }
+  auto res = v.size() - index;
+  v.erase(v.begin() + index, v.end());
+  return res;
+}
+
+} // namespace aria
\ No newline at end of file
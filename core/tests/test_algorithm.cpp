@@ -1,8 +1,10 @@
 #include "algorithm.h"
 #include "list.h"
+#include "mystring.h"
 #include "numeric.h"
 #include "vector.h"
 #include <algorithm>
+#include <numeric>
 
 #include "gtest/gtest.h"
 
@@ -43,6 +45,13 @@ TEST(test_algorithm, reverse) {
     reverse(v.begin(), v.end());
     EXPECT_EQ(v, u);
   }
+  {
+    vector<int> v = {1, 2, 3, 4}, u = {4, 3, 2, 1};
+    reverse(v.begin(), v.end());
+    EXPECT_EQ(v, u);
+    reverse(v.begin(), v.begin());
+    EXPECT_EQ(v, u);
+  }
   {
     list<int> v = {1, 2, 3}, u = {3, 2, 1};
     reverse(v.begin(), v.end());
@@ -50,6 +59,58 @@ TEST(test_algorithm, reverse) {
   }
 }
 
+namespace {
+// a forward only view of an int array
+struct forward_int_iterator {
+  using value_type = int;
+  using difference_type = ptrdiff_t;
+  int &operator*() const { return *p; }
+  forward_int_iterator &operator++() {
+    ++p;
+    return *this;
+  }
+  forward_int_iterator operator++(int) { return forward_int_iterator{p++}; }
+  bool operator==(const forward_int_iterator &) const = default;
+  int *p = nullptr;
+};
+static_assert(forward_iterator<forward_int_iterator> && !bidirectional_iterator<forward_int_iterator>);
+} // namespace
+
+TEST(test_algorithm, rotate) {
+  for (int n = 0; n < 40; n++) {
+    for (int k = 0; k <= n; k++) {
+      std::vector<int> expected(n);
+      std::iota(expected.begin(), expected.end(), 0);
+      std::rotate(expected.begin(), expected.begin() + k, expected.end());
+
+      vector<int> v(n);
+      list<int> l;
+      for (int i = 0; i < n; i++) {
+        v[i] = i;
+        l.push_back(i);
+      }
+      EXPECT_EQ(aria::rotate(v.begin(), v.begin() + k, v.end()), v.begin() + (n - k));
+      EXPECT_TRUE(equal(v.begin(), v.end(), expected.begin()));
+      EXPECT_EQ(aria::rotate(l.begin(), next(l.begin(), k), l.end()), next(l.begin(), n - k));
+      EXPECT_TRUE(equal(l.begin(), l.end(), expected.begin()));
+
+      std::vector<int> f(n);
+      std::iota(f.begin(), f.end(), 0);
+      const forward_int_iterator first{f.data()}, last{f.data() + n};
+      EXPECT_EQ(aria::rotate(first, forward_int_iterator{f.data() + k}, last), forward_int_iterator{f.data() + (n - k)});
+      EXPECT_EQ(f, expected);
+    }
+  }
+
+  // every pass of the forward rotate moves one element here
+  const int n = 1000000;
+  std::vector<int> f(n);
+  std::iota(f.begin(), f.end(), 0);
+  aria::rotate(forward_int_iterator{f.data()}, forward_int_iterator{f.data() + n - 1}, forward_int_iterator{f.data() + n});
+  EXPECT_EQ(f[0], n - 1);
+  EXPECT_EQ(f[n - 1], n - 2);
+}
+
 TEST(test_algorithm, find) {
   {
     vector<int> v = {1, 2, 3};
@@ -102,6 +163,15 @@ TEST(test_algorithm, numeric) {
     auto op = [](int a, int b) { return a * b; };
     EXPECT_EQ(accumulate(v.begin(), v.end(), 1, op), 24);
     EXPECT_EQ(reduce(v.begin(), v.end(), 1, op), 24);
+
+    vector<int> w = {1, 2, 3, 4};
+    EXPECT_EQ(transform_reduce(v.begin(), v.end(), w.begin(), 0), 4 + 2 + 9 + 8);
+    EXPECT_EQ(transform_reduce(v.begin(), v.end(), 0, plus{}, [](int x) { return x * x; }), 30);
+    vector<int> out(4);
+    EXPECT_EQ(inclusive_scan(v.begin(), v.end(), out.begin()), out.end());
+    EXPECT_EQ(out, (vector<int>{4, 5, 8, 10}));
+    inclusive_scan(v.begin(), v.end(), out.begin(), op, 2);
+    EXPECT_EQ(out, (vector<int>{8, 8, 24, 48}));
   }
 }
 
@@ -240,4 +310,177 @@ TEST(test_algorithm, sort) {
     sort(v.begin(), v.end());
     EXPECT_EQ(u, v);
   }
-}
\ No newline at end of file
+}
+
+// the inputs which defeat a naive quicksort, in sizes around the insertion sort and ninther thresholds
+TEST(test_algorithm, sort_patterns) {
+  for (int n : {0, 1, 2, 23, 24, 25, 127, 129, 1000, 100000}) {
+    vector<vector<int>> inputs(6);
+    unsigned x = 12345;
+    for (int i = 0; i < n; i++) {
+      x = x * 1103515245 + 12345;
+      inputs[0].push_back(int(x >> 8));         // random
+      inputs[1].push_back(i);                   // sorted
+      inputs[2].push_back(n - i);               // reversed
+      inputs[3].push_back(i % 100);             // sawtooth
+      inputs[4].push_back((x >> 8) % 4);        // few unique
+      inputs[5].push_back(i == n / 2 ? -1 : i); // sorted but one
+    }
+    for (auto &v : inputs) {
+      auto u = v;
+      std::sort(u.begin(), u.end());
+      sort(v.begin(), v.end());
+      EXPECT_EQ(u, v);
+
+      // a lambda is not partitioned without branches
+      sort(v.begin(), v.end(), [](int a, int b) { return a > b; });
+      EXPECT_TRUE(is_sorted(v.begin(), v.end(), greater{}));
+      sort(v.begin(), v.end(), greater{});
+      EXPECT_TRUE(is_sorted(v.begin(), v.end(), greater{}));
+    }
+  }
+
+  vector<double> d;
+  for (int i = 0; i < 1000; i++)
+    d.push_back((i * 7919) % 1000 / 10.0);
+  sort(d.begin(), d.end());
+  EXPECT_TRUE(is_sorted(d.begin(), d.end()));
+}
+
+TEST(test_algorithm, radix_sort) {
+  unsigned x = 1;
+  auto rand = [&x] { return x = x * 1103515245 + 12345; };
+
+  vector<int> a;
+  vector<double> d;
+  vector<long long> ll;
+  for (int i = 0; i < 5000; i++) {
+    a.push_back(int(rand()));
+    d.push_back(int(rand() % 2001 - 1000) / 8.0);
+    ll.push_back((long long)(rand()) << 20 | i);
+  }
+  auto a2 = a;
+  std::sort(a2.begin(), a2.end());
+  radix_sort(a.begin(), a.end());
+  EXPECT_EQ(a, a2);
+  radix_sort(d.begin(), d.end(), identity{}, allocator<double>());
+  EXPECT_TRUE(is_sorted(d.begin(), d.end()));
+  EXPECT_LT(d.front(), 0);
+  // aria::sort uses radix sort for large arithmetic ranges
+  auto ll2 = ll;
+  std::sort(ll2.begin(), ll2.end());
+  sort(ll.begin(), ll.end());
+  EXPECT_EQ(ll, ll2);
+
+  // sorted by a projection, stably
+  struct row {
+    unsigned char key;
+    int order;
+  };
+  vector<row> rows;
+  for (int i = 0; i < 1000; i++)
+    rows.push_back({static_cast<unsigned char>(rand() % 7), i});
+  radix_sort(rows.begin(), rows.end(), [](const row &r) { return r.key; });
+  EXPECT_TRUE(is_sorted(rows.begin(), rows.end(),
+                        [](const row &l, const row &r) { return l.key < r.key || (l.key == r.key && l.order < r.order); }));
+
+  vector<string> strs;
+  for (int i = 0; i < 3000; i++) {
+    string s;
+    for (auto n = rand() % 6; n > 0; n--)
+      s.push_back(char('a' + rand() % 3));
+    strs.push_back(s);
+  }
+  strs.push_back("a string longer than the small buffer, with a common prefix");
+  strs.push_back("a string longer than the small buffer, with a common prefix too");
+  radix_sort(strs.begin(), strs.end());
+  EXPECT_TRUE(is_sorted(strs.begin(), strs.end()));
+  EXPECT_EQ(strs.front(), "");
+
+  // long shared prefixes don't make the recursion deep
+  string x;
+  for (int i = 0; i < 20000; i++)
+    x.push_back('x');
+  vector<string> same(100, x);
+  radix_sort(same.begin(), same.end());
+  EXPECT_TRUE(all_of(same.begin(), same.end(), [&x](const string &s) { return s == x; }));
+  vector<string> prefixes;
+  for (string a = "a"; a.size() <= 3000; a.push_back('a'))
+    prefixes.insert(prefixes.begin(), a);
+  radix_sort(prefixes.begin(), prefixes.end());
+  for (int i = 0; i < 3000; i++)
+    EXPECT_EQ(prefixes[i].size(), i + 1);
+}
+
+TEST(test_algorithm, stable_sort) {
+  unsigned x = 1;
+  auto rand = [&x] { return x = x * 1103515245 + 12345; };
+
+  // the order is checked on the second member, which the comparison ignores
+  for (int n : {0, 1, 31, 33, 1000, 5000}) {
+    vector<pair<int, int>> v;
+    for (int i = 0; i < n; i++)
+      v.push_back({int(rand() >> 16) % 50, i});
+    stable_sort(v.begin(), v.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    EXPECT_TRUE(is_sorted(v.begin(), v.end()));
+  }
+
+  vector<string> strs;
+  for (int i = 0; i < 500; i++) {
+    string s;
+    for (auto n = rand() % 4; n > 0; n--)
+      s.push_back(char('a' + rand() % 3));
+    strs.push_back(s);
+  }
+  auto strs2 = strs;
+  std::stable_sort(strs2.begin(), strs2.end());
+  stable_sort(strs.begin(), strs.end());
+  EXPECT_EQ(strs, strs2);
+
+  vector<int> a = {1, 3, 5, 7, 9, 0, 2, 4, 6, 8, 10};
+  inplace_merge(a.begin(), a.begin() + 5, a.end());
+  EXPECT_EQ(a, (vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10}));
+
+  vector<pair<int, int>> b(6), c = {{1, 0}, {1, 1}, {2, 2}}, d = {{0, 3}, {1, 4}, {2, 5}};
+  EXPECT_EQ(merge(c.begin(), c.end(), d.begin(), d.end(), b.begin(), [](const auto &l, const auto &r) { return l.first < r.first; }),
+            b.end());
+  EXPECT_EQ(b, (vector<pair<int, int>>{{0, 3}, {1, 0}, {1, 1}, {1, 4}, {2, 2}, {2, 5}}));
+}
+
+TEST(test_algorithm, partial_sort_and_nth_element) {
+  unsigned x = 1;
+  auto rand = [&x] { return x = x * 1103515245 + 12345; };
+
+  vector<int> v;
+  for (int i = 0; i < 1000; i++)
+    v.push_back(int(rand() % 10000));
+  auto sorted_v = v;
+  std::sort(sorted_v.begin(), sorted_v.end());
+
+  auto top = v;
+  partial_sort(top.begin(), top.begin() + 10, top.end(), greater{});
+  EXPECT_TRUE(equal(top.begin(), top.begin() + 10, sorted_v.rbegin()));
+
+  vector<int> out(10);
+  EXPECT_EQ(partial_sort_copy(v.begin(), v.end(), out.begin(), out.end()), out.end());
+  EXPECT_TRUE(equal(out.begin(), out.end(), sorted_v.begin()));
+  vector<int> big(2000);
+  EXPECT_EQ(partial_sort_copy(v.begin(), v.end(), big.begin(), big.end()), big.begin() + 1000);
+  EXPECT_TRUE(equal(sorted_v.begin(), sorted_v.end(), big.begin()));
+
+  // nth_element on the patterns which defeat a naive quickselect
+  vector<vector<int>> inputs = {v, sorted_v, vector<int>(sorted_v.rbegin(), sorted_v.rend()), vector<int>(1000, 7), vector<int>(1000)};
+  for (int i = 0; i < 1000; i++)
+    inputs.back()[i] = i % 2 ? i : 7;
+  for (auto &input : inputs) {
+    auto expected = input;
+    std::sort(expected.begin(), expected.end());
+    for (int k : {0, 1, 100, 500, 999}) {
+      auto w = input;
+      nth_element(w.begin(), w.begin() + k, w.end());
+      EXPECT_EQ(w[k], expected[k]);
+      EXPECT_TRUE(all_of(w.begin(), w.begin() + k, [&](int y) { return y <= w[k]; }));
+      EXPECT_TRUE(all_of(w.begin() + k, w.end(), [&](int y) { return y >= w[k]; }));
+    }
+  }
+}
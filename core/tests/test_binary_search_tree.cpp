@@ -214,4 +214,106 @@ TEST(test_binary_search_tree, node_handle) {
     c.insert(move(nh));
     EXPECT_EQ(c, d);
   }
-}
\ No newline at end of file
+}
+TEST(test_binary_search_tree, extract_first) {
+  binary_search_tree<int, void> a = {2, 1, 3};
+  auto nh = a.extract(1);
+  EXPECT_EQ(*a.begin(), 2);
+  a.insert(move(nh));
+  EXPECT_EQ(*a.begin(), 1);
+}
+
+TEST(test_binary_search_tree, sorted_input) {
+  // an unbalanced tree would be a linked list here
+  const int n = 100000;
+  binary_search_tree<int, int> tree;
+  for (int i = 0; i < n; i++)
+    tree.insert(pair(i, i));
+  for (int i = -1; i > -n; i--)
+    tree.insert(pair(i, i));
+  EXPECT_EQ(tree.size(), 2 * n - 1);
+  EXPECT_EQ(tree.begin()->first, 1 - n);
+
+  int expected = 1 - n;
+  for (auto &[k, v] : tree)
+    EXPECT_EQ(k, expected++);
+
+  for (int i = 0; i < n; i += 2)
+    EXPECT_EQ(tree.erase(i), 1);
+  for (int i = 0; i < n; i++)
+    EXPECT_EQ(tree.contains(i), i % 2 == 1) << i;
+  for (int i = 1 - n; i < n; i++)
+    tree.erase(i);
+  EXPECT_TRUE(tree.empty());
+  EXPECT_EQ(tree.begin(), tree.end());
+}
+
+TEST(test_binary_search_tree, sorted_unique_build) {
+  for (int n = 0; n < 300; n++) {
+    vector<int> v;
+    for (int i = 0; i < n; i++)
+      v.push_back(i * 2);
+    binary_search_tree<int, void> tree(sorted_unique, v.begin(), v.end());
+    EXPECT_TRUE(tree.is_balanced()) << n;
+    EXPECT_EQ(tree.size(), n);
+
+    vector<int> odd;
+    for (int i = -1; i < n; i += 3)
+      odd.push_back(i);
+    tree.insert_range(sorted_unique, odd.begin(), odd.end());
+    tree.insert_range(sorted_unique, v.begin(), v.end());
+    EXPECT_TRUE(tree.is_balanced()) << n;
+    EXPECT_EQ(tree.size(), v.size() + odd.size() - (n + 3) / 6);
+    EXPECT_TRUE(is_sorted(tree.begin(), tree.end()));
+    for (int i = 0; i < n; i++) {
+      tree.erase(i * 2);
+      EXPECT_TRUE(tree.is_balanced());
+    }
+    EXPECT_EQ(tree.size(), odd.size() - (n + 3) / 6);
+  }
+}
+
+namespace {
+struct throw_on_copy {
+  static inline int alive = 0;
+  static inline int copies_left = 0;
+  throw_on_copy(int x) : v(x) { ++alive; }
+  throw_on_copy(const throw_on_copy &rhs) : v(rhs.v) {
+    if (copies_left-- == 0)
+      throw 1;
+    ++alive;
+  }
+  ~throw_on_copy() { --alive; }
+  bool operator<(const throw_on_copy &rhs) const { return v < rhs.v; }
+  int v;
+};
+} // namespace
+
+TEST(test_binary_search_tree, sorted_unique_throw) {
+  using tree_type = binary_search_tree<throw_on_copy, void>;
+  {
+    throw_on_copy::copies_left = 1 << 30;
+    vector<throw_on_copy> v;
+    for (int i = 0; i < 100; i++)
+      v.push_back(throw_on_copy(i * 2));
+    throw_on_copy::copies_left = 50;
+    tree_type tree(sorted_unique, v.begin(), v.begin() + 50);
+    EXPECT_EQ(throw_on_copy::alive, 150);
+
+    throw_on_copy::copies_left = 20;
+    EXPECT_ANY_THROW(tree.insert_range(sorted_unique, v.begin() + 40, v.end()));
+    EXPECT_EQ(throw_on_copy::alive, 150);
+    EXPECT_EQ(tree.size(), 50);
+    EXPECT_TRUE(tree.is_balanced());
+    int expected = 0;
+    for (auto &x : tree) {
+      EXPECT_EQ(x.v, expected);
+      expected += 2;
+    }
+
+    throw_on_copy::copies_left = 30;
+    EXPECT_ANY_THROW(tree_type copy(tree));
+    EXPECT_EQ(throw_on_copy::alive, 150);
+  }
+  EXPECT_EQ(throw_on_copy::alive, 0);
+}
@@ -41,4 +41,26 @@ TEST(test_bit, bit_floor) {
   EXPECT_EQ(bit_floor(4u), 4);
   EXPECT_EQ(bit_floor(7u), 4);
   EXPECT_EQ(bit_floor(120u), 64);
+}
+TEST(test_bit, countr_zero) {
+  EXPECT_EQ(countr_zero(1u), 0);
+  EXPECT_EQ(countr_zero(8u), 3);
+  EXPECT_EQ(countr_zero(12u), 2);
+  EXPECT_EQ(countr_zero(0u), 32);
+  EXPECT_EQ(countr_zero(0ull), 64);
+  EXPECT_EQ(countr_zero(1ull << 40), 40);
+}
+
+TEST(test_bit, to_ordered_bits) {
+  EXPECT_LT(to_ordered_bits(-1), to_ordered_bits(0));
+  EXPECT_LT(to_ordered_bits(-100000), to_ordered_bits(-1));
+  EXPECT_LT(to_ordered_bits(1), to_ordered_bits(2));
+  EXPECT_LT(to_ordered_bits(3u), to_ordered_bits(~0u));
+  EXPECT_LT(to_ordered_bits(static_cast<signed char>(-128)), to_ordered_bits(static_cast<signed char>(127)));
+
+  const double values[] = {-1e300, -2.5, -1.0, -1e-300, -0.0, 0.0, 1e-300, 1.0, 2.5, 1e300};
+  for (int i = 0; i + 1 < 10; i++)
+    EXPECT_LT(to_ordered_bits(values[i]), to_ordered_bits(values[i + 1]));
+  EXPECT_LT(to_ordered_bits(-1.5f), to_ordered_bits(1.5f));
+  static_assert(is_same_v<decltype(to_ordered_bits(1.0f)), unsigned int>);
 }
\ No newline at end of file
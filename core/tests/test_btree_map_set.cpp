@@ -0,0 +1,322 @@
+#include "btree_map.h"
+#include "btree_set.h"
+#include "mystring.h"
+#include "vector.h"
+#include "gtest/gtest.h"
+#include <map>
+#include <new>
+#include <random>
+#include <set>
+#include <stdexcept>
+
+using namespace aria;
+
+static_assert(bidirectional_iterator<btree_map<int, int>::iterator>);
+static_assert(bidirectional_iterator<btree_map<int, int>::const_iterator>);
+
+// the smallest nodes, so that a few hundred values already make a deep tree
+template <class Key, class T> using small_btree_map = btree_map<Key, T, less<Key>, 1>;
+template <class Key> using small_btree_set = btree_set<Key, less<Key>, 1>;
+
+TEST(test_btree_map, basic) {
+  btree_map<int, int> m;
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(m.begin(), m.end());
+  EXPECT_FALSE(m.contains(1));
+  m.insert(pair(3, 2));
+  EXPECT_EQ(m.size(), 1);
+  EXPECT_EQ(m[3], 2);
+  m[3] = 4;
+  EXPECT_EQ(m[3], 4);
+  m[1] = 10;
+  EXPECT_EQ(m.begin()->first, 1);
+  EXPECT_EQ(m.at(1), 10);
+  EXPECT_THROW(m.at(2), out_of_range);
+  EXPECT_EQ(m.erase(3), 1);
+  EXPECT_EQ(m.erase(3), 0);
+  m.erase(m.find(1));
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(m.begin(), m.end());
+}
+
+TEST(test_btree_map, insert_erase) {
+  small_btree_map<int, int> m;
+  const int n = 1000;
+  for (int i = 0; i < n; i++) {
+    auto [it, flag] = m.insert(pair(i * 2, i * 4));
+    EXPECT_TRUE(flag) << i;
+    EXPECT_EQ(it->second, i * 4);
+  }
+  for (int i = 0; i < n; i++) {
+    auto [it, flag] = m.emplace(i * 2, i * 10);
+    EXPECT_FALSE(flag) << i;
+    EXPECT_EQ(it->second, i * 4);
+  }
+  EXPECT_EQ(m.size(), n);
+  for (int i = 0; i < n; i++) {
+    EXPECT_TRUE(m.contains(i * 2));
+    EXPECT_FALSE(m.contains(i * 2 + 1));
+  }
+  for (int i = 0; i < n; i++) {
+    EXPECT_EQ(m.erase(i * 2), 1);
+    EXPECT_EQ(m.erase(i * 2), 0);
+    EXPECT_EQ(m.erase(i * 2 + 1), 0);
+  }
+  EXPECT_TRUE(m.empty());
+}
+
+TEST(test_btree_map, random) {
+  small_btree_map<int, string> m;
+  std::map<int, string> expected;
+  std::mt19937 gen(42);
+  for (int i = 0; i < 20000; i++) {
+    const int key = gen() % 2000;
+    if (gen() % 3 == 0) {
+      EXPECT_EQ(m.erase(key), expected.erase(key));
+    } else {
+      const auto value = to_string(i);
+      m[key] = value;
+      expected[key] = value;
+    }
+  }
+  EXPECT_EQ(m.size(), expected.size());
+  auto it = expected.begin();
+  for (auto &[k, v] : m) {
+    EXPECT_EQ(k, it->first);
+    EXPECT_EQ(v, it->second);
+    ++it;
+  }
+  EXPECT_EQ(it, expected.end());
+}
+
+TEST(test_btree_map, erase_while_iterating) {
+  small_btree_map<int, int> m;
+  for (int i = 0; i < 500; i++)
+    m[i] = i;
+  for (auto it = m.begin(); it != m.end();) {
+    if (it->first % 3 != 0)
+      it = m.erase(it);
+    else
+      ++it;
+  }
+  EXPECT_EQ(m.size(), 167);
+  int expected = 0;
+  for (auto &[k, v] : m) {
+    EXPECT_EQ(k, expected);
+    expected += 3;
+  }
+  EXPECT_EQ(erase_if(m, [](auto &kv) { return kv.first % 2 == 0; }), 84);
+  EXPECT_EQ(m.size(), 83);
+}
+
+TEST(test_btree_map, ctor) {
+  {
+    btree_map<int, int> m = {{4, 6}, {1, 2}};
+    EXPECT_EQ(m.size(), 2);
+    EXPECT_EQ(m.begin()->first, 1);
+    EXPECT_EQ(m[4], 6);
+  }
+  {
+    vector<pair<int, int>> v = {{1, 2}, {4, 6}};
+    btree_map<int, int> m(v.begin(), v.end());
+    EXPECT_EQ(m.size(), 2);
+    EXPECT_EQ(m[1], 2);
+  }
+  {
+    small_btree_map<int, int> a;
+    for (int i = 0; i < 100; i++)
+      a[i] = i;
+    const auto b = a;
+    EXPECT_EQ(a, b);
+    auto c = move(a);
+    EXPECT_EQ(c, b);
+    EXPECT_TRUE(a.empty());
+    a = c;
+    EXPECT_EQ(a, b);
+    small_btree_map<int, int> d = {{1, 1}};
+    swap(d, c);
+    EXPECT_EQ(d, b);
+    EXPECT_EQ(c.size(), 1);
+  }
+}
+
+TEST(test_btree_map, reverse_iterator) {
+  small_btree_map<int, int> m;
+  for (int i = 0; i < 100; i++)
+    m[i] = i;
+  int expected = 99;
+  for (auto it = m.rbegin(); it != m.rend(); ++it)
+    EXPECT_EQ(it->first, expected--);
+  EXPECT_EQ(expected, -1);
+}
+
+TEST(test_btree_map, insert_or_assign) {
+  btree_map<int, int> a;
+  auto [it, flag] = a.insert_or_assign(1, 10);
+  EXPECT_TRUE(flag);
+  EXPECT_TRUE(it->first == 1 && it->second == 10);
+  auto [it2, flag2] = a.insert_or_assign(1, 20);
+  EXPECT_FALSE(flag2);
+  EXPECT_TRUE(it2->first == 1 && it2->second == 20);
+}
+
+TEST(test_btree_map, node_handle) {
+  btree_map<int, int> a = {{1, 2}, {3, 4}}, b;
+  auto nh = a.extract(1);
+  EXPECT_TRUE(nh);
+  EXPECT_EQ(nh.key(), 1);
+  EXPECT_EQ(nh.mapped(), 2);
+  EXPECT_EQ(a.size(), 1);
+  auto [it, flag] = b.insert(move(nh));
+  EXPECT_TRUE(flag);
+  EXPECT_FALSE(nh);
+  EXPECT_EQ(it->second, 2);
+  EXPECT_FALSE(a.extract(5));
+}
+
+namespace {
+// allocate throws bad_alloc once remaining reaches 0, the budget is shared by the rebound allocators
+struct allocation_budget {
+  static inline int remaining = -1; // unlimited
+};
+
+template <class T> struct limited_allocator : allocator<T> {
+  template <class U> using rebind_alloc = limited_allocator<U>;
+
+  limited_allocator() = default;
+  template <class U> limited_allocator(const limited_allocator<U> &) {}
+
+  T *allocate(size_t n) {
+    if (allocation_budget::remaining == 0)
+      throw std::bad_alloc();
+    if (allocation_budget::remaining > 0)
+      allocation_budget::remaining--;
+    return allocator<T>::allocate(n);
+  }
+};
+
+struct copy_throws {
+  copy_throws(int v) : value(v) {}
+  copy_throws(const copy_throws &rhs) : value(rhs.value) {
+    if (armed)
+      throw std::runtime_error("copy_throws");
+  }
+  static inline bool armed = false;
+  int value;
+};
+} // namespace
+
+TEST(test_btree_map, exception_safety) {
+  // a failed insertion at any point of a split leaves the tree as it was
+  btree_map<int, int, less<int>, 1, limited_allocator<pair<const int, int>>> m;
+  std::set<int> expected;
+  std::mt19937 gen(7);
+  for (int i = 0; i < 5000; i++) {
+    const int key = gen() % 4000;
+    allocation_budget::remaining = gen() % 4;
+    try {
+      m.insert(pair(key, key));
+      expected.insert(key);
+    } catch (const std::bad_alloc &) {
+    }
+  }
+  allocation_budget::remaining = -1;
+
+  small_btree_map<int, copy_throws> m2;
+  for (int i = 0; i < 5000; i++) {
+    const int key = gen() % 4000;
+    const pair<const int, copy_throws> value(key, key);
+    copy_throws::armed = gen() % 2;
+    try {
+      m2.insert(value);
+    } catch (const std::runtime_error &) {
+    }
+    copy_throws::armed = false;
+  }
+
+  EXPECT_EQ(m.size(), expected.size());
+  auto it = expected.begin();
+  for (auto &[k, v] : m)
+    EXPECT_EQ(k, *it++);
+  int n = 0, last = -1;
+  for (auto &[k, v] : m2) {
+    EXPECT_LT(last, k);
+    EXPECT_EQ(k, v.value);
+    last = k;
+    n++;
+  }
+  EXPECT_EQ(n, m2.size());
+  // the trees are still valid
+  for (int i = 0; i < 4000; i++) {
+    m.insert(pair(i, i));
+    m2.insert(pair(i, copy_throws(i)));
+  }
+  EXPECT_EQ(m.size(), 4000);
+  EXPECT_EQ(m2.size(), 4000);
+  for (int i = 0; i < 4000; i++) {
+    EXPECT_EQ(m.erase(i), 1);
+    EXPECT_EQ(m2.erase(i), 1);
+  }
+  EXPECT_TRUE(m.empty() && m2.empty());
+}
+
+TEST(test_btree_set, basic) {
+  small_btree_set<int> st;
+  for (int i = 0; i < 100; i++) {
+    if (i % 2 == 0)
+      st.insert(i);
+  }
+  EXPECT_EQ(st.size(), 50);
+  for (int i = 0; i < 100; i++)
+    EXPECT_EQ(st.contains(i), i % 2 == 0);
+  EXPECT_EQ(*st.begin(), 0);
+  EXPECT_EQ(*prev(st.end()), 98);
+}
+
+TEST(test_btree_set, lower_upper_bound) {
+  small_btree_set<int> st;
+  for (int i = 0; i < 1000; i += 10)
+    st.insert(i);
+  for (int i = -5; i < 1000; i++) {
+    const int lower = (i + 9) / 10 * 10, upper = (i + 10) / 10 * 10;
+    if (i < 0) {
+      EXPECT_EQ(*st.lower_bound(i), 0);
+      continue;
+    }
+    auto it = st.lower_bound(i);
+    if (lower < 1000)
+      EXPECT_EQ(*it, lower) << i;
+    else
+      EXPECT_EQ(it, st.end()) << i;
+    auto it2 = st.upper_bound(i);
+    if (upper < 1000)
+      EXPECT_EQ(*it2, upper) << i;
+    else
+      EXPECT_EQ(it2, st.end()) << i;
+  }
+  auto [first, last] = st.equal_range(20);
+  EXPECT_EQ(*first, 20);
+  EXPECT_EQ(*last, 30);
+  auto [first2, last2] = st.equal_range(25);
+  EXPECT_EQ(first2, last2);
+  EXPECT_EQ(*first2, 30);
+}
+
+TEST(test_btree_set, sorted_input) {
+  btree_set<int> st;
+  const int n = 100000;
+  for (int i = 0; i < n; i++)
+    st.insert(i);
+  for (int i = -1; i > -n; i--)
+    st.insert(i);
+  EXPECT_EQ(st.size(), 2 * n - 1);
+  int expected = 1 - n;
+  for (auto x : st)
+    EXPECT_EQ(x, expected++);
+  for (int i = 1 - n; i < n; i += 2)
+    EXPECT_EQ(st.erase(i), 1);
+  EXPECT_EQ(st.size(), n - 1);
+  for (int i = 1 - n; i < n; i++)
+    st.erase(i);
+  EXPECT_TRUE(st.empty());
+}
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "deque.h"
+#include "mystring.h"
+#include "vector.h"
 #include "gtest/gtest.h"
 
 using namespace aria;
@@ -192,4 +194,104 @@ TEST(test_deque, equal_op) {
   EXPECT_EQ(a, b);
   EXPECT_NE(a, c);
   EXPECT_NE(a, d);
+}
+namespace {
+template <class T> struct counting_allocator : allocator<T> {
+  static inline int n_allocations = 0;
+  T *allocate(size_t n) {
+    n_allocations++;
+    return allocator<T>::allocate(n);
+  }
+};
+} // namespace
+
+TEST(test_deque, ring) {
+  deque<int, allocator<int>, 4> deq;
+  int front = 0, back = 0;
+  for (int i = 0; i < 10000; i++) {
+    deq.push_back(back++);
+    if (i % 3 == 0) {
+      deq.pop_front();
+      front++;
+    }
+    if (i % 7 == 0)
+      deq.push_front(--front);
+  }
+  EXPECT_EQ(deq.size(), back - front);
+  EXPECT_EQ(deq.front(), front);
+  EXPECT_EQ(deq.back(), back - 1);
+  for (int i = 0; i < deq.size(); i++)
+    EXPECT_EQ(deq[i], front + i);
+  EXPECT_EQ(deq.end() - deq.begin(), deq.size());
+
+  // the iterators step across the blocks of the ring
+  int i = 0;
+  for (auto it = deq.begin(); it != deq.end(); ++it, ++i)
+    EXPECT_EQ(*it, front + i);
+  for (auto it = deq.end(); it != deq.begin();) {
+    --it;
+    EXPECT_EQ(*it, front + --i);
+  }
+  for (int j = 0; j < deq.size(); j += 3) {
+    auto it = deq.begin() + j;
+    EXPECT_EQ(*it, front + j);
+    EXPECT_EQ(*(it++), front + j);
+    if (j + 1 < deq.size())
+      EXPECT_EQ(*it, front + j + 1);
+    EXPECT_EQ(*--it, front + j);
+    EXPECT_EQ(it - deq.begin(), j);
+  }
+
+  deq.clear();
+  EXPECT_TRUE(deq.empty());
+  deq.push_front(1);
+  EXPECT_EQ(deq, (deque<int, allocator<int>, 4>{1}));
+}
+
+TEST(test_deque, spare_blocks) {
+  deque<int, counting_allocator<int>, 16> q;
+  for (int i = 0; i < 16; i++)
+    q.push_back(i);
+  const auto n_allocations = counting_allocator<int>::n_allocations;
+  // a queue moving over block boundaries reuses the freed blocks
+  for (int i = 0; i < 1000; i++) {
+    q.push_back(i);
+    q.pop_front();
+  }
+  EXPECT_EQ(counting_allocator<int>::n_allocations, n_allocations + 1);
+  EXPECT_EQ(q.size(), 16);
+  EXPECT_EQ(q.back(), 999);
+}
+
+TEST(test_deque, bulk) {
+  deque<int, allocator<int>, 4> deq = {5, 6};
+  vector<int> v;
+  for (int i = 0; i < 10; i++)
+    v.push_back(i);
+  deq.append_range(v);
+  deq.prepend_range(vector<int>{-3, -2, -1});
+  EXPECT_EQ(deq.size(), 15);
+  EXPECT_EQ(deq, (deque<int, allocator<int>, 4>{-3, -2, -1, 5, 6, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+  int out[8]{};
+  EXPECT_EQ(deq.pop_front_n(6, out), out + 6);
+  EXPECT_EQ(out[0], -3);
+  EXPECT_EQ(out[5], 0);
+  EXPECT_EQ(deq.front(), 1);
+  EXPECT_EQ(deq.pop_front_n(8, out), out + 8);
+  EXPECT_EQ(deq.pop_front_n(8, out), out + 1);
+  EXPECT_EQ(out[0], 9);
+  EXPECT_TRUE(deq.empty());
+
+  deque<string, allocator<string>, 2> strs;
+  strs.emplace_back("b");
+  strs.emplace_front("a");
+  strs.append_range(vector<string>{"c", "a string longer than the small buffer", "e"});
+  strs.prepend_range(deque<string>{"x", "y", "z"});
+  EXPECT_EQ(strs, (deque<string, allocator<string>, 2>{"x", "y", "z", "a", "b", "c", "a string longer than the small buffer", "e"}));
+  vector<string> res(5);
+  strs.pop_front_n(5, res.begin());
+  EXPECT_EQ(res, (vector<string>{"x", "y", "z", "a", "b"}));
+  EXPECT_EQ(strs.front(), "c");
+  EXPECT_EQ(strs.size(), 3);
 }
\ No newline at end of file
@@ -0,0 +1,274 @@
+#include "flat_hash_map.h"
+#include "flat_hash_set.h"
+#include "gtest/gtest.h"
+#include <random>
+#include <unordered_map>
+
+using namespace aria;
+
+static_assert(forward_iterator<flat_hash_map<int, int>::iterator>);
+static_assert(forward_iterator<flat_hash_map<int, int>::const_iterator>);
+
+TEST(test_flat_hash_map, basic) {
+  flat_hash_map<int, int> m;
+  EXPECT_TRUE(m.empty());
+  EXPECT_TRUE(m.begin() == m.end());
+  EXPECT_FALSE(m.contains(1));
+  m.insert(pair(3, 2));
+  EXPECT_EQ(m.size(), 1);
+  EXPECT_EQ(m[3], 2);
+  m[3] = 4;
+  EXPECT_EQ(m[3], 4);
+  auto it = m.find(3);
+  EXPECT_TRUE(it != m.end());
+  m[5] = 10;
+  EXPECT_EQ(m.size(), 2);
+  EXPECT_EQ(m[5], 10);
+  m.erase(3);
+  EXPECT_EQ(m.size(), 1);
+  auto it5 = m.find(5);
+  m.erase(it5);
+  EXPECT_EQ(m.size(), 0);
+}
+
+TEST(test_flat_hash_map, insert_erase) {
+  flat_hash_map<int, int> m;
+  const int n = 1000;
+  for (int i = 0; i < n; i++) {
+    auto [it, flag] = m.insert(pair(i * 2, i * 4));
+    EXPECT_TRUE(flag) << i;
+    EXPECT_EQ(it->second, i * 4);
+  }
+  for (int i = 0; i < n; i++) {
+    auto [it, flag] = m.emplace(i * 2, i * 10);
+    EXPECT_FALSE(flag) << i;
+    EXPECT_EQ(it->second, i * 4);
+  }
+  EXPECT_EQ(m.size(), n);
+  EXPECT_LE(m.load_factor(), m.max_load_factor());
+
+  for (int i = 0; i < n; i++) {
+    EXPECT_TRUE(m.contains(i * 2));
+    EXPECT_FALSE(m.contains(i * 2 + 1));
+  }
+
+  for (int i = 0; i < n; i++) {
+    EXPECT_EQ(m.erase(i * 2), 1);
+    EXPECT_EQ(m.erase(i * 2), 0);
+    EXPECT_EQ(m.erase(i * 2 + 1), 0);
+  }
+  EXPECT_TRUE(m.empty());
+}
+
+TEST(test_flat_hash_map, random) {
+  flat_hash_map<int, int> m;
+  std::unordered_map<int, int> expected;
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, 2000);
+  for (int i = 0; i < 20000; i++) {
+    const int key = dist(gen);
+    if (gen() % 3 == 0) {
+      EXPECT_EQ(m.erase(key), expected.erase(key));
+    } else {
+      m[key] = i;
+      expected[key] = i;
+    }
+  }
+  EXPECT_EQ(m.size(), expected.size());
+  size_t cnt = 0;
+  for (auto &[k, v] : m) {
+    EXPECT_EQ(expected[k], v);
+    cnt++;
+  }
+  EXPECT_EQ(cnt, expected.size());
+}
+
+TEST(test_flat_hash_map, ctor) {
+  {
+    flat_hash_map<int, int> m = {{1, 2}, {4, 6}};
+    EXPECT_EQ(m.size(), 2);
+    EXPECT_EQ(m[1], 2);
+    EXPECT_EQ(m[4], 6);
+  }
+  {
+    vector<pair<int, int>> v = {{1, 2}, {4, 6}};
+    flat_hash_map<int, int> m(v.begin(), v.end());
+    EXPECT_EQ(m.size(), 2);
+    EXPECT_EQ(m[1], 2);
+    EXPECT_EQ(m[4], 6);
+  }
+  {
+    flat_hash_map<int, int> a = {{1, 2}, {4, 6}};
+    const auto b = a;
+    EXPECT_EQ(a, b);
+    auto c = move(a);
+    EXPECT_EQ(c, b);
+    EXPECT_TRUE(a.empty());
+  }
+}
+
+TEST(test_flat_hash_map, more) {
+  {
+    flat_hash_map<int, int> a = {{1, 2}, {4, 6}};
+    const auto b = a;
+    EXPECT_EQ(a.at(1), 2);
+    EXPECT_EQ(b.at(4), 6);
+    EXPECT_THROW(b.at(5), out_of_range);
+    a.clear();
+    EXPECT_TRUE(a.empty());
+    EXPECT_FALSE(a.contains(1));
+    a[7] = 8;
+    EXPECT_EQ(a.size(), 1);
+  }
+  {
+    flat_hash_map<int, int> a = {{1, 2}}, b = {{1, 2}}, c = {{1, 3}};
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    swap(a, c);
+    EXPECT_EQ(c, b);
+  }
+  {
+    flat_hash_map<int, int> a = {{1, 2}, {4, 6}, {3, 1}}, b = {{4, 6}};
+    erase_if(a, [](auto &kv) { return kv.first % 2 == 1; });
+    EXPECT_EQ(a, b);
+  }
+}
+
+TEST(test_flat_hash_map, reserve_rehash) {
+  flat_hash_map<int, int> m;
+  m.reserve(100);
+  const auto n = m.bucket_count();
+  EXPECT_GE(n, 100);
+  for (int i = 0; i < 100; i++)
+    m[i] = i;
+  EXPECT_EQ(m.bucket_count(), n);
+  m.rehash(n * 4);
+  EXPECT_GE(m.bucket_count(), n * 4);
+  for (int i = 0; i < 100; i++)
+    EXPECT_EQ(m[i], i);
+}
+
+TEST(test_flat_hash_map, try_emplace_insert_or_assign) {
+  flat_hash_map<int, int> a;
+  auto [it, flag] = a.insert_or_assign(1, 10);
+  EXPECT_TRUE(flag);
+  EXPECT_TRUE(it->first == 1 && it->second == 10);
+  auto [it2, flag2] = a.insert_or_assign(1, 20);
+  EXPECT_FALSE(flag2);
+  EXPECT_TRUE(it2->first == 1 && it2->second == 20);
+  auto [it3, flag3] = a.try_emplace(1, 30);
+  EXPECT_FALSE(flag3);
+  EXPECT_EQ(it3->second, 20);
+  auto [it4, flag4] = a.try_emplace(2, 30);
+  EXPECT_TRUE(flag4);
+  EXPECT_EQ(it4->second, 30);
+}
+
+namespace {
+struct throw_on_copy {
+  static inline int alive = 0;
+  throw_on_copy(int x) : v(x) { ++alive; }
+  throw_on_copy(const throw_on_copy &) { throw 1; }
+  ~throw_on_copy() { --alive; }
+  int v;
+};
+} // namespace
+
+TEST(test_flat_hash_map, throwing_constructor) {
+  {
+    flat_hash_map<int, throw_on_copy> m;
+    const throw_on_copy value(5);
+    for (int i = 0; i < 100; i++) {
+      EXPECT_ANY_THROW(m.insert_or_assign(i, value));
+      EXPECT_ANY_THROW(m.try_emplace(i, value));
+      EXPECT_TRUE(m.empty());
+      EXPECT_FALSE(m.contains(i));
+    }
+    EXPECT_TRUE(m.begin() == m.end());
+    m.try_emplace(1, 2);
+    EXPECT_EQ(m.size(), 1);
+    EXPECT_EQ(m.at(1).v, 2);
+    EXPECT_EQ(throw_on_copy::alive, 2);
+  }
+  EXPECT_EQ(throw_on_copy::alive, 0);
+}
+
+TEST(test_flat_hash_map, group) {
+  using namespace _flat_hash_table;
+  // check the first 8 control bytes of the selected group (maybe SIMD) and the portable one against a scalar loop
+  auto to_bits = [](auto mask) {
+    unsigned int bits = 0;
+    for (int i : mask) {
+      if (i < 8)
+        bits |= 1u << i;
+    }
+    return bits;
+  };
+  std::mt19937 gen(7);
+  ctrl_t ctrl[64] = {};
+  for (int round = 0; round < 1000; round++) {
+    for (auto &c : ctrl) {
+      const auto r = gen() % 4;
+      c = r == 0 ? ctrl_empty : r == 1 ? ctrl_deleted : r == 2 ? ctrl_sentinel : ctrl_t(gen() & 0x7F);
+    }
+    const h2_t h = gen() & 0x7F;
+    ctrl[gen() % 8] = h;
+    unsigned int matched = 0, empty = 0, empty_or_deleted = 0;
+    for (int i = 0; i < 8; i++) {
+      matched |= (ctrl[i] == h) << i;
+      empty |= is_empty(ctrl[i]) << i;
+      empty_or_deleted |= is_empty_or_deleted(ctrl[i]) << i;
+    }
+    const group g(ctrl);
+    const group_portable p(ctrl);
+    // match() may report false positives, they are filtered by the key comparison
+    EXPECT_EQ(to_bits(g.match(h)) & matched, matched);
+    EXPECT_EQ(to_bits(p.match(h)) & matched, matched);
+    EXPECT_EQ(to_bits(g.mask_empty()), empty);
+    EXPECT_EQ(to_bits(p.mask_empty()), empty);
+    EXPECT_EQ(to_bits(g.mask_empty_or_deleted()), empty_or_deleted);
+    EXPECT_EQ(to_bits(p.mask_empty_or_deleted()), empty_or_deleted);
+  }
+}
+
+TEST(test_flat_hash_set, basic) {
+  {
+    flat_hash_set<int> st;
+    EXPECT_TRUE(st.empty());
+    auto [it, flag] = st.insert(3);
+    EXPECT_TRUE(flag);
+    EXPECT_EQ(*it, 3);
+    EXPECT_EQ(st.size(), 1);
+    auto it2 = st.find(3);
+    EXPECT_TRUE(it2 != st.end());
+    EXPECT_EQ(*it2, 3);
+    EXPECT_EQ(it2, it);
+    auto [it3, flag2] = st.insert(3);
+    EXPECT_FALSE(flag2);
+  }
+  {
+    const int n = 100;
+    flat_hash_set<int> st;
+    for (int i = 0; i < n; i++) {
+      if (i % 2 == 0)
+        st.insert(i);
+    }
+    EXPECT_EQ(st.size(), n / 2);
+    for (int i = 0; i < n; i++) {
+      EXPECT_EQ(st.contains(i), (i % 2 == 0)) << i;
+    }
+  }
+  {
+    flat_hash_set<int> st = {1, 2, 3};
+    EXPECT_EQ(st.size(), 3);
+    int sum = 0;
+    for (auto x : st)
+      sum += x;
+    EXPECT_EQ(sum, 6);
+  }
+  {
+    flat_hash_set<int> a = {1, 2, 3, 4}, b = {2, 4};
+    erase_if(a, [](int x) { return x % 2 == 1; });
+    EXPECT_EQ(a, b);
+  }
+}
\ No newline at end of file
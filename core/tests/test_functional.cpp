@@ -40,6 +40,113 @@ TEST(test_function, free_function) {
   EXPECT_EQ(f(100), 300);
 }
 
+TEST(test_function, move_only_callable) {
+  function<int()> f([p = make_unique<int>(5)] { return *p; });
+  auto g = move(f);
+  EXPECT_FALSE(f);
+  EXPECT_EQ(g(), 5);
+}
+
+TEST(test_copyable_function, copy) {
+  int calls = 0;
+  copyable_function<int(int)> f([&calls, n = 0](int x) mutable {
+    ++calls;
+    return n += x;
+  });
+  auto g = f;
+  EXPECT_EQ(f(1), 1);
+  EXPECT_EQ(f(1), 2);
+  // g has its own copy of the state
+  EXPECT_EQ(g(5), 5);
+  EXPECT_EQ(calls, 3);
+
+  copyable_function<int(int)> h;
+  h = g;
+  EXPECT_EQ(h(1), 6);
+  EXPECT_EQ(g(1), 6);
+  h = copyable_function<int(int)>();
+  g = h;
+  EXPECT_FALSE(g);
+  g = foo;
+  h = g;
+  EXPECT_EQ(h(1), 3);
+}
+
+TEST(test_move_only_function, basic) {
+  move_only_function<int(int)> f([](int x) { return x + 1; });
+  EXPECT_TRUE(f);
+  EXPECT_EQ(f(1), 2);
+  EXPECT_FALSE(move_only_function<int(int)>(nullptr));
+  int (*null_ptr)(int) = nullptr;
+  EXPECT_TRUE(move_only_function<int(int)>(null_ptr) == nullptr);
+  EXPECT_EQ(move_only_function<int(int)>(foo)(2), 6);
+
+  // a move only callable, which is moved along with the function
+  auto p = make_unique<int>(5);
+  move_only_function<int()> g([p = move(p)] { return *p; });
+  auto h = move(g);
+  EXPECT_FALSE(g);
+  EXPECT_EQ(h(), 5);
+  g = [] { return 1; };
+  swap(g, h);
+  EXPECT_EQ(g(), 5);
+  EXPECT_EQ(h(), 1);
+  h = nullptr;
+  EXPECT_FALSE(h);
+}
+
+namespace {
+struct point {
+  int x = 0;
+  int sum(int y) const { return x + y; }
+};
+} // namespace
+
+TEST(test_move_only_function, invoke) {
+  point p{.x = 3};
+  move_only_function<int(const point &)> x(&point::x);
+  EXPECT_EQ(x(p), 3);
+  move_only_function<int(point &, int)> sum(&point::sum);
+  EXPECT_EQ(sum(p, 4), 7);
+  int (point::*null_member)(int) const = nullptr;
+  EXPECT_FALSE(move_only_function<int(point &, int)>(null_member));
+
+  // a reference result is passed through
+  move_only_function<int &(point &)> ref([](point &q) -> int & { return q.x; });
+  ref(p) = 10;
+  EXPECT_EQ(p.x, 10);
+  move_only_function<void(int)> discard(foo);
+  discard(1);
+}
+
+TEST(test_move_only_function, inline_buffer) {
+  struct counted {
+    counted(int *n) : count(n) { ++*count; }
+    counted(counted &&rhs) noexcept : count(rhs.count) { ++*count; }
+    ~counted() { --*count; }
+    int operator()() const { return *count; }
+    int *count;
+    char padding[40];
+  };
+  static_assert(move_only_function<int(int)>::is_stored_inline<int (*)(int)>);
+  static_assert(!move_only_function<int()>::is_stored_inline<counted>);
+  static_assert(move_only_function<int(), 64>::is_stored_inline<counted>);
+
+  // each live counted is counted, so the callable must be destroyed exactly once in either storage
+  int n = 0;
+  {
+    move_only_function<int(), 64> f(counted{&n});
+    move_only_function<int()> g(counted{&n});
+    EXPECT_EQ(n, 2);
+    auto f2 = move(f);
+    auto g2 = move(g);
+    EXPECT_EQ(n, 2);
+    EXPECT_EQ(f2(), 2);
+    EXPECT_EQ(g2(), 2);
+  }
+  EXPECT_EQ(n, 0);
+}
+
 TEST(test_reference_wrapper, basic) {
   {
     using int_ref = ::aria::reference_wrapper<int>;
@@ -46,3 +46,58 @@ TEST(test_hash_map, more_test) {
   m.clear();
   EXPECT_EQ(m.size(), 0);
 }
+
+TEST(test_hash_map, copy) {
+  hash_table<int, int> a = {{1, 2}, {3, 4}};
+  auto b = a;
+  a.clear();
+  a.insert(pair(5, 6));
+  EXPECT_EQ(b.size(), 2);
+  EXPECT_TRUE(b.contains(1));
+  EXPECT_TRUE(b.contains(3));
+  EXPECT_FALSE(b.contains(5));
+  b.erase(1);
+  EXPECT_EQ(b.size(), 1);
+}
+
+TEST(test_hash_map, incremental_rehash) {
+  hash_table<int, int> m;
+  EXPECT_FALSE(m.incremental_rehash());
+  m.incremental_rehash(true);
+  EXPECT_TRUE(m.incremental_rehash());
+
+  const int n = 5000;
+  bool rehashing = false;
+  auto first = m.insert(pair(-1, -1)).first;
+  for (int i = 0; i < n; i++) {
+    auto [it, flag] = m.insert(pair(i * 2, i));
+    EXPECT_TRUE(flag) << i;
+    rehashing |= m.is_rehashing();
+    if (i % 6 == 0)
+      EXPECT_EQ(m.erase(i), 1) << i;
+  }
+  EXPECT_TRUE(rehashing);
+  EXPECT_EQ(first->second, -1); // nodes are relinked, iterators stay valid
+
+  for (int i = 0; i < 2 * n; i++)
+    EXPECT_EQ(m.contains(i), i % 2 == 0 && (i % 6 != 0 || i >= n)) << i;
+
+  m.incremental_rehash(false);
+  EXPECT_FALSE(m.is_rehashing());
+  EXPECT_EQ(m.size(), n + 1 - (n + 5) / 6);
+}
+
+TEST(test_hash_map, incremental_rehash_low_load_factor) {
+  hash_table<int, int> m;
+  m.max_load_factor(0.1);
+  m.incremental_rehash(true);
+  for (int i = 0; i < 5000; i++) {
+    const auto old_bucket_count = m.bucket_count();
+    const bool was_rehashing = m.is_rehashing();
+    m.insert(pair(i, i));
+    if (m.bucket_count() != old_bucket_count && old_bucket_count > 0)
+      EXPECT_FALSE(was_rehashing) << i; // the previous migration is done before the table grows again
+  }
+  EXPECT_EQ(m.size(), 5000);
+  EXPECT_LE(m.load_factor(), m.max_load_factor());
+}
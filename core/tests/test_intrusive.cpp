@@ -0,0 +1,163 @@
+#include "intrusive_list.h"
+#include "intrusive_unordered_set.h"
+#include "mystring.h"
+#include "vector.h"
+#include "gtest/gtest.h"
+
+using namespace aria;
+
+namespace {
+struct session {
+  session(int i) : id(i) {}
+  int id;
+  string name;
+  list_hook lru_hook;
+  unordered_set_hook index_hook;
+};
+
+struct session_hash {
+  size_t operator()(const session &s) const { return hash<int>()(s.id); }
+  size_t operator()(int id) const { return hash<int>()(id); }
+};
+
+struct session_equal {
+  bool operator()(const session &a, const session &b) const { return a.id == b.id; }
+  bool operator()(const session &a, int id) const { return a.id == id; }
+};
+
+using lru_list = intrusive_list<session, &session::lru_hook>;
+using session_index = intrusive_unordered_set<session, &session::index_hook, session_hash, session_equal>;
+
+static_assert(bidirectional_iterator<lru_list::iterator>);
+static_assert(bidirectional_iterator<lru_list::const_iterator>);
+static_assert(forward_iterator<session_index::iterator>);
+static_assert(forward_iterator<session_index::const_iterator>);
+
+vector<int> ids(const lru_list &l) {
+  vector<int> res;
+  for (auto &s : l)
+    res.push_back(s.id);
+  return res;
+}
+} // namespace
+
+TEST(test_intrusive_list, basic) {
+  vector<session> sessions;
+  for (int i = 0; i < 5; i++)
+    sessions.emplace_back(i);
+
+  lru_list l;
+  EXPECT_TRUE(l.empty());
+  for (auto &s : sessions)
+    l.push_back(s);
+  EXPECT_EQ(l.size(), 5);
+  EXPECT_EQ(l.front().id, 0);
+  EXPECT_EQ(l.back().id, 4);
+  EXPECT_TRUE(sessions[2].lru_hook.is_linked());
+
+  l.erase(sessions[2]);
+  EXPECT_FALSE(sessions[2].lru_hook.is_linked());
+  l.push_front(sessions[2]);
+  l.splice(l.end(), sessions[0]);
+  EXPECT_EQ(ids(l), (vector<int>{2, 1, 3, 4, 0}));
+  EXPECT_EQ(&*l.iterator_to(sessions[3]), &sessions[3]);
+
+  auto it = l.erase(l.iterator_to(sessions[3]));
+  EXPECT_EQ(it->id, 4);
+  l.insert(it, sessions[3]);
+  l.pop_front();
+  l.pop_back();
+  EXPECT_EQ(ids(l), (vector<int>{1, 3, 4}));
+
+  // a copy of an object is not linked
+  session copy = sessions[1];
+  EXPECT_FALSE(copy.lru_hook.is_linked());
+
+  lru_list l2 = move(l);
+  EXPECT_TRUE(l.empty());
+  EXPECT_EQ(ids(l2), (vector<int>{1, 3, 4}));
+  swap(l, l2);
+  EXPECT_EQ(ids(l), (vector<int>{1, 3, 4}));
+  l2.push_back(sessions[0]);
+  l2 = move(l);
+  EXPECT_FALSE(sessions[0].lru_hook.is_linked());
+  EXPECT_EQ(ids(l2), (vector<int>{1, 3, 4}));
+
+  l2.clear();
+  EXPECT_TRUE(l2.empty());
+  EXPECT_TRUE(none_of(sessions.begin(), sessions.end(), [](const session &s) { return s.lru_hook.is_linked(); }));
+}
+
+TEST(test_intrusive_unordered_set, basic) {
+  vector<session> sessions;
+  for (int i = 0; i < 100; i++)
+    sessions.emplace_back(i);
+  sessions[42].name = "forty-two";
+
+  session_index index;
+  for (auto &s : sessions)
+    EXPECT_TRUE(index.insert(s).second);
+  EXPECT_EQ(index.size(), 100);
+  EXPECT_LE(index.load_factor(), index.max_load_factor());
+
+  session duplicate(7);
+  auto [it, inserted] = index.insert(duplicate);
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(&*it, &sessions[7]);
+  EXPECT_FALSE(duplicate.index_hook.is_linked());
+
+  EXPECT_EQ(index.find(42)->name, "forty-two");
+  EXPECT_TRUE(index.contains(99));
+  EXPECT_FALSE(index.contains(100));
+
+  index.erase(sessions[42]);
+  EXPECT_FALSE(index.contains(42));
+  EXPECT_EQ(index.erase(43), 1);
+  EXPECT_EQ(index.erase(43), 0);
+  index.erase(index.find(44));
+  EXPECT_EQ(index.size(), 97);
+
+  int n = 0, sum = 0;
+  for (auto &s : index) {
+    n++;
+    sum += s.id;
+  }
+  EXPECT_EQ(n, 97);
+  EXPECT_EQ(sum, 99 * 100 / 2 - 42 - 43 - 44);
+
+  session_index index2 = move(index);
+  EXPECT_TRUE(index.empty());
+  EXPECT_TRUE(index2.contains(0));
+  index2.clear();
+  EXPECT_TRUE(none_of(sessions.begin(), sessions.end(), [](const session &s) { return s.index_hook.is_linked(); }));
+}
+
+// an object can be in a list and a set at the same time, e.g. an LRU cache with an index
+TEST(test_intrusive_unordered_set, lru_with_index) {
+  vector<session> sessions;
+  for (int i = 0; i < 8; i++)
+    sessions.emplace_back(i);
+
+  session_index index(16);
+  lru_list lru;
+  auto touch = [&](int id) {
+    if (auto it = index.find(id); it != index.end()) {
+      lru.splice(lru.begin(), *it);
+      return;
+    }
+    if (lru.size() == 4) {
+      index.erase(lru.back());
+      lru.pop_back();
+    }
+    index.insert(sessions[id]);
+    lru.push_front(sessions[id]);
+  };
+
+  for (int id : {0, 1, 2, 3, 0, 4, 5, 0, 6})
+    touch(id);
+  EXPECT_EQ(ids(lru), (vector<int>{6, 0, 5, 4}));
+  EXPECT_EQ(index.size(), 4);
+  for (int id : {6, 0, 5, 4})
+    EXPECT_TRUE(index.contains(id));
+  EXPECT_EQ(index.bucket_count(), 16);
+}
\ No newline at end of file
@@ -239,6 +239,30 @@ TEST(test_list, sort) {
   }
 }
 
+TEST(test_list, sort_stable_and_by_pointers) {
+  // sorted by the first member only, the second records the original order
+  list<pair<int, int>> a;
+  for (int i = 0; i < 1000; i++)
+    a.emplace_back((i * 7919) % 13, i);
+  auto b = a;
+  auto cmp = [](const auto &x, const auto &y) { return x.first < y.first; };
+  a.sort(cmp);
+  EXPECT_EQ(a.size(), 1000);
+  EXPECT_TRUE(is_sorted(a.begin(), a.end()));
+
+  b.sort_by_pointers(cmp);
+  EXPECT_EQ(b.size(), 1000);
+  EXPECT_TRUE(is_sorted(b.begin(), b.end(), cmp));
+  EXPECT_EQ(b.back().first, 12);
+  int n = 0;
+  for (auto it = b.end(); it != b.begin(); --it)
+    n++;
+  EXPECT_EQ(n, 1000);
+  b.push_front({-1, 0});
+  b.sort_by_pointers();
+  EXPECT_EQ(b.front(), (pair<int, int>{-1, 0}));
+}
+
 TEST(test_list, unique) {
   {
     list<int> a;
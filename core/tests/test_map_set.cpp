@@ -186,4 +186,58 @@ TEST(test_map, insert_or_assign) {
     EXPECT_FALSE(flag2);
     EXPECT_TRUE(it->first == 1 && it->second == 20);
   }
-}
\ No newline at end of file
+}
+TEST(test_map, sorted_unique) {
+  {
+    map<int, int> m(sorted_unique, {{1, 2}, {4, 6}, {7, 8}});
+    EXPECT_EQ(m.size(), 3);
+    EXPECT_EQ(m.begin()->first, 1);
+    EXPECT_EQ(m[4], 6);
+    EXPECT_EQ(m[7], 8);
+  }
+  {
+    vector<pair<int, int>> v;
+    for (int i = 0; i < 1000; i++)
+      v.push_back(pair(i * 2, i));
+    map<int, int> m(sorted_unique, v.begin(), v.end());
+    EXPECT_EQ(m.size(), 1000);
+    auto it = v.begin();
+    for (auto &[k, value] : m) {
+      EXPECT_EQ(k, it->first);
+      EXPECT_EQ(value, it->second);
+      ++it;
+    }
+    // the tree stays valid for the following modifications
+    for (int i = 0; i < 1000; i++)
+      m[i * 2 + 1] = i;
+    for (int i = 0; i < 2000; i += 3)
+      EXPECT_EQ(m.erase(i), 1);
+    EXPECT_EQ(m.size(), 1333);
+    int expected = 1;
+    for (auto &[k, value] : m) {
+      EXPECT_EQ(k, expected);
+      expected += expected % 3 == 1 ? 1 : 2;
+    }
+  }
+  {
+    set<int> st(sorted_unique, {});
+    EXPECT_TRUE(st.empty());
+    EXPECT_EQ(st.begin(), st.end());
+  }
+}
+
+TEST(test_set, insert_range) {
+  set<int> st = {1, 4, 9};
+  vector<int> v = {0, 1, 2, 3, 4, 10};
+  st.insert_range(sorted_unique, v.begin(), v.end());
+  vector<int> expected = {0, 1, 2, 3, 4, 9, 10};
+  EXPECT_EQ(st.size(), expected.size());
+  EXPECT_TRUE(equal(st.begin(), st.end(), expected.begin()));
+  EXPECT_EQ(*st.begin(), 0);
+  st.insert_range(sorted_unique, v.end(), v.end());
+  EXPECT_EQ(st.size(), expected.size());
+  st.insert(5);
+  st.erase(0);
+  EXPECT_EQ(*st.begin(), 1);
+  EXPECT_TRUE(st.contains(5));
+}
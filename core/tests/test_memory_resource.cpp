@@ -0,0 +1,146 @@
+#include "map.h"
+#include "memory_resource.h"
+#include "mystring.h"
+#include "unordered_map.h"
+#include "vector.h"
+#include "gtest/gtest.h"
+
+using namespace aria;
+
+namespace {
+// forwards to upstream and counts the bytes in use
+class counting_resource : public pmr::memory_resource {
+public:
+  size_t in_use = 0;
+  size_t n_allocations = 0;
+
+private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    in_use += bytes;
+    n_allocations++;
+    return pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    in_use -= bytes;
+    pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const memory_resource &other) const noexcept override { return this == &other; }
+};
+
+bool is_aligned(void *p, size_t alignment) { return reinterpret_cast<size_t>(p) % alignment == 0; }
+} // namespace
+
+TEST(test_memory_resource, default_resource) {
+  EXPECT_EQ(pmr::get_default_resource(), pmr::new_delete_resource());
+  counting_resource r;
+  EXPECT_EQ(pmr::set_default_resource(&r), pmr::new_delete_resource());
+  {
+    pmr::vector<int> v;
+    v.push_back(1);
+    EXPECT_GT(r.in_use, 0);
+  }
+  EXPECT_EQ(r.in_use, 0);
+  EXPECT_EQ(pmr::set_default_resource(nullptr), &r);
+  EXPECT_EQ(pmr::get_default_resource(), pmr::new_delete_resource());
+  EXPECT_THROW((void)pmr::null_memory_resource()->allocate(1), bad_alloc);
+}
+
+TEST(test_memory_resource, polymorphic_allocator) {
+  counting_resource r;
+  pmr::polymorphic_allocator<int> a(&r);
+  pmr::polymorphic_allocator<double> b = a;
+  EXPECT_EQ(b.resource(), &r);
+  EXPECT_TRUE(a == b);
+  EXPECT_FALSE(a == pmr::polymorphic_allocator<int>());
+  auto p = a.allocate(10);
+  EXPECT_EQ(r.in_use, 10 * sizeof(int));
+  a.deallocate(p, 10);
+  EXPECT_EQ(r.in_use, 0);
+}
+
+TEST(test_memory_resource, monotonic_buffer_resource) {
+  counting_resource upstream;
+  {
+    char buffer[256];
+    pmr::monotonic_buffer_resource r(buffer, sizeof(buffer), &upstream);
+    auto p1 = r.allocate(100, 1);
+    auto p2 = r.allocate(8, 8);
+    EXPECT_EQ(p1, buffer);
+    EXPECT_TRUE(is_aligned(p2, 8));
+    EXPECT_EQ(upstream.n_allocations, 0);
+    r.deallocate(p1, 100, 1);
+
+    auto p3 = r.allocate(1000, 64);
+    EXPECT_TRUE(is_aligned(p3, 64));
+    EXPECT_EQ(upstream.n_allocations, 1);
+    for (int i = 0; i < 1000; i++)
+      EXPECT_TRUE(is_aligned(r.allocate(24, 16), 16));
+    EXPECT_GT(upstream.n_allocations, 1);
+
+    r.release();
+    EXPECT_EQ(upstream.in_use, 0);
+    EXPECT_EQ(r.allocate(100, 1), buffer);
+    r.allocate(10000);
+  }
+  EXPECT_EQ(upstream.in_use, 0);
+}
+
+TEST(test_memory_resource, pool_resource) {
+  counting_resource upstream;
+  {
+    pmr::unsynchronized_pool_resource r(pmr::pool_options{16, 256}, &upstream);
+    EXPECT_EQ(r.options().largest_required_pool_block, 256);
+    EXPECT_EQ(r.options().max_blocks_per_chunk, 16);
+    vector<void *> blocks;
+    for (size_t size = 1; size <= 300; size++)
+      blocks.push_back(r.allocate(size));
+    for (auto p : blocks)
+      EXPECT_TRUE(is_aligned(p, 16));
+    // a freed block is reused by the next allocation of its size
+    r.deallocate(blocks[20], 21);
+    EXPECT_EQ(r.allocate(30), blocks[20]);
+
+    auto large = r.allocate(1000, 64);
+    EXPECT_TRUE(is_aligned(large, 64));
+    const auto in_use = upstream.in_use;
+    r.deallocate(large, 1000, 64);
+    EXPECT_LT(upstream.in_use, in_use);
+    r.allocate(5000);
+  }
+  EXPECT_EQ(upstream.in_use, 0);
+
+  {
+    pmr::synchronized_pool_resource r(&upstream);
+    auto p = r.allocate(32);
+    r.deallocate(p, 32);
+    r.release();
+    EXPECT_EQ(upstream.in_use, 0);
+  }
+}
+
+TEST(test_memory_resource, containers) {
+  counting_resource upstream;
+  {
+    pmr::monotonic_buffer_resource r(&upstream);
+    pmr::vector<int> v(&r);
+    for (int i = 0; i < 100; i++)
+      v.push_back(i);
+    pmr::string s("a string longer than the small buffer", &r);
+    s += s;
+    EXPECT_EQ(s.get_allocator().resource(), &r);
+
+    pmr::unordered_map<int, pmr::string> m(&r);
+    for (int i = 0; i < 100; i++)
+      m[i] = "x";
+    EXPECT_EQ(m.size(), 100);
+    EXPECT_EQ(m.get_allocator().resource(), &r);
+
+    pmr::map<int, int> ordered(&r);
+    for (int i = 0; i < 100; i++)
+      ordered[i] = i;
+    auto nh = ordered.extract(5);
+    EXPECT_EQ(nh.get_allocator().resource(), &r);
+    EXPECT_GT(upstream.in_use, 0);
+  }
+  EXPECT_EQ(upstream.in_use, 0);
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "list.h"
+#include "map.h"
+#include "pool_allocator.h"
+#include "set.h"
+#include "unordered_map.h"
+#include "vector.h"
+#include "gtest/gtest.h"
+#include <thread>
+
+using namespace aria;
+
+TEST(test_pool_allocator, base) {
+  pool_allocator<int> alloc;
+  vector<int *> v;
+  for (int i = 0; i < 1000; i++) {
+    v.push_back(alloc.allocate(1));
+    *v.back() = i;
+  }
+  for (int i = 0; i < 1000; i++)
+    EXPECT_EQ(*v[i], i);
+  // the blocks of the first slab are handed out in address order
+  for (int i = 1; i < 16; i++)
+    EXPECT_EQ(reinterpret_cast<char *>(v[i]) - reinterpret_cast<char *>(v[i - 1]), 16);
+
+  auto pool = _pool_allocator::local_pool<pool_allocator<int>::s_block_size>();
+  const auto in_use = pool->in_use();
+  for (auto p : v)
+    alloc.deallocate(p, 1);
+  EXPECT_EQ(pool->in_use(), in_use - 1000);
+
+  // a freed block is reused first
+  auto p = alloc.allocate(1);
+  EXPECT_EQ(p, v.back());
+  alloc.deallocate(p, 1);
+
+  auto arr = alloc.allocate(100);
+  arr[99] = 1;
+  alloc.deallocate(arr, 100);
+}
+
+TEST(test_pool_allocator, size_class) {
+  struct alignas(64) over_aligned {
+    char c[64];
+  };
+  struct large {
+    char c[1024];
+  };
+  static_assert(pool_allocator<char>::s_block_size == 16);
+  static_assert(pool_allocator<double[3]>::s_block_size == 32);
+  static_assert(pool_allocator<int>::s_pooled);
+  static_assert(!pool_allocator<over_aligned>::s_pooled);
+  static_assert(!pool_allocator<large>::s_pooled);
+  static_assert(is_same_v<allocator_traits<pool_allocator<int>>::rebind_alloc<char>, pool_allocator<char>>);
+  EXPECT_TRUE(pool_allocator<int>() == pool_allocator<char>());
+
+  // over-aligned types go to the aligned operator new
+  pool_allocator<over_aligned> alloc;
+  for (size_t n : {1, 3}) {
+    auto p = alloc.allocate(n);
+    EXPECT_EQ(reinterpret_cast<size_t>(p) % 64, 0);
+    alloc.deallocate(p, n);
+  }
+}
+
+TEST(test_pool_allocator, containers) {
+  {
+    list<int, pool_allocator<int>> l = {1, 2, 3};
+    l.push_back(4);
+    auto nh = l.extract(l.begin());
+    l.insert(l.end(), move(nh));
+    EXPECT_EQ(l, (list<int, pool_allocator<int>>{2, 3, 4, 1}));
+  }
+  {
+    map<int, int, less<int>, pool_allocator<pair<const int, int>>> m;
+    for (int i = 0; i < 1000; i++)
+      m[i] = i;
+    for (int i = 0; i < 1000; i += 2)
+      m.erase(i);
+    const auto copy = m;
+    EXPECT_EQ(copy, m);
+    EXPECT_EQ(m.size(), 500);
+    auto nh = m.extract(1);
+    EXPECT_EQ(nh.mapped(), 1);
+  }
+  {
+    set<int, less<int>, pool_allocator<int>> a = {1, 2, 3}, b;
+    b.insert(a.extract(2));
+    EXPECT_EQ(a.size(), 2);
+    EXPECT_TRUE(b.contains(2));
+  }
+  {
+    unordered_map<int, int, hash<int>, equal_to<int>, pool_allocator<pair<const int, int>>> m;
+    for (int i = 0; i < 1000; i++)
+      m[i] = i * 2;
+    for (int i = 0; i < 1000; i++)
+      EXPECT_EQ(m[i], i * 2);
+    EXPECT_EQ(erase_if(m, [](auto &kv) { return kv.first % 2 == 0; }), 500);
+  }
+}
+TEST(test_pool_allocator, threads) {
+  pool_allocator<int> alloc;
+  int *x = nullptr, *y = nullptr;
+  std::thread t1([&] {
+    y = alloc.allocate(1);
+    // the second thread takes a block of its own slab and frees a block of the first one, then exits
+    std::thread t2([&] {
+      x = alloc.allocate(1);
+      alloc.deallocate(y, 1);
+    });
+    t2.join();
+    alloc.deallocate(x, 1);
+
+    vector<int *> v;
+    for (int i = 0; i < 10000; i++) {
+      v.push_back(alloc.allocate(1));
+      *v.back() = i;
+    }
+    for (int i = 0; i < 10000; i++)
+      EXPECT_EQ(*v[i], i);
+    for (auto p : v)
+      alloc.deallocate(p, 1);
+  });
+  t1.join();
+
+  // the blocks freed by a consumer thread are reused by the producer
+  vector<int *> v(100000);
+  for (int round = 0; round < 3; round++) {
+    std::thread producer([&] {
+      for (auto &p : v) {
+        p = alloc.allocate(1);
+        *p = round;
+      }
+    });
+    producer.join();
+    std::thread consumer([&] {
+      for (auto p : v) {
+        EXPECT_EQ(*p, round);
+        alloc.deallocate(p, 1);
+      }
+    });
+    consumer.join();
+  }
+}
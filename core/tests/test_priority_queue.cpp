@@ -14,3 +14,16 @@ TEST(test_priority_queue, basic) {
   }
   EXPECT_EQ(sorted, u);
 }
+
+TEST(test_priority_queue, compare) {
+  vector<int> v = {3, 8, 1, 9, 4, 4, 7, 2, 6, 5, 0};
+  priority_queue<int, vector<int>, greater<int>> q(v.begin(), v.end());
+  q.push(-1);
+  q.emplace(10);
+  vector<int> sorted;
+  while (!q.empty()) {
+    sorted.push_back(q.top());
+    q.pop();
+  }
+  EXPECT_EQ(sorted, vector<int>({-1, 0, 1, 2, 3, 4, 4, 5, 6, 7, 8, 9, 10}));
+}
\ No newline at end of file
@@ -26,6 +26,24 @@ TEST(test_queue, basic) {
   EXPECT_EQ(q.size(), 0);
 }
 
+TEST(test_queue, bulk) {
+  queue<int> q;
+  int in[100];
+  for (int i = 0; i < 100; i++)
+    in[i] = i;
+  q.push_range(in);
+  q.push(100);
+  q.emplace(101);
+  EXPECT_EQ(q.size(), 102);
+  int out[64];
+  EXPECT_EQ(q.pop_n(64, out), out + 64);
+  EXPECT_EQ(out[63], 63);
+  EXPECT_EQ(q.front(), 64);
+  EXPECT_EQ(q.pop_n(64, out), out + 38);
+  EXPECT_EQ(out[37], 101);
+  EXPECT_TRUE(q.empty());
+}
+
 TEST(test_stack, basic) {
   stack<int> st;
   EXPECT_TRUE(st.empty());
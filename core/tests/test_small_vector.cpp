@@ -0,0 +1,138 @@
+#include "mystring.h"
+#include "small_vector.h"
+#include "gtest/gtest.h"
+
+using namespace aria;
+
+namespace {
+using T = small_vector<int, 4>;
+static_assert(contiguous_iterator<T::iterator>);
+static_assert(contiguous_iterator<T::const_iterator>);
+
+// points into itself, so it can't be moved by copying its bytes
+struct SelfRef {
+  SelfRef(int x) : value(x) {}
+  SelfRef(const SelfRef &rhs) : value(rhs.value) {}
+  SelfRef &operator=(const SelfRef &rhs) {
+    value = rhs.value;
+    return *this;
+  }
+  bool operator==(const SelfRef &rhs) const { return value == rhs.value; }
+  bool valid() const { return self == this; }
+
+  int value;
+  const SelfRef *self = this;
+};
+
+template <class V> bool equals(const V &v, const vector<int> &expected) {
+  if (v.size() != expected.size())
+    return false;
+  for (size_t i = 0; i < v.size(); i++) {
+    if (!(v[i] == expected[i]))
+      return false;
+  }
+  return true;
+}
+} // namespace
+
+TEST(test_small_vector, basic) {
+  small_vector<int, 4> v;
+  EXPECT_TRUE(v.empty());
+  EXPECT_EQ(v.capacity(), 4);
+  for (int i = 0; i < 4; i++)
+    v.push_back(i);
+  EXPECT_TRUE(v.is_inline());
+  v.push_back(4);
+  EXPECT_FALSE(v.is_inline());
+  EXPECT_EQ(v, (small_vector<int, 4>{0, 1, 2, 3, 4}));
+  EXPECT_EQ(v.front(), 0);
+  EXPECT_EQ(v.back(), 4);
+  EXPECT_THROW(v.at(5), out_of_range);
+
+  v.pop_back();
+  v.shrink_to_fit();
+  EXPECT_TRUE(v.is_inline());
+  EXPECT_EQ(v, (small_vector<int, 4>{0, 1, 2, 3}));
+
+  // the argument is an element which moves during the growth
+  v.push_back(v[0]);
+  v.emplace_back(v[1]);
+  EXPECT_EQ(v, (small_vector<int, 4>{0, 1, 2, 3, 0, 1}));
+}
+
+TEST(test_small_vector, copy_and_move) {
+  small_vector<string, 2> a = {"a", "b"}, b = {"c", "d", "a string longer than the small buffer"};
+  auto c = a;
+  EXPECT_EQ(c, a);
+  auto d = move(b);
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(d.back(), "a string longer than the small buffer");
+
+  swap(a, d);
+  EXPECT_EQ(a.size(), 3);
+  EXPECT_EQ(d, c);
+  EXPECT_TRUE(d.is_inline());
+  a = c;
+  EXPECT_EQ(a, c);
+  c = move(d);
+  EXPECT_TRUE(d.empty());
+  EXPECT_EQ(c, a);
+}
+
+TEST(test_small_vector, insert_and_erase) {
+  small_vector<SelfRef, 3> v = {1, 2, 3};
+  v.insert(v.begin() + 1, SelfRef(4));
+  v.insert_range(v.begin(), small_vector<int, 2>{5, 6});
+  EXPECT_EQ(v, (small_vector<SelfRef, 3>{5, 6, 1, 4, 2, 3}));
+  v.erase(v.begin() + 1);
+  v.erase(v.begin() + 1, v.begin() + 3);
+  EXPECT_EQ(v, (small_vector<SelfRef, 3>{5, 2, 3}));
+  EXPECT_TRUE(all_of(v.begin(), v.end(), [](const SelfRef &x) { return x.valid(); }));
+
+  small_vector<int, 8> u = {1, 2, 3, 2, 4, 2};
+  EXPECT_EQ(erase(u, 2), 3);
+  EXPECT_EQ(u, (small_vector<int, 8>{1, 3, 4}));
+  EXPECT_EQ(erase_if(u, [](int i) { return i > 2; }), 2);
+  EXPECT_EQ(u, (small_vector<int, 8>{1}));
+  u.resize(3, 7);
+  EXPECT_EQ(u, (small_vector<int, 8>{1, 7, 7}));
+}
+
+TEST(test_small_vector, insert_positions) {
+  for (int size = 0; size < 10; size++) {
+    for (int idx = 0; idx <= size; idx++) {
+      for (int n = 0; n < 6; n++) {
+        vector<int> expected, range;
+        small_vector<SelfRef, 4> v;
+        small_vector<int, 4> u;
+        for (int i = 0; i < size; i++) {
+          v.push_back(i);
+          u.push_back(i);
+          expected.push_back(i);
+        }
+        for (int i = 0; i < n; i++)
+          range.push_back(100 + i);
+        expected.insert_range(expected.begin() + idx, range);
+
+        EXPECT_EQ(v.insert_range(v.begin() + idx, range), v.begin() + idx);
+        EXPECT_EQ(u.insert_range(u.begin() + idx, range), u.begin() + idx);
+        EXPECT_TRUE(equals(v, expected));
+        EXPECT_TRUE(equals(u, expected));
+        EXPECT_TRUE(all_of(v.begin(), v.end(), [](const SelfRef &x) { return x.valid(); }));
+
+        v.insert(v.begin() + idx, SelfRef(-1));
+        u.insert(u.begin() + idx, -1);
+        expected.insert(expected.begin() + idx, -1);
+        EXPECT_TRUE(equals(v, expected));
+        EXPECT_TRUE(equals(u, expected));
+        EXPECT_TRUE(all_of(v.begin(), v.end(), [](const SelfRef &x) { return x.valid(); }));
+      }
+    }
+  }
+
+  small_vector<SelfRef, 4> v;
+  for (int i = 0; i < 5000; i++)
+    v.insert(v.begin(), SelfRef(i));
+  EXPECT_EQ(v.front().value, 4999);
+  EXPECT_EQ(v.back().value, 0);
+}
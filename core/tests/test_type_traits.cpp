@@ -104,6 +104,8 @@ void test_traits() {
   static_assert(is_constructible_v<AA, int>);
   static_assert(!is_constructible_v<AA>);
   static_assert(is_constructible_v<Base>);
+  static_assert(is_nothrow_constructible_v<int, int>);
+  static_assert(!is_nothrow_constructible_v<AA, int>);
 
   static_assert(is_destructible_v<int>);
   static_assert(!is_destructible_v<void>);
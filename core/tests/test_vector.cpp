@@ -1,4 +1,6 @@
 #include "vector.h"
+#include "mystring.h"
+#include "unique_ptr.h"
 #include "gtest/gtest.h"
 
 using namespace aria;
@@ -27,6 +29,20 @@ struct A {
   ~A() { n_dtor++; }
 };
 
+// points into itself, so it can't be moved by copying its bytes
+struct SelfRef {
+  SelfRef(int x) : value(x) {}
+  SelfRef(const SelfRef &rhs) : value(rhs.value) {}
+  SelfRef &operator=(const SelfRef &rhs) {
+    value = rhs.value;
+    return *this;
+  }
+  bool valid() const { return self == this; }
+
+  int value;
+  const SelfRef *self = this;
+};
+
 TEST(test_vector, basic) {
   vector<int> v(2, 100);
   EXPECT_EQ(v.size(), 2);
@@ -261,4 +277,114 @@ TEST(test_vector, insert_and_erase) {
     v.erase(v.begin() + 2);
     EXPECT_EQ(v, vector({1, 2, 3, 4}));
   }
-}
\ No newline at end of file
+}
+
+TEST(test_vector, trivially_relocatable) {
+  static_assert(is_trivially_relocatable_v<int>);
+  static_assert(is_trivially_relocatable_v<pair<const int, string>>);
+  static_assert(is_trivially_relocatable_v<unique_ptr<int>>);
+  static_assert(is_trivially_relocatable_v<vector<string>>);
+  static_assert(!is_trivially_relocatable_v<A>);
+  static_assert(!is_trivially_relocatable_v<SelfRef>);
+  {
+    vector<SelfRef> v;
+    for (int i = 0; i < 100; i++)
+      v.push_back(i);
+    v.insert(v.begin(), v[99]);
+    v.insert(v.begin() + 50, SelfRef(-1));
+    v.erase(v.begin() + 50);
+    v.erase(v.begin() + 1, v.begin() + 11);
+    EXPECT_EQ(v.size(), 91);
+    EXPECT_EQ(v[0].value, 99);
+    for (int i = 1; i < v.size(); i++)
+      EXPECT_EQ(v[i].value, i + 9);
+    EXPECT_TRUE(all_of(v.begin(), v.end(), [](const SelfRef &x) { return x.valid(); }));
+  }
+  {
+    vector<unique_ptr<int>> v;
+    for (int i = 0; i < 100; i++)
+      v.emplace_back(make_unique<int>(i));
+    v.insert(v.begin(), make_unique<int>(-1));
+    v.erase(v.begin() + 1);
+    v.erase(v.begin() + 1, v.begin() + 10);
+    EXPECT_EQ(v.size(), 91);
+    EXPECT_EQ(*v[0], -1);
+    for (int i = 1; i < v.size(); i++)
+      EXPECT_EQ(*v[i], i + 9);
+  }
+  {
+    vector<string> v;
+    for (int i = 0; i < 100; i++)
+      v.push_back(i % 2 ? string("short") : string("a string longer than the small buffer"));
+    v.insert(v.begin(), v[1]);
+    v.shrink_to_fit();
+    EXPECT_EQ(v[0], "short");
+    EXPECT_EQ(v[1], "a string longer than the small buffer");
+    EXPECT_EQ(v[100], "short");
+    v[0] += "er";
+    EXPECT_EQ(v[0], "shorter");
+  }
+}
+
+TEST(test_vector, append_and_insert_range) {
+  {
+    vector<int> v = {1, 2};
+    const int arr[] = {3, 4, 5};
+    v.append_range(arr);
+    EXPECT_EQ(v, vector({1, 2, 3, 4, 5}));
+    auto it = v.insert_range(v.begin() + 1, vector({6, 7}));
+    EXPECT_EQ(*it, 6);
+    EXPECT_EQ(v, vector({1, 6, 7, 2, 3, 4, 5}));
+    v.insert_range(v.end(), vector<int>());
+    v.insert_range(v.begin() + 3, vector<int>(100, 0));
+    EXPECT_EQ(v.size(), 107);
+    EXPECT_EQ(v[102], 0);
+    EXPECT_EQ(v[103], 2);
+  }
+  {
+    vector<SelfRef> v = {1, 2, 3};
+    const vector<int> other = {4, 5};
+    v.append_range(other);
+    v.insert_range(v.begin(), other);
+    EXPECT_EQ(v.size(), 7);
+    const int expected[] = {4, 5, 1, 2, 3, 4, 5};
+    for (int i = 0; i < 7; i++) {
+      EXPECT_EQ(v[i].value, expected[i]);
+      EXPECT_TRUE(v[i].valid());
+    }
+  }
+  {
+    vector<string> v = {"a", "b"};
+    v.insert_range(v.begin() + 1, vector<string>{"c", "a string longer than the small buffer"});
+    EXPECT_EQ(v, vector<string>({"a", "c", "a string longer than the small buffer", "b"}));
+  }
+}
+
+TEST(test_vector, resize_for_overwrite) {
+  vector<int> v = {1, 2};
+  v.resize_for_overwrite(100);
+  EXPECT_EQ(v.size(), 100);
+  EXPECT_EQ(v[1], 2);
+  v[99] = 99;
+  v.resize_for_overwrite(1);
+  EXPECT_EQ(v, vector({1}));
+
+  vector<string> s;
+  s.resize_for_overwrite(3);
+  EXPECT_TRUE(s[2].empty());
+}
+
+TEST(test_vector, growth_policy) {
+  vector<int> pow2;
+  vector<int, allocator<int>, grow_by_1_5> factor;
+  vector<int, allocator<int>, grow_exactly> exact;
+  for (int i = 0; i < 10; i++) {
+    pow2.push_back(i);
+    factor.push_back(i);
+    exact.push_back(i);
+  }
+  EXPECT_EQ(pow2.capacity(), 16);
+  EXPECT_EQ(factor.capacity(), 13);
+  EXPECT_EQ(exact.capacity(), 10);
+  EXPECT_EQ(factor, (vector<int, allocator<int>, grow_by_1_5>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+}
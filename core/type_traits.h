@@ -260,6 +260,12 @@ using std::is_trivially_destructible_v;
 using std::is_trivially_move_constructible;
 using std::is_trivially_move_constructible_v;
 
+// moving an object to another address and destroying the source is the same as copying its bytes.
+// Trivially copyable types are, other types opt in by specializing it, if they don't point into themselves.
+template <class T> struct is_trivially_relocatable : bool_constant<is_trivially_copyable_v<T>> {};
+template <class T> struct is_trivially_relocatable<const T> : is_trivially_relocatable<T> {};
+template <class T> inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
 template <class T> struct is_signed : false_type {};
 template <class T> requires(is_arithmetic_v<T>) struct is_signed<T> : bool_constant<T(-1) < T(0)> {};
 template <class T> inline constexpr bool is_signed_v = is_signed<T>::value;
@@ -303,6 +309,11 @@ template <class T> struct is_default_constructible : bool_constant<_default_cons
 template <class T> inline constexpr bool is_default_constructible_v = is_default_constructible<T>::value;
 template <class T, class... Args> struct is_constructible : bool_constant<_constructible<T, Args...>> {};
 template <class T, class... Args> inline constexpr bool is_constructible_v = is_constructible<T, Args...>::value;
+template <class T, class... Args> concept _nothrow_constructible = _constructible<T, Args...> && requires {
+  requires noexcept(T(declval<Args>()...));
+};
+template <class T, class... Args> struct is_nothrow_constructible : bool_constant<_nothrow_constructible<T, Args...>> {};
+template <class T, class... Args> inline constexpr bool is_nothrow_constructible_v = is_nothrow_constructible<T, Args...>::value;
 template <class T> struct is_copy_contructible : is_constructible<T, add_lvalue_reference_t<add_const_t<T>>> {};
 template <class T> inline constexpr bool is_copy_constructible_v = is_copy_contructible<T>::value;
 template <class T> struct is_move_contructible : is_constructible<T, add_rvalue_reference_t<T>> {};
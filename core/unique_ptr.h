@@ -93,6 +93,8 @@ private:
   Deleter m_deleter;
 };
 
+template <class T, class D> struct is_trivially_relocatable<unique_ptr<T, D>> : is_trivially_relocatable<D> {};
+
 template <class T, class D> constexpr void swap(unique_ptr<T, D> &a, unique_ptr<T, D> &b) { a.swap(b); }
 
 template <class T, class... Args> requires(!is_array_v<T>) unique_ptr<T> make_unique(Args &&...args) {
@@ -3,10 +3,10 @@
 
 namespace aria {
 
-template <class Key, class T, class Hash = hash<Key>, class KeyEqual = equal_to<Key>>
-class unordered_map : public hash_table<Key, T, Hash, KeyEqual> {
+template <class Key, class T, class Hash = hash<Key>, class KeyEqual = equal_to<Key>, class Allocator = allocator<pair<const Key, T>>>
+class unordered_map : public hash_table<Key, T, Hash, KeyEqual, Allocator> {
 public:
-  using Base = hash_table<Key, T, Hash, KeyEqual>;
+  using Base = hash_table<Key, T, Hash, KeyEqual, Allocator>;
   using key_type = Key;
   using value_type = typename Base::value_type;
   using mapped_type = T;
@@ -16,6 +16,7 @@ public:
   using const_reference = const value_type &;
   using hasher = Hash;
   using key_equal = KeyEqual;
+  using allocator_type = Allocator;
   using iterator = typename Base::iterator;
   using const_iterator = typename Base::const_iterator;
 
@@ -51,13 +52,13 @@ public:
 private:
 };
 
-template <class Key, class T, class Hash, class KeyEqual>
-void swap(unordered_map<Key, T, Hash, KeyEqual> &lhs, unordered_map<Key, T, Hash, KeyEqual> &rhs) noexcept {
+template <class Key, class T, class Hash, class KeyEqual, class Alloc>
+void swap(unordered_map<Key, T, Hash, KeyEqual, Alloc> &lhs, unordered_map<Key, T, Hash, KeyEqual, Alloc> &rhs) noexcept {
   lhs.swap(rhs);
 }
 
-template <class Key, class T, class Hash, class KeyEqual>
-bool operator==(const unordered_map<Key, T, Hash, KeyEqual> &lhs, const unordered_map<Key, T, Hash, KeyEqual> &rhs) {
+template <class Key, class T, class Hash, class KeyEqual, class Alloc>
+bool operator==(const unordered_map<Key, T, Hash, KeyEqual, Alloc> &lhs, const unordered_map<Key, T, Hash, KeyEqual, Alloc> &rhs) {
   if (&lhs == &rhs)
     return true;
   if (lhs.size() != rhs.size())
@@ -69,7 +70,8 @@ bool operator==(const unordered_map<Key, T, Hash, KeyEqual> &lhs, const unordere
   });
 }
 
-template <class Key, class T, class Hash, class KeyEqual, class Pred> size_t erase_if(unordered_map<Key, T, Hash, KeyEqual> &c, Pred pred) {
+template <class Key, class T, class Hash, class KeyEqual, class Alloc, class Pred>
+size_t erase_if(unordered_map<Key, T, Hash, KeyEqual, Alloc> &c, Pred pred) {
   size_t old_size = c.size();
   for (auto it = begin(c); it != end(c);) {
     if (pred(*it)) {
@@ -80,4 +82,9 @@ template <class Key, class T, class Hash, class KeyEqual, class Pred> size_t era
   return old_size - c.size();
 }
 
+namespace pmr {
+template <class Key, class T, class Hash = hash<Key>, class KeyEqual = equal_to<Key>>
+using unordered_map = aria::unordered_map<Key, T, Hash, KeyEqual, polymorphic_allocator<pair<const Key, T>>>;
+}
+
 } // namespace aria
\ No newline at end of file
@@ -3,10 +3,10 @@
 
 namespace aria {
 
-template <class Key, class Hash = hash<Key>, class KeyEqual = equal_to<Key>>
-class unordered_set : public hash_table<Key, void, Hash, KeyEqual> {
+template <class Key, class Hash = hash<Key>, class KeyEqual = equal_to<Key>, class Allocator = allocator<Key>>
+class unordered_set : public hash_table<Key, void, Hash, KeyEqual, Allocator> {
 public:
-  using Base = hash_table<Key, void, Hash, KeyEqual>;
+  using Base = hash_table<Key, void, Hash, KeyEqual, Allocator>;
   using key_type = Key;
   using value_type = typename Base::value_type;
   using size_type = size_t;
@@ -15,6 +15,7 @@ public:
   using const_reference = const value_type &;
   using hasher = Hash;
   using key_equal = KeyEqual;
+  using allocator_type = Allocator;
   using iterator = typename Base::iterator;
   using const_iterator = typename Base::const_iterator;
   static_assert(is_same_v<key_type, value_type>);
@@ -24,13 +25,13 @@ public:
 private:
 };
 
-template <class Key, class Hash, class KeyEqual>
-void swap(unordered_set<Key, Hash, KeyEqual> &lhs, unordered_set<Key, Hash, KeyEqual> &rhs) noexcept {
+template <class Key, class Hash, class KeyEqual, class Alloc>
+void swap(unordered_set<Key, Hash, KeyEqual, Alloc> &lhs, unordered_set<Key, Hash, KeyEqual, Alloc> &rhs) noexcept {
   lhs.swap(rhs);
 }
 
-template <class Key, class Hash, class KeyEqual>
-bool operator==(const unordered_set<Key, Hash, KeyEqual> &lhs, const unordered_set<Key, Hash, KeyEqual> &rhs) {
+template <class Key, class Hash, class KeyEqual, class Alloc>
+bool operator==(const unordered_set<Key, Hash, KeyEqual, Alloc> &lhs, const unordered_set<Key, Hash, KeyEqual, Alloc> &rhs) {
   if (&lhs == &rhs)
     return true;
   if (lhs.size() != rhs.size())
@@ -38,7 +39,8 @@ bool operator==(const unordered_set<Key, Hash, KeyEqual> &lhs, const unordered_s
   return all_of(begin(lhs), end(lhs), [&](const auto &key) { return rhs.contains(key); });
 }
 
-template <class Key, class Hash, class KeyEqual, class Pred> size_t erase_if(unordered_set<Key, Hash, KeyEqual> &c, Pred pred) {
+template <class Key, class Hash, class KeyEqual, class Alloc, class Pred>
+size_t erase_if(unordered_set<Key, Hash, KeyEqual, Alloc> &c, Pred pred) {
   size_t old_size = c.size();
   for (auto it = begin(c); it != end(c);) {
     if (pred(*it)) {
@@ -49,4 +51,9 @@ template <class Key, class Hash, class KeyEqual, class Pred> size_t erase_if(uno
   return old_size - c.size();
 }
 
+namespace pmr {
+template <class Key, class Hash = hash<Key>, class KeyEqual = equal_to<Key>>
+using unordered_set = aria::unordered_set<Key, Hash, KeyEqual, polymorphic_allocator<Key>>;
+}
+
 } // namespace aria
\ No newline at end of file
@@ -63,6 +63,9 @@ template <class T1, class T2> constexpr pair<T1, T2> make_pair(const T1 &&a, con
 
 template <class T1, class T2> void swap(pair<T1, T2> &a, pair<T1, T2> &b) { a.swap(b); }
 
+template <class T1, class T2>
+struct is_trivially_relocatable<pair<T1, T2>> : bool_constant<is_trivially_relocatable_v<T1> && is_trivially_relocatable_v<T2>> {};
+
 template <class T> struct is_pair : false_type {};
 template <class T1, class T2> struct is_pair<pair<T1, T2>> : true_type {};
 template <class T> inline constexpr bool is_pair_v = is_pair<T>::value;
@@ -197,6 +200,12 @@ template <class T> struct is_in_place_type : false_type {};
 template <class T> struct is_in_place_type<in_place_type_t<T>> : true_type {};
 template <class T> inline constexpr bool is_in_place_type_v = is_in_place_type<T>::value;
 
+//------------------------- sorted_unique -------------------------//
+struct sorted_unique_t {
+  explicit sorted_unique_t() = default;
+};
+inline constexpr sorted_unique_t sorted_unique{};
+
 //------------------------- addressof -------------------------//
 template <class T> auto addressof(T &x) noexcept {
   if constexpr (is_object_v<T>)
@@ -4,12 +4,73 @@
 #include "allocator.h"
 #include "bit.h"
 #include "iterator.h"
+#include "ranges.h"
 #include "stdexcept.h"
 #include "utility.h"
 
 namespace aria {
 
-template <class T, class Allocator = allocator<T>> class vector : public iterable_mixin {
+//------------------------- growth policies -------------------------//
+// grow(capacity, n) is the new capacity of a vector which has to hold n elements, n > capacity
+struct grow_to_power_of_two {
+  static constexpr size_t grow(size_t, size_t n) noexcept { return bit_ceil(n); }
+};
+
+template <size_t Num, size_t Den> struct grow_by_factor {
+  static_assert(Num > Den);
+  static constexpr size_t grow(size_t capacity, size_t n) noexcept { return max(n, capacity * Num / Den); }
+};
+
+using grow_by_1_5 = grow_by_factor<3, 2>;
+using grow_by_2 = grow_by_factor<2, 1>;
+
+struct grow_exactly {
+  static constexpr size_t grow(size_t, size_t n) noexcept { return n; }
+};
+
+namespace _vector {
+template <class It, class Se> size_t range_size(It first, Se last) {
+  if constexpr (ranges::sized_sentinel_for<Se, It>) {
+    return last - first;
+  } else {
+    size_t n = 0;
+    for (; first != last; ++first)
+      n++;
+    return n;
+  }
+}
+
+// constructs n elements in uninitialized memory, trivially copyable data is copied at once
+template <class T, class It> void construct_n(T *p, It first, size_t n) {
+  if constexpr (contiguous_iterator<It> && is_trivially_copyable_v<T> && is_same_v<remove_cv_t<iter_value_t<It>>, T>) {
+    if (n > 0)
+      memcpy(static_cast<void *>(p), to_address(first), sizeof(T) * n);
+  } else {
+    for (size_t i = 0; i < n; ++i, ++first)
+      construct_at(p + i, *first);
+  }
+}
+
+// moves n elements to uninitialized memory and destroys the sources, the ranges don't overlap
+template <class T> constexpr void relocate(T *dst, T *src, size_t n) {
+  if constexpr (is_trivially_relocatable_v<T>) {
+    if (n > 0)
+      memcpy(static_cast<void *>(dst), src, sizeof(T) * n);
+  } else {
+    for (size_t i = 0; i < n; i++) {
+      if constexpr (is_move_constructible_v<T>) {
+        construct_at(dst + i, move(src[i]));
+      } else {
+        construct_at(dst + i, src[i]);
+      }
+    }
+    for (size_t i = 0; i < n; i++)
+      destroy_at(src + i);
+  }
+}
+} // namespace _vector
+
+template <class T, class Allocator = allocator<T>, class GrowthPolicy = grow_to_power_of_two> class vector : public iterable_mixin {
 public:
   using size_type = size_t;
   using difference_type = ptrdiff_t;
@@ -17,6 +78,7 @@ public:
   using reference = value_type &;
   using const_reference = const value_type &;
   using allocator_type = Allocator;
+  using growth_policy = GrowthPolicy;
   using pointer = typename allocator_traits<Allocator>::pointer;
   using const_pointer = typename allocator_traits<Allocator>::const_pointer;
   using iterator = array_iterator<T>;
@@ -152,6 +214,55 @@ public:
 
   void resize(size_type count, const value_type &value) requires is_copy_constructible_v<T> { resize_helper(count, value); }
 
+  // like resize(), but the new elements are default-initialized, so for trivial types they are left uninitialized
+  void resize_for_overwrite(size_type count) requires is_default_constructible_v<T> {
+    if (count <= size()) {
+      erase(begin() + count, end());
+      return;
+    }
+    reserve_more(count - size());
+    if constexpr (!is_trivially_constructible_v<T>) {
+      for (auto i = m_size; i < count; i++)
+        ::new (static_cast<void *>(get(i))) T;
+    }
+    m_size = count;
+  }
+
+  template <ranges::range R> void append_range(R &&rg) {
+    auto first = ranges::begin(rg);
+    auto last = ranges::end(rg);
+    if constexpr (forward_iterator<decltype(first)>) {
+      const auto n = _vector::range_size(first, last);
+      reserve_more(n);
+      _vector::construct_n(get(m_size), first, n);
+      m_size += n;
+    } else {
+      for (; first != last; ++first)
+        emplace_back(*first);
+    }
+  }
+
+  template <ranges::range R> iterator insert_range(const_iterator pos, R &&rg) {
+    const size_type idx = pos - begin();
+    auto first = ranges::begin(rg);
+    auto last = ranges::end(rg);
+    if constexpr (is_trivially_relocatable_v<T> && forward_iterator<decltype(first)> &&
+                  is_nothrow_constructible_v<T, ranges::range_reference_t<R>>) {
+      // open a gap and construct the new elements in it
+      const auto n = _vector::range_size(first, last);
+      reserve_more(n);
+      auto p = get(idx);
+      memmove(static_cast<void *>(p + n), p, sizeof(value_type) * (size() - idx));
+      _vector::construct_n(p, first, n);
+      m_size += n;
+    } else {
+      const auto old_size = size();
+      append_range(forward<R>(rg));
+      rotate(begin() + idx, begin() + old_size, end());
+    }
+    return get(idx);
+  }
+
   constexpr auto begin() const noexcept { return const_iterator(get(0)); }
   constexpr auto end() const noexcept { return const_iterator(get(m_size)); }
   constexpr auto begin() noexcept { return iterator(get(0)); }
@@ -163,6 +274,15 @@ public:
     auto d = distance(first, last);
     if (d == 0)
       return last;
+    if constexpr (is_trivially_relocatable_v<T>) {
+      const size_type idx = first - begin();
+      auto p = get(idx);
+      for (auto q = p; q != p + d; ++q)
+        destroy_at(q);
+      memmove(static_cast<void *>(p), p + d, sizeof(value_type) * (size() - idx - d));
+      m_size -= d;
+      return p;
+    }
     for (iterator it = last; it != end(); ++it) {
       *(it - d) = move(*it);
     }
@@ -179,10 +299,20 @@ public:
 
   template <class U> requires same_as<value_type, remove_cvref_t<U>> iterator insert(const_iterator pos, U &&value) {
     const auto idx = pos - begin();
+    value_type tmp(forward<U>(value)); // value may be an element of this vector
     reserve_more(1);
     auto p = get(idx);
-    memmove(p + 1, p, sizeof(value_type) * (size() - idx));
-    construct_at(p, forward<U>(value));
+    if constexpr (is_trivially_relocatable_v<T>) {
+      memmove(static_cast<void *>(p + 1), p, sizeof(value_type) * (size() - idx));
+      construct_at(p, move(tmp));
+    } else if (idx == size()) {
+      construct_at(p, move(tmp));
+    } else {
+      construct_at(get(m_size), move(back()));
+      for (auto q = get(m_size - 1); q != p; --q)
+        *q = move(*(q - 1));
+      *p = move(tmp);
+    }
     m_size++;
     return p;
   }
@@ -190,9 +320,15 @@ public:
   iterator erase(iterator pos) {
     const auto idx = pos - begin();
     auto p = get(idx);
-    destroy_at(p);
-    memmove(p, p + 1, sizeof(value_type) * (size() - idx - 1));
-    m_size--;
+    if constexpr (is_trivially_relocatable_v<T>) {
+      destroy_at(p);
+      memmove(static_cast<void *>(p), p + 1, sizeof(value_type) * (size() - idx - 1));
+      m_size--;
+    } else {
+      for (auto q = p + 1; q != get(m_size); ++q)
+        *(q - 1) = move(*q);
+      pop_back();
+    }
     return p;
   }
 
@@ -214,16 +350,7 @@ private:
 
   constexpr void reallocate(size_type cap) {
     auto p = m_alloc.allocate(cap);
-    for (int i = 0; i < m_size; i++) {
-      if constexpr (is_move_constructible_v<T>) {
-        construct_at(p + i, move(*(m_ptr + i)));
-      } else {
-        construct_at(p + i, *(m_ptr + i));
-      }
-    }
-    for (int i = 0; i < m_size; i++) {
-      destruct_at(i);
-    }
+    _vector::relocate(p, m_ptr, m_size);
     m_alloc.deallocate(m_ptr, m_capacity);
     m_ptr = p;
     m_capacity = cap;
@@ -231,7 +358,7 @@ private:
 
   void reserve_more(size_type added_size) {
     if (auto new_size = size() + added_size; new_size > capacity())
-      reserve(bit_ceil(new_size));
+      reallocate(GrowthPolicy::grow(capacity(), new_size));
   }
 
   template <class... Args> void resize_helper(size_type count, Args... args) {
@@ -248,18 +375,23 @@ private:
   }
 };
 
-template <class T, class Alloc> [[nodiscard]] constexpr bool operator==(const vector<T, Alloc> &a, const vector<T, Alloc> &b) {
+template <class T, class Alloc, class G>
+[[nodiscard]] constexpr bool operator==(const vector<T, Alloc, G> &a, const vector<T, Alloc, G> &b) {
   return equal(a.begin(), a.end(), b.begin(), b.end());
 }
 
-template <class T, class Alloc> [[nodiscard]] constexpr auto operator<=>(const vector<T, Alloc> &a, const vector<T, Alloc> &b) {
+template <class T, class Alloc, class G>
+[[nodiscard]] constexpr auto operator<=>(const vector<T, Alloc, G> &a, const vector<T, Alloc, G> &b) {
   return lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end());
 }
 
-template <class T, class A> constexpr void swap(vector<T, A> &a, vector<T, A> &b) { a.swap(b); }
+template <class T, class Alloc, class G> struct is_trivially_relocatable<vector<T, Alloc, G>> : is_trivially_relocatable<Alloc> {};
 
-template <class T, class Alloc, class U = T> constexpr vector<T, Alloc>::size_type erase(vector<T, Alloc> &v, const U &value) {
-  typename vector<T, Alloc>::size_type i = 0, index = 0;
+template <class T, class A, class G> constexpr void swap(vector<T, A, G> &a, vector<T, A, G> &b) { a.swap(b); }
+
+template <class T, class Alloc, class G, class U = T>
+constexpr vector<T, Alloc, G>::size_type erase(vector<T, Alloc, G> &v, const U &value) {
+  typename vector<T, Alloc, G>::size_type i = 0, index = 0;
   for (; i < v.size(); ++i) {
     if (v[i] != value) {
       v[index++] = move(v[i]);
@@ -270,8 +402,8 @@ template <class T, class Alloc, class U = T> constexpr vector<T, Alloc>::size_ty
   return res;
 }
 
-template <class T, class Alloc, class Pred> constexpr vector<T, Alloc>::size_type erase_if(vector<T, Alloc> &v, Pred pred) {
-  typename vector<T, Alloc>::size_type i = 0, index = 0;
+template <class T, class Alloc, class G, class Pred> constexpr vector<T, Alloc, G>::size_type erase_if(vector<T, Alloc, G> &v, Pred pred) {
+  typename vector<T, Alloc, G>::size_type i = 0, index = 0;
   for (; i < v.size(); ++i) {
     if (!pred(v[i])) {
       v[index++] = move(v[i]);
@@ -282,4 +414,8 @@ template <class T, class Alloc, class Pred> constexpr vector<T, Alloc>::size_typ
   return res;
 }
 
+namespace pmr {
+template <class T> using vector = aria::vector<T, polymorphic_allocator<T>>;
+}
+
 } // namespace aria
\ No newline at end of file
@@ -0,0 +1,359 @@
+#pragma once
+#include "algorithm.h"
+#include "numeric.h"
+#include "optional.h"
+#include "thread_pool.h"
+#include "vector.h"
+#include <atomic>
+#include <thread>
+
+// Execution policies for the algorithms, like std::execution. execution::par runs on a pool shared by the process,
+// par.on(pool) on a given ThreadPool, and seq (or iterators which aren't random access) use the sequential algorithm.
+//   aria::sort(execution::par, v.begin(), v.end());
+//   aria::for_each(execution::par.on(pool), v.begin(), v.end(), f);
+// As with the standard policies, an exception thrown by an element access function calls std::terminate.
+namespace aria {
+
+namespace execution {
+struct sequenced_policy {};
+
+struct parallel_policy {
+  parallel_policy on(ThreadPool &p) const noexcept { return parallel_policy{&p}; }
+
+  ThreadPool *pool = nullptr; // the default pool if null
+};
+
+// vectorization is left to the compiler, so it is the same as par
+struct parallel_unsequenced_policy : parallel_policy {};
+
+inline constexpr sequenced_policy seq{};
+inline constexpr parallel_policy par{};
+inline constexpr parallel_unsequenced_policy par_unseq{};
+} // namespace execution
+
+template <class T> struct is_execution_policy : false_type {};
+template <> struct is_execution_policy<execution::sequenced_policy> : true_type {};
+template <> struct is_execution_policy<execution::parallel_policy> : true_type {};
+template <> struct is_execution_policy<execution::parallel_unsequenced_policy> : true_type {};
+template <class T> inline constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+namespace _execution {
+template <class T> concept policy = is_execution_policy_v<remove_cvref_t<T>>;
+
+// the algorithm is split into chunks if the policy allows it and all the iterators are random access
+template <class Policy, class... Its>
+inline constexpr bool is_parallel =
+    is_base_of_v<execution::parallel_policy, remove_cvref_t<Policy>> && (random_access_iterator<Its> && ...);
+
+// enough chunks per thread to even out chunks which take longer than the others
+inline constexpr ptrdiff_t chunks_per_thread = 4;
+
+inline ThreadPool &pool_of(const execution::parallel_policy &policy) { return policy.pool ? *policy.pool : default_thread_pool(); }
+
+inline ptrdiff_t chunk_count(const ThreadPool &pool, ptrdiff_t n) { return min<ptrdiff_t>(n, (pool.size() + 1) * chunks_per_thread); }
+
+// the first index of chunk i when [0, n) is split into count chunks
+inline ptrdiff_t chunk_begin(ptrdiff_t i, ptrdiff_t n, ptrdiff_t count) { return i * n / count; }
+
+// Calls f(i) for i in [0, count) on the calling thread and the pool, and returns when all calls returned.
+// The indices are claimed from a shared counter, so the caller never waits for a task which hasn't started, e.g. because all
+// the workers are blocked in a parallel algorithm themselves. Such a task finds no index left and returns without touching f.
+template <class F> void run_parallel(ThreadPool &pool, ptrdiff_t count, F &&f) {
+  if (count <= 0)
+    return;
+  struct counters {
+    std::atomic<ptrdiff_t> next = 0;
+    std::atomic<ptrdiff_t> done = 0;
+  };
+  auto state = std::make_shared<counters>();
+  auto run = [state, count, f = &f]() noexcept {
+    for (ptrdiff_t i; (i = state->next.fetch_add(1)) < count;) {
+      (*f)(i);
+      if (state->done.fetch_add(1) + 1 == count)
+        state->done.notify_all();
+    }
+  };
+
+  const auto n_tasks = min<ptrdiff_t>(pool.size(), count - 1);
+  for (ptrdiff_t i = 0; i < n_tasks; i++)
+    pool.detach_task(run);
+  run();
+  for (auto done = state->done.load(); done != count; done = state->done.load())
+    state->done.wait(done);
+}
+
+// calls f(begin, end) for the chunks of [0, n)
+template <class F> void for_chunks(ThreadPool &pool, ptrdiff_t n, F &&f) {
+  const auto count = chunk_count(pool, n);
+  run_parallel(pool, count, [&](ptrdiff_t i) { f(chunk_begin(i, n, count), chunk_begin(i + 1, n, count)); });
+}
+
+// op of the results of reduce_chunk(begin, end) for the chunks of [0, n), in order
+template <class T, class BinaryOp, class F> T reduce_chunks(ThreadPool &pool, ptrdiff_t n, T init, BinaryOp op, F &&reduce_chunk) {
+  const auto count = chunk_count(pool, n);
+  vector<optional<T>> partials(count);
+  run_parallel(pool, count,
+               [&](ptrdiff_t i) { partials[i].emplace(reduce_chunk(chunk_begin(i, n, count), chunk_begin(i + 1, n, count))); });
+  for (auto &x : partials)
+    init = op(move(init), move(*x));
+  return init;
+}
+
+// the number of elements of [a, a + len_a) among the first d elements of the stable merge with [b, b + len_b)
+template <class It, class Compare> ptrdiff_t merge_split(It a, ptrdiff_t len_a, It b, ptrdiff_t len_b, ptrdiff_t d, Compare &comp) {
+  auto lo = max<ptrdiff_t>(0, d - len_b), hi = min(d, len_a);
+  while (lo < hi) {
+    const auto i = lo + (hi - lo) / 2;
+    if (comp(b[d - i - 1], a[i]))
+      hi = i;
+    else
+      lo = i + 1;
+  }
+  return lo;
+}
+
+// moves the stable merge of [a, a_last) and [b, b_last) to out
+template <class It, class OutputIt, class Compare> void merge_move(It a, It a_last, It b, It b_last, OutputIt out, Compare &comp) {
+  for (; a != a_last && b != b_last; ++out)
+    *out = comp(*b, *a) ? move(*b++) : move(*a++);
+  for (; a != a_last; ++a, ++out)
+    *out = move(*a);
+  for (; b != b_last; ++b, ++out)
+    *out = move(*b);
+}
+} // namespace _execution
+
+template <_execution::policy Policy, forward_iterator It, class UnaryFunc> void for_each(Policy &&policy, It first, It last, UnaryFunc f) {
+  if constexpr (_execution::is_parallel<Policy, It>) {
+    _execution::for_chunks(_execution::pool_of(policy), last - first,
+                           [&](ptrdiff_t b, ptrdiff_t e) { aria::for_each(first + b, first + e, f); });
+  } else {
+    aria::for_each(first, last, f);
+  }
+}
+
+template <_execution::policy Policy, forward_iterator InputIt, forward_iterator OutputIt, class UnaryOp>
+OutputIt transform(Policy &&policy, InputIt first, InputIt last, OutputIt d_first, UnaryOp unary_op) {
+  if constexpr (_execution::is_parallel<Policy, InputIt, OutputIt>) {
+    const auto n = last - first;
+    _execution::for_chunks(_execution::pool_of(policy), n,
+                           [&](ptrdiff_t b, ptrdiff_t e) { aria::transform(first + b, first + e, d_first + b, unary_op); });
+    return d_first + n;
+  } else {
+    return aria::transform(first, last, d_first, unary_op);
+  }
+}
+
+template <_execution::policy Policy, forward_iterator InputIt1, forward_iterator InputIt2, forward_iterator OutputIt, class BinaryOp>
+OutputIt transform(Policy &&policy, InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt d_first, BinaryOp binary_op) {
+  if constexpr (_execution::is_parallel<Policy, InputIt1, InputIt2, OutputIt>) {
+    const auto n = last1 - first1;
+    _execution::for_chunks(_execution::pool_of(policy), n, [&](ptrdiff_t b, ptrdiff_t e) {
+      aria::transform(first1 + b, first1 + e, first2 + b, d_first + b, binary_op);
+    });
+    return d_first + n;
+  } else {
+    return aria::transform(first1, last1, first2, d_first, binary_op);
+  }
+}
+
+// op must be associative and commutative
+template <_execution::policy Policy, forward_iterator It, class T, class BinaryOp>
+T reduce(Policy &&policy, It first, It last, T init, BinaryOp op) {
+  if constexpr (_execution::is_parallel<Policy, It>) {
+    return _execution::reduce_chunks(_execution::pool_of(policy), last - first, move(init), op,
+                                     [&](ptrdiff_t b, ptrdiff_t e) { return aria::reduce(first + b + 1, first + e, T(*(first + b)), op); });
+  } else {
+    return aria::reduce(first, last, move(init), op);
+  }
+}
+
+template <_execution::policy Policy, forward_iterator It, class T> T reduce(Policy &&policy, It first, It last, T init) {
+  return reduce(policy, first, last, move(init), plus{});
+}
+
+template <_execution::policy Policy, forward_iterator It> iter_value_t<It> reduce(Policy &&policy, It first, It last) {
+  return reduce(policy, first, last, iter_value_t<It>{});
+}
+
+template <_execution::policy Policy, forward_iterator It, class T, class BinaryReduceOp, class UnaryTransformOp>
+T transform_reduce(Policy &&policy, It first, It last, T init, BinaryReduceOp reduce, UnaryTransformOp transform) {
+  if constexpr (_execution::is_parallel<Policy, It>) {
+    return _execution::reduce_chunks(_execution::pool_of(policy), last - first, move(init), reduce, [&](ptrdiff_t b, ptrdiff_t e) {
+      return aria::transform_reduce(first + b + 1, first + e, T(transform(*(first + b))), reduce, transform);
+    });
+  } else {
+    return aria::transform_reduce(first, last, move(init), reduce, transform);
+  }
+}
+
+template <_execution::policy Policy, forward_iterator It1, forward_iterator It2, class T, class BinaryReduceOp, class BinaryTransformOp>
+T transform_reduce(Policy &&policy, It1 first1, It1 last1, It2 first2, T init, BinaryReduceOp reduce, BinaryTransformOp transform) {
+  if constexpr (_execution::is_parallel<Policy, It1, It2>) {
+    return _execution::reduce_chunks(_execution::pool_of(policy), last1 - first1, move(init), reduce, [&](ptrdiff_t b, ptrdiff_t e) {
+      return aria::transform_reduce(first1 + b + 1, first1 + e, first2 + b + 1, T(transform(*(first1 + b), *(first2 + b))), reduce,
+                                    transform);
+    });
+  } else {
+    return aria::transform_reduce(first1, last1, first2, move(init), reduce, transform);
+  }
+}
+
+template <_execution::policy Policy, forward_iterator It1, forward_iterator It2, class T>
+T transform_reduce(Policy &&policy, It1 first1, It1 last1, It2 first2, T init) {
+  return transform_reduce(policy, first1, last1, first2, move(init), plus{}, multiplies{});
+}
+
+template <_execution::policy Policy, forward_iterator It, class UnaryPred>
+size_t count_if(Policy &&policy, It first, It last, UnaryPred p) {
+  if constexpr (_execution::is_parallel<Policy, It>) {
+    return _execution::reduce_chunks(_execution::pool_of(policy), last - first, size_t(0), plus{},
+                                     [&](ptrdiff_t b, ptrdiff_t e) { return aria::count_if(first + b, first + e, p); });
+  } else {
+    return aria::count_if(first, last, p);
+  }
+}
+
+// Each chunk is reduced, the chunk totals are scanned, and each chunk is scanned again from the total before it,
+// so op is applied about twice per element. op must be associative
+template <_execution::policy Policy, forward_iterator InputIt, forward_iterator OutputIt, class BinaryOp>
+OutputIt inclusive_scan(Policy &&policy, InputIt first, InputIt last, OutputIt d_first, BinaryOp op) {
+  if constexpr (_execution::is_parallel<Policy, InputIt, OutputIt>) {
+    using T = iter_value_t<InputIt>;
+    auto &pool = _execution::pool_of(policy);
+    const auto n = last - first;
+    const auto count = _execution::chunk_count(pool, n);
+    auto chunk_begin = [&](ptrdiff_t i) { return _execution::chunk_begin(i, n, count); };
+
+    // the last chunk's total isn't needed
+    vector<optional<T>> totals(count);
+    _execution::run_parallel(pool, count - 1, [&](ptrdiff_t i) {
+      const auto b = chunk_begin(i), e = chunk_begin(i + 1);
+      totals[i].emplace(aria::reduce(first + b + 1, first + e, T(*(first + b)), op));
+    });
+    for (ptrdiff_t i = 1; i < count - 1; i++)
+      *totals[i] = op(move(*totals[i - 1]), move(*totals[i]));
+
+    _execution::run_parallel(pool, count, [&](ptrdiff_t i) {
+      const auto b = chunk_begin(i), e = chunk_begin(i + 1);
+      if (i == 0)
+        aria::inclusive_scan(first + b, first + e, d_first + b, op);
+      else
+        aria::inclusive_scan(first + b, first + e, d_first + b, op, T(*totals[i - 1]));
+    });
+    return d_first + n;
+  } else {
+    return aria::inclusive_scan(first, last, d_first, op);
+  }
+}
+
+template <_execution::policy Policy, forward_iterator InputIt, forward_iterator OutputIt>
+OutputIt inclusive_scan(Policy &&policy, InputIt first, InputIt last, OutputIt d_first) {
+  return inclusive_scan(policy, first, last, d_first, plus{});
+}
+
+// the predicate results are stored, so that after counting them per chunk each chunk knows where its output starts
+template <_execution::policy Policy, forward_iterator InputIt, forward_iterator OutputIt, class UnaryPred>
+OutputIt copy_if(Policy &&policy, InputIt first, InputIt last, OutputIt d_first, UnaryPred pred) {
+  if constexpr (_execution::is_parallel<Policy, InputIt, OutputIt>) {
+    auto &pool = _execution::pool_of(policy);
+    const auto n = last - first;
+    const auto count = _execution::chunk_count(pool, n);
+    auto chunk_begin = [&](ptrdiff_t i) { return _execution::chunk_begin(i, n, count); };
+    vector<unsigned char> selected(n);
+    vector<ptrdiff_t> offsets(count + 1);
+    _execution::run_parallel(pool, count, [&](ptrdiff_t i) {
+      for (auto j = chunk_begin(i); j != chunk_begin(i + 1); j++) {
+        if (pred(*(first + j))) {
+          selected[j] = 1;
+          offsets[i + 1]++;
+        }
+      }
+    });
+    aria::inclusive_scan(offsets.begin(), offsets.end(), offsets.begin());
+
+    _execution::run_parallel(pool, count, [&](ptrdiff_t i) {
+      auto out = d_first + offsets[i];
+      for (auto j = chunk_begin(i); j != chunk_begin(i + 1); j++) {
+        if (selected[j]) {
+          *out = *(first + j);
+          ++out;
+        }
+      }
+    });
+    return d_first + offsets[count];
+  } else {
+    return aria::copy_if(first, last, d_first, pred);
+  }
+}
+
+// The chunks are sorted in parallel, then merged pairwise in rounds. A round moves the runs between [first, last) and a buffer,
+// and every merge is cut at binary-searched split points into pieces which are merged in parallel. Without the buffer the merges
+// of a round are run in place, each one on a thread.
+template <_execution::policy Policy, random_access_iterator It, class Compare> void sort(Policy &&policy, It first, It last, Compare comp) {
+  if constexpr (_execution::is_parallel<Policy, It>) {
+    auto &pool = _execution::pool_of(policy);
+    const auto n = last - first;
+    const auto count = _execution::chunk_count(pool, n);
+    auto offset = [&](ptrdiff_t i) { return _execution::chunk_begin(min(i, count), n, count); };
+
+    _execution::run_parallel(pool, count, [&](ptrdiff_t i) { aria::sort(first + offset(i), first + offset(i + 1), comp); });
+    if (count < 2)
+      return;
+
+    _merge::temporary_buffer<iter_value_t<It>> buffer(n);
+    if (buffer.size() == 0) {
+      // in a round the runs of width chunks are merged in pairs, a run without a pair stays as it is
+      for (ptrdiff_t width = 1; width < count; width *= 2) {
+        const auto n_merges = (count + width - 1) / (2 * width);
+        _execution::run_parallel(pool, n_merges, [&](ptrdiff_t i) {
+          const auto b = 2 * width * i;
+          aria::inplace_merge(first + offset(b), first + offset(b + width), first + offset(b + 2 * width), comp);
+        });
+      }
+      return;
+    }
+
+    auto buf = buffer.data();
+    _execution::for_chunks(pool, n, [&](ptrdiff_t b, ptrdiff_t e) {
+      for (auto j = b; j != e; j++)
+        construct_at(buf + j, move(first[j]));
+    });
+    bool in_buffer = true;
+    for (ptrdiff_t width = 1; width < count; width *= 2) {
+      // a run without a pair is moved as it is
+      const auto n_merges = (count + 2 * width - 1) / (2 * width);
+      const auto pieces = max<ptrdiff_t>(1, count / n_merges);
+      auto round = [&](auto src, auto dst) {
+        _execution::run_parallel(pool, n_merges * pieces, [&](ptrdiff_t t) {
+          const auto b = 2 * width * (t / pieces);
+          const auto lo = offset(b), mid = offset(b + width), hi = offset(b + 2 * width);
+          const auto d0 = (hi - lo) * (t % pieces) / pieces, d1 = (hi - lo) * (t % pieces + 1) / pieces;
+          const auto i0 = _execution::merge_split(src + lo, mid - lo, src + mid, hi - mid, d0, comp);
+          const auto i1 = _execution::merge_split(src + lo, mid - lo, src + mid, hi - mid, d1, comp);
+          _execution::merge_move(src + lo + i0, src + lo + i1, src + mid + (d0 - i0), src + mid + (d1 - i1), dst + lo + d0, comp);
+        });
+      };
+      if (in_buffer)
+        round(buf, first);
+      else
+        round(first, buf);
+      in_buffer = !in_buffer;
+    }
+    _execution::for_chunks(pool, n, [&](ptrdiff_t b, ptrdiff_t e) {
+      for (auto j = b; j != e; j++) {
+        if (in_buffer)
+          first[j] = move(buf[j]);
+        destroy_at(buf + j);
+      }
+    });
+  } else {
+    aria::sort(first, last, comp);
+  }
+}
+
+template <_execution::policy Policy, random_access_iterator It> void sort(Policy &&policy, It first, It last) {
+  sort(policy, first, last, less{});
+}
+
+} // namespace aria
\ No newline at end of file
@@ -0,0 +1,213 @@
+#pragma once
+#include "allocator.h" //construct_at
+#include "type_traits.h"
+#include "utility.h"
+#include <atomic>
+#include <exception>
+#include <future> //future_error
+
+// future and promise with a single allocation for the shared state, no mutex and no condition variable:
+// the result is published by an atomic status, which the waiting thread waits on.
+// task_state also holds the callable which produces the result, so ThreadPool::submit_task allocates once.
+namespace aria {
+
+namespace _future {
+struct empty {};
+
+template <class R> class shared_state {
+public:
+  // a reference result is stored as a pointer to the referred object
+  using value_type = conditional_t<is_void_v<R>, empty, conditional_t<is_reference_v<R>, remove_reference_t<R> *, R>>;
+
+  shared_state() noexcept {}
+  shared_state(const shared_state &) = delete;
+  shared_state &operator=(const shared_state &) = delete;
+
+  template <class... Args> void set_value(Args &&...args) {
+    if constexpr (is_reference_v<R>)
+      construct_at(&m_value, addressof(args)...);
+    else
+      construct_at(&m_value, forward<Args>(args)...);
+    publish(status::value);
+  }
+
+  void set_exception(std::exception_ptr e) {
+    m_exception = move(e);
+    publish(status::exception);
+  }
+
+  bool is_ready() const noexcept { return m_status.load(std::memory_order_acquire) != status::pending; }
+
+  void wait() const noexcept {
+    for (auto s = m_status.load(std::memory_order_acquire); s == status::pending; s = m_status.load(std::memory_order_acquire))
+      m_status.wait(s, std::memory_order_acquire);
+  }
+
+  R get() {
+    wait();
+    if (m_status.load(std::memory_order_relaxed) == status::exception)
+      std::rethrow_exception(m_exception);
+    if constexpr (is_reference_v<R>)
+      return static_cast<R>(*m_value);
+    else if constexpr (!is_void_v<R>)
+      return move(m_value);
+  }
+
+  void add_ref() noexcept { m_refs.fetch_add(1, std::memory_order_relaxed); }
+
+  void release() noexcept {
+    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete this;
+  }
+
+  // releases the reference of a producer which won't set a result
+  void abandon() {
+    if (!is_ready())
+      set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+    release();
+  }
+
+protected:
+  virtual ~shared_state() {
+    if (m_status.load(std::memory_order_relaxed) == status::value)
+      destroy_at(&m_value);
+  }
+
+private:
+  enum class status : unsigned char { pending, value, exception };
+
+  void publish(status s) {
+    m_status.store(s, std::memory_order_release);
+    m_status.notify_all();
+  }
+
+  std::atomic<int> m_refs = 1;
+  std::atomic<status> m_status = status::pending;
+  union {
+    value_type m_value;
+  };
+  std::exception_ptr m_exception;
+};
+
+// the shared state and the callable which sets it, in one object
+template <class R, class F> class task_state : public shared_state<R> {
+public:
+  explicit task_state(F &&f) : m_f(move(f)) {}
+  explicit task_state(const F &f) : m_f(f) {}
+
+  void run() {
+    try {
+      if constexpr (is_void_v<R>) {
+        m_f();
+        this->set_value();
+      } else {
+        this->set_value(m_f());
+      }
+    } catch (...) {
+      this->set_exception(std::current_exception());
+    }
+  }
+
+private:
+  F m_f;
+};
+
+// The task of a pool, which holds a reference to a task_state and runs it once. If it is destroyed without being called,
+// e.g. when the task is purged from the pool, the future gets a broken_promise error.
+template <class R, class F> class task_runner {
+public:
+  explicit task_runner(task_state<R, F> *state) noexcept : m_state(state) {}
+  task_runner(task_runner &&rhs) noexcept : m_state(exchange(rhs.m_state, nullptr)) {}
+  task_runner &operator=(task_runner &&) = delete;
+
+  ~task_runner() {
+    if (m_state)
+      m_state->abandon();
+  }
+
+  void operator()() {
+    auto state = exchange(m_state, nullptr);
+    state->run();
+    state->release();
+  }
+
+private:
+  task_state<R, F> *m_state;
+};
+} // namespace _future
+
+template <class R> class future {
+public:
+  future() noexcept = default;
+  // takes over a reference to state
+  explicit future(_future::shared_state<R> *state) noexcept : m_state(state) {}
+  ~future() { reset(); }
+
+  future(const future &) = delete;
+  future &operator=(const future &) = delete;
+  future(future &&rhs) noexcept : m_state(exchange(rhs.m_state, nullptr)) {}
+
+  future &operator=(future &&rhs) noexcept {
+    if (this != &rhs) {
+      reset();
+      m_state = exchange(rhs.m_state, nullptr);
+    }
+    return *this;
+  }
+
+  bool valid() const noexcept { return m_state != nullptr; }
+  bool is_ready() const noexcept { return m_state->is_ready(); }
+  void wait() const noexcept { m_state->wait(); }
+
+  // waits for the result, and releases the state like std::future
+  R get() {
+    future temp(move(*this));
+    return temp.m_state->get();
+  }
+
+private:
+  void reset() noexcept {
+    if (m_state)
+      exchange(m_state, nullptr)->release();
+  }
+
+  _future::shared_state<R> *m_state = nullptr;
+};
+
+template <class R> class promise {
+public:
+  promise() : m_state(new _future::shared_state<R>) {}
+
+  // a promise destroyed without a result breaks its future
+  ~promise() {
+    if (m_state)
+      m_state->abandon();
+  }
+
+  promise(const promise &) = delete;
+  promise &operator=(const promise &) = delete;
+  promise(promise &&rhs) noexcept : m_state(exchange(rhs.m_state, nullptr)) {}
+
+  promise &operator=(promise &&rhs) noexcept {
+    if (this != &rhs) {
+      promise(move(rhs)).swap(*this);
+    }
+    return *this;
+  }
+
+  void swap(promise &rhs) noexcept { aria::swap(m_state, rhs.m_state); }
+
+  // can be called once
+  future<R> get_future() {
+    m_state->add_ref();
+    return future<R>(m_state);
+  }
+
+  template <class... Args> void set_value(Args &&...args) { m_state->set_value(forward<Args>(args)...); }
+  void set_exception(std::exception_ptr e) { m_state->set_exception(move(e)); }
+
+private:
+  _future::shared_state<R> *m_state;
+};
+
+} // namespace aria
\ No newline at end of file
@@ -1,24 +1,62 @@
 #pragma once
+#include "allocator.h"
 #include "cstddef.h"
 #include "stdexcept.h"
+#include <cassert>
 
+// StackBuffer is an arena in an inline buffer: allocation bumps a position, and only deallocating the most recent allocation moves it back.
+// A growing vector allocates its new storage before it frees the old one, so the old storage is not reclaimed until everything above it
+// is released. mark() and release_to() drop everything allocated after the mark at once. StackAllocator falls back to its upstream
+// allocator when the buffer is exhausted, instead of failing.
 namespace aria {
 
 inline constexpr size_t DEFAULT_STACK_ALLOCATOR_SIZE = 16 * 1024; // 16kb
 
 template <size_t N = DEFAULT_STACK_ALLOCATOR_SIZE> struct StackBuffer {
+  using marker = size_t;
+
   constexpr size_t size() const { return N; }
+  constexpr size_t used() const { return pos; }
 
-  template <class T> T *allocate(size_t size) {
+  // nullptr if there is not enough space left
+  template <class T> T *try_allocate(size_t n) noexcept {
     const auto offset = get_offset<T>();
-    if (pos + offset + size > N)
-      throw bad_alloc();
+    if (pos + offset > N || n > (N - pos - offset) / sizeof(T))
+      return nullptr;
 
     auto p = buffer + pos + offset;
-    pos += offset + size * sizeof(T);
+    pos += offset + n * sizeof(T);
     return reinterpret_cast<T *>(p);
   }
 
+  template <class T> T *allocate(size_t n) {
+    if (auto p = try_allocate<T>(n))
+      return p;
+    throw bad_alloc();
+  }
+
+  // only the most recent allocation is given back, the others are reclaimed by release_to() or reset()
+  template <class T> void deallocate(T *p, size_t n) noexcept {
+    assert(owns(p));
+    auto first = reinterpret_cast<aria::byte *>(p);
+    if (first + n * sizeof(T) == buffer + pos)
+      pos = first - buffer;
+  }
+
+  bool owns(const void *p) const noexcept {
+    auto q = static_cast<const aria::byte *>(p);
+    return q >= buffer && q < buffer + N;
+  }
+
+  marker mark() const noexcept { return pos; }
+
+  void release_to(marker m) noexcept {
+    assert(m <= pos);
+    pos = m;
+  }
+
+  void reset() noexcept { pos = 0; }
+
   template <class T> constexpr size_t get_offset() const {
     auto diff = pos % alignof(T);
     return diff == 0 ? 0 : alignof(T) - diff;
@@ -28,17 +66,56 @@ template <size_t N = DEFAULT_STACK_ALLOCATOR_SIZE> struct StackBuffer {
   size_t pos = 0;
 };
 
-template <class T, size_t N> class StackAllocator {
+// releases everything allocated from the buffer during its lifetime
+template <size_t N> class StackBufferScope {
+public:
+  explicit StackBufferScope(StackBuffer<N> &buffer) noexcept : m_buffer(buffer), m_mark(buffer.mark()) {}
+  StackBufferScope(const StackBufferScope &) = delete;
+  StackBufferScope &operator=(const StackBufferScope &) = delete;
+  ~StackBufferScope() { m_buffer.release_to(m_mark); }
+
+private:
+  StackBuffer<N> &m_buffer;
+  typename StackBuffer<N>::marker m_mark;
+};
+
+template <class T, size_t N, class Upstream = allocator<T>> class StackAllocator {
 public:
   using value_type = T;
   using size_type = size_t;
+  using upstream_type = Upstream;
 
-  StackAllocator(StackBuffer<N> &buffer) : m_buffer(buffer) {}
-  [[nodiscard]] constexpr T *allocate(size_type n) { return m_buffer.allocate<T>(n); }
-  constexpr void deallocate(T *p, size_type n) {} // do nothing
+  template <class U> using rebind_alloc = StackAllocator<U, N, typename allocator_traits<Upstream>::template rebind_alloc<U>>;
+
+  StackAllocator(StackBuffer<N> &buffer, const Upstream &upstream = Upstream()) noexcept : m_buffer(&buffer), m_upstream(upstream) {}
+
+  template <class U, class Upstream2>
+  StackAllocator(const StackAllocator<U, N, Upstream2> &rhs) noexcept : m_buffer(rhs.buffer()), m_upstream(rhs.upstream()) {}
+
+  [[nodiscard]] T *allocate(size_type n) {
+    if (auto p = m_buffer->template try_allocate<T>(n))
+      return p;
+    return m_upstream.allocate(n);
+  }
+
+  void deallocate(T *p, size_type n) {
+    if (m_buffer->owns(p))
+      m_buffer->deallocate(p, n);
+    else
+      m_upstream.deallocate(p, n);
+  }
+
+  StackBuffer<N> *buffer() const noexcept { return m_buffer; }
+  const Upstream &upstream() const noexcept { return m_upstream; }
 
 private:
-  StackBuffer<N> &m_buffer;
+  StackBuffer<N> *m_buffer;
+  Upstream m_upstream;
 };
 
+template <class T1, class T2, size_t N, class Upstream1, class Upstream2>
+bool operator==(const StackAllocator<T1, N, Upstream1> &lhs, const StackAllocator<T2, N, Upstream2> &rhs) noexcept {
+  return lhs.buffer() == rhs.buffer();
+}
+
 } // namespace aria
\ No newline at end of file
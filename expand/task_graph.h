@@ -0,0 +1,131 @@
+#pragma once
+#include "functional.h"
+#include "memory.h"
+#include "stdexcept.h"
+#include "task_group.h"
+#include "vector.h"
+#include <atomic>
+
+// A graph of tasks and the dependencies between them, which runs on a ThreadPool. Each task counts down its predecessors,
+// and the predecessor which finishes the last of them schedules it, so no thread blocks on a dependency. The graph can be
+// run again, e.g. once per batch:
+//   task_graph g;
+//   auto decode = g.emplace([&] { ... });
+//   auto validate = g.emplace([&] { ... });
+//   decode.precede(validate);
+//   g.run(pool);
+namespace aria {
+
+class task_graph {
+  struct node {
+    template <class F> node(size_t i, F &&fn) : index(i), f(forward<F>(fn)) {}
+
+    size_t index;
+    move_only_function<void()> f;
+    vector<node *> successors;
+    int num_predecessors = 0;
+    std::atomic<int> remaining = 0; // the predecessors which haven't finished in this run
+  };
+
+public:
+  // a handle to a task of the graph
+  class task {
+  public:
+    // this task finishes before next starts
+    task &precede(task next) {
+      m_node->successors.push_back(next.m_node);
+      next.m_node->num_predecessors++;
+      m_graph->m_checked = false;
+      return *this;
+    }
+
+    task &succeed(task prev) {
+      prev.precede(*this);
+      return *this;
+    }
+
+  private:
+    friend class task_graph;
+    task(task_graph *graph, node *n) noexcept : m_graph(graph), m_node(n) {}
+
+    task_graph *m_graph;
+    node *m_node;
+  };
+
+  task_graph() = default;
+  task_graph(const task_graph &) = delete;
+  task_graph &operator=(const task_graph &) = delete;
+
+  template <class F> task emplace(F &&f) {
+    m_nodes.push_back(make_unique<node>(m_nodes.size(), forward<F>(f)));
+    return task(this, m_nodes.back().get());
+  }
+
+  size_t size() const noexcept { return m_nodes.size(); }
+  bool empty() const noexcept { return m_nodes.empty(); }
+
+  // Runs the tasks and waits for them, running the queued tasks of the pool meanwhile like task_group::wait(). The first
+  // exception thrown by a task is rethrown, and the tasks which haven't started by then are skipped. The graph can't be
+  // changed or run again until it returns
+  void run(ThreadPool &pool = default_thread_pool()) {
+    check_acyclic();
+    for (auto &n : m_nodes)
+      n->remaining.store(n->num_predecessors, std::memory_order_relaxed);
+    task_group group(pool);
+    for (auto &n : m_nodes) {
+      if (n->num_predecessors == 0)
+        group.run([&group, p = n.get()] { run_from(group, p); });
+    }
+    group.wait();
+  }
+
+private:
+  // runs n, then one of the successors which became ready on the same thread, and schedules the others. Stops once the
+  // group is cancelled, as the tasks scheduled by the group would be skipped
+  static void run_from(task_group &group, node *n) {
+    while (n && !group.is_cancelled()) {
+      n->f();
+      node *next = nullptr;
+      for (auto s : n->successors) {
+        if (s->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+          continue;
+        if (next)
+          group.run([&group, s] { run_from(group, s); });
+        else
+          next = s;
+      }
+      n = next;
+    }
+  }
+
+  // the tasks of a cycle would never start, so a graph with one isn't run
+  void check_acyclic() {
+    if (m_checked)
+      return;
+    vector<int> remaining;
+    vector<node *> ready;
+    for (auto &n : m_nodes) {
+      remaining.push_back(n->num_predecessors);
+      if (n->num_predecessors == 0)
+        ready.push_back(n.get());
+    }
+    size_t num_visited = 0;
+    while (!ready.empty()) {
+      auto n = ready.back();
+      ready.pop_back();
+      num_visited++;
+      for (auto s : n->successors) {
+        if (--remaining[s->index] == 0)
+          ready.push_back(s);
+      }
+    }
+    if (num_visited != m_nodes.size())
+      throw invalid_argument("aria::task_graph has a cycle");
+    m_checked = true;
+  }
+
+  vector<unique_ptr<node>> m_nodes;
+  bool m_checked = true;
+};
+
+} // namespace aria
\ No newline at end of file
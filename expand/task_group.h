@@ -0,0 +1,199 @@
+#pragma once
+#include "bit.h"
+#include "concepts.h"
+#include "iterator.h"
+#include "thread_pool.h"
+#include "type_traits.h"
+#include "utility.h"
+#include <atomic>
+#include <exception>
+#include <future> //future_error
+#include <thread>
+
+// Fork-join on a ThreadPool. A task_group runs tasks on the pool, and wait() runs the queued tasks on the waiting thread
+// until those of the group are done, so a task which waits for the tasks it started doesn't take a thread away from them.
+// parallel_invoke and parallel_for are built on it, and can be nested without a deadlock.
+//   task_group g(pool);
+//   g.run([&] { left = count(a); });
+//   g.run([&] { right = count(b); });
+//   g.wait();
+namespace aria {
+
+namespace _task_group {
+// shared with the tasks, since the last one notifies the waiter after it is counted as done
+struct state {
+  void add_ref() noexcept { refs.fetch_add(1, std::memory_order_relaxed); }
+
+  void release() noexcept {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete this;
+  }
+
+  // the first exception cancels the group: the tasks which haven't started are skipped
+  void fail(std::exception_ptr e) noexcept {
+    if (!cancelled.exchange(true, std::memory_order_relaxed))
+      exception = move(e);
+  }
+
+  std::atomic<int> refs = 1;
+  std::atomic<int64_t> pending = 0;
+  std::atomic<int> waiters = 0; // the threads blocked in join(), which run() wakes to take the new task
+  std::atomic_bool cancelled = false;
+  std::exception_ptr exception;
+};
+
+// a task of the group, which counts itself as done once it has run, or when it is destroyed without running, e.g. purged
+template <class F> class task {
+public:
+  template <class G> task(state *s, G &&f) : m_state(s), m_f(forward<G>(f)) { s->add_ref(); }
+  task(task &&rhs) noexcept : m_state(exchange(rhs.m_state, nullptr)), m_f(move(rhs.m_f)) {}
+  task &operator=(task &&) = delete;
+
+  ~task() {
+    if (m_state) {
+      m_state->fail(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+      done(m_state);
+    }
+  }
+
+  void operator()() {
+    auto s = exchange(m_state, nullptr);
+    if (!s->cancelled.load(std::memory_order_relaxed)) {
+      try {
+        m_f();
+      } catch (...) {
+        s->fail(std::current_exception());
+      }
+    }
+    done(s);
+  }
+
+private:
+  static void done(state *s) noexcept {
+    if (s->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      s->pending.notify_all();
+    s->release();
+  }
+
+  state *m_state;
+  F m_f;
+};
+} // namespace _task_group
+
+class task_group {
+public:
+  explicit task_group(ThreadPool &pool = default_thread_pool()) : m_pool(pool), m_state(new _task_group::state) {}
+
+  // waits for the tasks, their exceptions are dropped
+  ~task_group() {
+    join();
+    m_state->release();
+  }
+
+  task_group(const task_group &) = delete;
+  task_group &operator=(const task_group &) = delete;
+
+  // can be called by the tasks of the group too
+  template <class F> void run(F &&f) {
+    // seq_cst with the waiters in join(): either the waiter sees the new count, or this sees the waiter
+    m_state->pending.fetch_add(1);
+    m_pool.detach_task(_task_group::task<decay_t<F>>(m_state, forward<F>(f)));
+    if (m_state->waiters.load() != 0)
+      m_state->pending.notify_all();
+  }
+
+  // Runs the queued tasks, of this group or not, until the tasks of the group are done, then rethrows the first exception
+  // one of them threw. The group can run tasks again afterwards
+  void wait() {
+    join();
+    if (m_state->cancelled.load(std::memory_order_relaxed)) {
+      m_state->cancelled.store(false, std::memory_order_relaxed);
+      std::rethrow_exception(exchange(m_state->exception, nullptr));
+    }
+  }
+
+  // whether a task of the group has thrown since the last wait(), then the tasks which haven't started are skipped
+  bool is_cancelled() const noexcept { return m_state->cancelled.load(std::memory_order_relaxed); }
+
+private:
+  // blocks only when nothing is queued, then the tasks of the group are running on other threads. It wakes when they
+  // are done, or when one of them runs another task of the group, which may be queued for this thread to take
+  void join() {
+    auto &pending = m_state->pending;
+    for (auto n = pending.load(std::memory_order_acquire); n != 0; n = pending.load(std::memory_order_acquire)) {
+      if (!m_pool.run_pending_task()) {
+        m_state->waiters.fetch_add(1);
+        pending.wait(n);
+        m_state->waiters.fetch_sub(1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  ThreadPool &m_pool;
+  _task_group::state *m_state;
+};
+
+// calls f and fs in parallel, f on the calling thread
+template <class F, class... Fs> void parallel_invoke(ThreadPool &pool, F &&f, Fs &&...fs) {
+  task_group group(pool);
+  (group.run([&fs] { fs(); }), ...);
+  f();
+  group.wait();
+}
+
+template <class F, class... Fs> requires is_invocable_v<F &> void parallel_invoke(F &&f, Fs &&...fs) {
+  parallel_invoke(default_thread_pool(), forward<F>(f), forward<Fs>(fs)...);
+}
+
+namespace _task_group {
+template <class It> concept index = integral<It> || random_access_iterator<It>;
+
+// a range is split in two up to split_depth times, which makes about 4 pieces per thread, and split_depth_when_stolen
+// more times once a piece runs on another thread, as that thread had nothing else to run
+inline int split_depth(const ThreadPool &pool) { return bit_width(pool.size() + 1) + 2; }
+inline constexpr int split_depth_when_stolen = 2;
+
+template <class Body> struct for_context {
+  ptrdiff_t grain;
+  Body &body;
+  task_group group; // the last member, so it waits for the tasks before the others are destroyed
+};
+
+template <class It, class Body> void run_range(for_context<Body> &ctx, It first, It last, int depth, std::thread::id owner) {
+  const auto self = std::this_thread::get_id();
+  if (self != owner)
+    depth += split_depth_when_stolen;
+  for (; ptrdiff_t(last - first) > ctx.grain && depth > 0; depth--) {
+    const auto mid = first + (last - first) / 2;
+    ctx.group.run([&ctx, mid, last, depth, self] { run_range(ctx, mid, last, depth - 1, self); });
+    last = mid;
+  }
+  ctx.body(first, last);
+}
+} // namespace _task_group
+
+// Calls body(b, e) for the sub ranges [b, e) of [first, last), which are indices or random access iterators, in parallel.
+// The range is split in halves as long as they have more than grain elements, adaptively: into a few pieces per thread, and
+// again when a thread is idle and takes a piece. So grain only needs to be large enough to pay for running a task.
+template <_task_group::index It, class Body> void parallel_for(ThreadPool &pool, It first, It last, ptrdiff_t grain, Body &&body) {
+  if (grain < 1)
+    grain = 1;
+  if (ptrdiff_t(last - first) <= grain) {
+    if (first != last)
+      body(first, last);
+    return;
+  }
+  _task_group::for_context<Body> ctx{grain, body, task_group(pool)};
+  _task_group::run_range(ctx, first, last, _task_group::split_depth(pool), std::this_thread::get_id());
+  ctx.group.wait();
+}
+
+template <_task_group::index It, class Body> void parallel_for(ThreadPool &pool, It first, It last, Body &&body) {
+  parallel_for(pool, first, last, 1, body);
+}
+
+template <_task_group::index It, class Body> void parallel_for(It first, It last, Body &&body) {
+  parallel_for(default_thread_pool(), first, last, 1, body);
+}
+
+} // namespace aria
\ No newline at end of file
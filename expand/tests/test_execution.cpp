@@ -0,0 +1,106 @@
+#include "../execution.h"
+#include "mystring.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+
+using namespace aria;
+
+namespace {
+vector<int> make_input(int n) {
+  unsigned x = 1;
+  vector<int> v;
+  for (int i = 0; i < n; i++)
+    v.push_back(int((x = x * 1103515245 + 12345) >> 8) % 100000);
+  return v;
+}
+} // namespace
+
+TEST(test_execution, for_each_transform) {
+  ThreadPool pool(3);
+  pool.start();
+  for (int n : {0, 1, 7, 100000}) {
+    auto v = make_input(n);
+    std::atomic<long long> sum = 0;
+    for_each(execution::par.on(pool), v.begin(), v.end(), [&](int x) { sum += x; });
+    EXPECT_EQ(sum, accumulate(v.begin(), v.end(), 0LL));
+
+    vector<int> out(n), expected(n);
+    EXPECT_EQ(transform(execution::par.on(pool), v.begin(), v.end(), out.begin(), [](int x) { return x * 2; }), out.end());
+    transform(execution::seq, v.begin(), v.end(), expected.begin(), [](int x) { return x * 2; });
+    EXPECT_EQ(out, expected);
+    transform(execution::par_unseq, v.begin(), v.end(), out.begin(), out.begin(), [](int x, int y) { return x + y; });
+    for (int i = 0; i < n; i++)
+      expected[i] += v[i];
+    EXPECT_EQ(out, expected);
+  }
+  pool.stop();
+}
+
+TEST(test_execution, reduce_scan) {
+  const auto v = make_input(100000);
+  const auto sum = accumulate(v.begin(), v.end(), 0LL);
+  EXPECT_EQ(reduce(execution::par, v.begin(), v.end(), 0LL), sum);
+  EXPECT_EQ(reduce(execution::par, v.begin(), v.begin()), 0);
+  EXPECT_EQ(transform_reduce(execution::par, v.begin(), v.end(), 0LL, plus{}, [](int x) { return x % 2; }),
+            count_if(v.begin(), v.end(), [](int x) { return x % 2; }));
+  EXPECT_EQ(transform_reduce(execution::par, v.begin(), v.end(), v.begin(), 0.0), transform_reduce(v.begin(), v.end(), v.begin(), 0.0));
+  EXPECT_EQ(count_if(execution::par, v.begin(), v.end(), [](int x) { return x < 500; }),
+            count_if(v.begin(), v.end(), [](int x) { return x < 500; }));
+
+  const vector<long long> w(v.begin(), v.end());
+  vector<long long> scan(w.size()), expected(w.size());
+  inclusive_scan(w.begin(), w.end(), expected.begin());
+  EXPECT_EQ(inclusive_scan(execution::par, w.begin(), w.end(), scan.begin()), scan.end());
+  EXPECT_EQ(scan, expected);
+  EXPECT_EQ(scan.back(), sum);
+
+  vector<int> selected(v.size());
+  auto last = copy_if(execution::par, v.begin(), v.end(), selected.begin(), [](int x) { return x % 3 == 0; });
+  vector<int> expected_selected(v.size());
+  auto expected_last = copy_if(v.begin(), v.end(), expected_selected.begin(), [](int x) { return x % 3 == 0; });
+  EXPECT_EQ(last - selected.begin(), expected_last - expected_selected.begin());
+  EXPECT_TRUE(equal(selected.begin(), last, expected_selected.begin()));
+}
+
+TEST(test_execution, sort) {
+  for (int n : {0, 1, 100, 100000}) {
+    auto v = make_input(n);
+    auto expected = v;
+    std::sort(expected.begin(), expected.end());
+    sort(execution::par, v.begin(), v.end());
+    EXPECT_EQ(v, expected);
+    sort(execution::par, v.begin(), v.end(), greater{});
+    EXPECT_TRUE(is_sorted(v.begin(), v.end(), greater{}));
+  }
+
+  // the merges move the elements between the range and the buffer, a moved-from string would show up here
+  for (int threads : {1, 2, 3, 6}) {
+    ThreadPool pool(threads);
+    pool.start();
+    for (int n : {2, 3, 1000, 30001}) {
+      vector<string> v, expected;
+      for (auto x : make_input(n)) {
+        string s = "key ";
+        s += to_string(x);
+        v.push_back(s);
+        expected.push_back(v.back());
+      }
+      std::sort(expected.begin(), expected.end());
+      sort(execution::par.on(pool), v.begin(), v.end());
+      EXPECT_EQ(v, expected);
+    }
+    pool.stop();
+  }
+}
+
+// a parallel algorithm called from the tasks of another one doesn't wait for the busy workers
+TEST(test_execution, nested) {
+  ThreadPool pool(2);
+  pool.start();
+  vector<int> sums(8);
+  const auto v = make_input(10000);
+  for_each(execution::par.on(pool), sums.begin(), sums.end(), [&](int &sum) { sum = reduce(execution::par.on(pool), v.begin(), v.end()); });
+  EXPECT_TRUE(all_of(sums.begin(), sums.end(), [&](int sum) { return sum == accumulate(v.begin(), v.end(), 0); }));
+  pool.stop();
+}
\ No newline at end of file
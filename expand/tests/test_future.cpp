@@ -0,0 +1,53 @@
+#include "future.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace aria;
+
+TEST(test_future, basic) {
+  promise<std::string> p;
+  auto f = p.get_future();
+  EXPECT_TRUE(f.valid());
+  EXPECT_FALSE(f.is_ready());
+  std::jthread t([&] { p.set_value("done"); });
+  EXPECT_EQ(f.get(), "done");
+  EXPECT_FALSE(f.valid());
+
+  promise<void> pv;
+  auto fv = pv.get_future();
+  pv.set_value();
+  fv.wait();
+  EXPECT_TRUE(fv.is_ready());
+  fv.get();
+
+  // the result is moved out
+  promise<std::unique_ptr<int>> pu;
+  auto fu = pu.get_future();
+  pu.set_value(std::make_unique<int>(3));
+  EXPECT_EQ(*fu.get(), 3);
+}
+
+TEST(test_future, exception) {
+  promise<int> p;
+  auto f = p.get_future();
+  p.set_exception(std::make_exception_ptr(std::runtime_error("failed")));
+  EXPECT_THROW(f.get(), std::runtime_error);
+
+  future<int> broken;
+  {
+    promise<int> p2;
+    broken = p2.get_future();
+  }
+  EXPECT_THROW(broken.get(), std::future_error);
+
+  // the state outlives whichever of the promise and the future is destroyed first
+  auto p3 = std::make_unique<promise<int>>();
+  {
+    auto f3 = p3->get_future();
+  }
+  p3->set_value(1);
+  p3.reset();
+}
@@ -14,4 +14,57 @@ TEST(test_stack_allocator, basic) {
   for (int i = 0; i < 100; i++) {
     EXPECT_EQ(v[i], i);
   }
-}
\ No newline at end of file
+}
+TEST(test_stack_allocator, lifo) {
+  StackBuffer<1024> buf;
+  auto p1 = buf.allocate<int>(10);
+  auto p2 = buf.allocate<char>(3);
+  EXPECT_EQ(buf.used(), 43);
+  buf.deallocate(p1, 10); // not the most recent one
+  EXPECT_EQ(buf.used(), 43);
+  buf.deallocate(p2, 3);
+  EXPECT_EQ(buf.used(), 40);
+  auto p3 = buf.allocate<double>(1); // aligned after p1
+  EXPECT_EQ(reinterpret_cast<char *>(p3) - reinterpret_cast<char *>(p1), 40);
+  EXPECT_EQ(buf.try_allocate<char>(1024), nullptr);
+  EXPECT_THROW(buf.allocate<char>(1024), bad_alloc);
+}
+
+TEST(test_stack_allocator, mark) {
+  StackBuffer<1024> buf;
+  buf.allocate<int>(4);
+  const auto m = buf.mark();
+  buf.allocate<int>(100);
+  buf.release_to(m);
+  EXPECT_EQ(buf.used(), 16);
+  {
+    StackBufferScope scope(buf);
+    buf.allocate<char>(500);
+  }
+  EXPECT_EQ(buf.used(), 16);
+}
+
+TEST(test_stack_allocator, fallback) {
+  StackBuffer<256> buf;
+  StackAllocator<int, 256> alloc(buf);
+  {
+    // the vector starts in the buffer, and moves to the heap once the buffer is exhausted
+    StackBufferScope scope(buf);
+    vector<int, decltype(alloc)> v(alloc);
+    for (int i = 0; i < 16; i++)
+      v.push_back(i);
+    EXPECT_TRUE(buf.owns(v.data()));
+    for (int i = 16; i < 1000; i++)
+      v.push_back(i);
+    EXPECT_FALSE(buf.owns(v.data()));
+    for (int i = 0; i < 1000; i++)
+      EXPECT_EQ(v[i], i);
+  }
+  EXPECT_EQ(buf.used(), 0);
+
+  StackAllocator<double, 256> rebound = alloc;
+  EXPECT_TRUE(rebound == alloc);
+  auto p = rebound.allocate(100);
+  EXPECT_FALSE(buf.owns(p));
+  rebound.deallocate(p, 100);
+}
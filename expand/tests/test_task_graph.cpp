@@ -0,0 +1,127 @@
+#include "task_graph.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace aria;
+
+TEST(test_task_graph, pipeline) {
+  ThreadPool pool(3);
+  pool.start();
+  task_graph g;
+  EXPECT_TRUE(g.empty());
+  g.run(pool);
+
+  // decode -> validate -> index -> publish, and validate -> audit -> publish
+  std::atomic<int> clock = 0;
+  int decoded = 0, validated = 0, indexed = 0, audited = 0, published = 0;
+  auto decode = g.emplace([&] { decoded = ++clock; });
+  auto validate = g.emplace([&] { validated = ++clock; });
+  auto index = g.emplace([&] { indexed = ++clock; });
+  auto audit = g.emplace([&] { audited = ++clock; });
+  auto publish = g.emplace([&] { published = ++clock; });
+  decode.precede(validate);
+  validate.precede(index).precede(audit);
+  publish.succeed(index).succeed(audit);
+  EXPECT_EQ(g.size(), 5);
+
+  // the graph is reused
+  for (int i = 0; i < 100; i++) {
+    clock = 0;
+    g.run(pool);
+    EXPECT_EQ(decoded, 1);
+    EXPECT_EQ(validated, 2);
+    EXPECT_GT(indexed, validated);
+    EXPECT_GT(audited, validated);
+    EXPECT_EQ(published, 5);
+  }
+  pool.stop();
+}
+
+// layers of tasks, each of which depends on a few tasks of the layer before
+TEST(test_task_graph, layers) {
+  ThreadPool pool(3);
+  pool.start();
+  const int width = 50, depth = 20;
+  std::vector<long long> values(width * depth);
+  std::vector<task_graph::task> tasks;
+  task_graph g;
+  for (int layer = 0; layer < depth; layer++) {
+    for (int i = 0; i < width; i++) {
+      const int id = layer * width + i;
+      tasks.push_back(g.emplace([&values, id, layer, i] {
+        values[id] = 1;
+        if (layer > 0) {
+          for (int j : {i, (i + 1) % width, (i + 7) % width})
+            values[id] += values[(layer - 1) * width + j];
+        }
+      }));
+      if (layer > 0) {
+        for (int j : {i, (i + 1) % width, (i + 7) % width})
+          tasks[(layer - 1) * width + j].precede(tasks[id]);
+      }
+    }
+  }
+  for (int k = 0; k < 3; k++) {
+    std::fill(values.begin(), values.end(), 0);
+    g.run(pool);
+    long long expected = 1;
+    for (int layer = 0; layer < depth; layer++, expected = 3 * expected + 1) {
+      for (int i = 0; i < width; i++)
+        EXPECT_EQ(values[layer * width + i], expected);
+    }
+  }
+  pool.stop();
+}
+
+TEST(test_task_graph, errors) {
+  ThreadPool pool(2);
+  pool.start();
+  task_graph g;
+  bool fail = true, ran = false;
+  auto a = g.emplace([&] {
+    if (fail)
+      throw std::runtime_error("failed");
+  });
+  auto b = g.emplace([&] { ran = true; });
+  a.precede(b);
+  EXPECT_THROW(g.run(pool), std::runtime_error);
+  EXPECT_FALSE(ran);
+  fail = false;
+  g.run(pool);
+  EXPECT_TRUE(ran);
+
+  // a task can wait for tasks of the same pool
+  std::atomic<int> n = 0;
+  g.emplace([&] { parallel_for(pool, 0, 1000, [&](int i, int j) { n += j - i; }); }).succeed(b);
+  g.run(pool);
+  EXPECT_EQ(n, 1000);
+
+  // the successor of a running task doesn't start once another task has thrown
+  task_graph g2;
+  std::atomic<bool> started = false, thrown = false, after = false;
+  auto slow = g2.emplace([&] {
+    started = true;
+    while (!thrown)
+      std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  });
+  slow.precede(g2.emplace([&] { after = true; }));
+  g2.emplace([&] {
+    while (!started)
+      std::this_thread::yield();
+    thrown = true;
+    throw std::runtime_error("failed");
+  });
+  EXPECT_THROW(g2.run(pool), std::runtime_error);
+  EXPECT_FALSE(after);
+
+  auto c = g.emplace([] {});
+  b.precede(c);
+  c.precede(a);
+  EXPECT_THROW(g.run(pool), invalid_argument);
+  pool.stop();
+}
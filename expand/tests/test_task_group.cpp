@@ -0,0 +1,133 @@
+#include "task_group.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using namespace aria;
+
+namespace {
+long long fib(ThreadPool &pool, int n) {
+  if (n < 2)
+    return n;
+  long long a = 0, b = 0;
+  parallel_invoke(pool, [&] { a = fib(pool, n - 1); }, [&] { b = fib(pool, n - 2); });
+  return a + b;
+}
+} // namespace
+
+TEST(test_task_group, run_wait) {
+  ThreadPool pool(3);
+  pool.start();
+  task_group g(pool);
+  std::atomic<int> n = 0;
+  for (int i = 0; i < 1000; i++)
+    g.run([&] { n++; });
+  g.wait();
+  EXPECT_EQ(n, 1000);
+
+  // the tasks of a group can run more tasks of it, and the group can be reused after wait
+  g.run([&] {
+    for (int i = 0; i < 100; i++)
+      g.run([&] { n++; });
+  });
+  g.wait();
+  EXPECT_EQ(n, 1100);
+
+  g.run([] { throw std::runtime_error("failed"); });
+  g.run([&] { n++; });
+  EXPECT_THROW(g.wait(), std::runtime_error);
+  g.run([&] { n++; });
+  EXPECT_NO_THROW(g.wait());
+  pool.stop();
+}
+
+// the waiting thread runs the tasks, so a group waits even on a pool which isn't started
+TEST(test_task_group, helping_wait) {
+  ThreadPool pool(2);
+  task_group g(pool);
+  int n = 0;
+  g.run([&] { n++; });
+  g.run([&] { n++; });
+  g.wait();
+  EXPECT_EQ(n, 2);
+
+  ThreadPool empty_pool(0);
+  EXPECT_EQ(fib(empty_pool, 10), 55);
+}
+
+// the only worker is busy until the task it queued has run, so the waiting thread must wake up and take it
+TEST(test_task_group, wait_wakes_on_run) {
+  ThreadPool pool(1);
+  pool.start();
+  task_group g(pool);
+  std::atomic<bool> started = false, inner_done = false;
+  g.run([&] {
+    started = true;
+    started.notify_all();
+    // give the waiting thread time to block
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    g.run([&] {
+      inner_done = true;
+      inner_done.notify_all();
+    });
+    inner_done.wait(false);
+  });
+  started.wait(false);
+  g.wait();
+  EXPECT_TRUE(inner_done);
+  pool.stop();
+}
+
+TEST(test_task_group, parallel_invoke) {
+  int a = 0, b = 0, c = 0;
+  parallel_invoke([&] { a = 1; }, [&] { b = 2; }, [&] { c = 3; });
+  EXPECT_EQ(a + b + c, 6);
+
+  // nested on a pool smaller than the recursion
+  ThreadPool pool(2);
+  pool.start();
+  EXPECT_EQ(fib(pool, 20), 6765);
+  EXPECT_THROW(parallel_invoke(pool, [] {}, [] { throw std::runtime_error("failed"); }), std::runtime_error);
+  pool.stop();
+}
+
+TEST(test_task_group, parallel_for) {
+  ThreadPool pool(3);
+  pool.start();
+  for (int n : {0, 1, 7, 1000, 100000}) {
+    for (ptrdiff_t grain : {0, 1, 16, 100000}) {
+      std::vector<int> v(n);
+      parallel_for(pool, 0, n, grain, [&](int b, int e) {
+        EXPECT_TRUE(b < e);
+        for (int i = b; i < e; i++)
+          v[i]++;
+      });
+      EXPECT_EQ(std::count(v.begin(), v.end(), 1), n);
+    }
+  }
+
+  std::vector<long long> v(10000);
+  parallel_for(v.begin(), v.end(), [](auto b, auto e) {
+    for (; b != e; ++b)
+      *b = 1;
+  });
+  EXPECT_EQ(std::accumulate(v.begin(), v.end(), 0LL), 10000);
+
+  // nested, each worker waits for an inner loop while the outer one has pieces left
+  std::vector<long long> sums(64);
+  parallel_for(pool, sums.begin(), sums.end(), [&](auto b, auto e) {
+    for (; b != e; ++b) {
+      std::atomic<long long> sum = 0;
+      parallel_for(pool, 0, 1000, 10, [&](int i, int j) { sum += j - i; });
+      *b = sum;
+    }
+  });
+  EXPECT_TRUE(std::all_of(sums.begin(), sums.end(), [](long long sum) { return sum == 1000; }));
+
+  EXPECT_THROW(parallel_for(pool, 0, 1000, [](int, int) { throw std::runtime_error("failed"); }), std::runtime_error);
+  pool.stop();
+}
@@ -2,6 +2,7 @@
 #include "gtest/gtest.h"
 #include <set>
 #include <thread>
+#include <vector>
 
 using namespace aria;
 
@@ -39,4 +40,132 @@ TEST(test_thread_pool, start_stop) {
   tp.detach_task([] { });
   tp.start();
   tp.stop();
+}
+
+// tasks which submit tasks from the workers, as a parallel divide and conquer does
+TEST(test_thread_pool, nested_tasks) {
+  std::atomic<int> count = 0;
+  std::atomic<int> pending = 1;
+  std::function<void(int)> spawn;
+  ThreadPool tp(4); // joins its workers before spawn is destroyed
+  spawn = [&](int depth) {
+    count++;
+    if (depth > 0) {
+      pending += 2;
+      tp.detach_task([&, depth] { spawn(depth - 1); });
+      tp.detach_task([&, depth] { spawn(depth - 1); });
+    }
+    if (--pending == 0)
+      pending.notify_all();
+  };
+  tp.start();
+  tp.detach_task([&] { spawn(14); });
+  for (int p = pending; p != 0; p = pending)
+    pending.wait(p);
+  EXPECT_EQ(count, (1 << 15) - 1);
+  tp.stop();
+}
+
+TEST(test_thread_pool, pause_purge) {
+  ThreadPool tp(2);
+  std::atomic<int> count = 0;
+  tp.start();
+  tp.pause();
+  for (int i = 0; i < 100; i++)
+    tp.detach_task([&] { count++; });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(count, 0);
+  tp.purge();
+  auto f = tp.submit_task([&] { return ++count; });
+  tp.unpause();
+  EXPECT_EQ(f.get(), 1);
+  tp.stop();
+
+  // a stopped pool keeps its tasks until it is started again
+  f = tp.submit_task([&] { return ++count; });
+  tp.start();
+  EXPECT_EQ(f.get(), 2);
+  tp.stop();
+}
+
+TEST(test_thread_pool, submit) {
+  ThreadPool tp(2);
+  tp.start();
+  // a move only task
+  auto f1 = tp.submit_task([p = std::make_unique<int>(7)] { return *p; });
+  auto f2 = tp.submit_task([]() -> int { throw std::runtime_error("failed"); });
+  auto f3 = tp.submit_task([] {});
+  EXPECT_EQ(f1.get(), 7);
+  EXPECT_THROW(f2.get(), std::runtime_error);
+  f3.get();
+  // a reference result refers to the original object
+  int x = 1;
+  auto f4 = tp.submit_task([&x]() -> int & { return x; });
+  EXPECT_EQ(&f4.get(), &x);
+
+  tp.pause();
+  auto purged = tp.submit_task([] { return 1; });
+  tp.purge();
+  EXPECT_THROW(purged.get(), std::future_error);
+  tp.stop();
+}
+
+TEST(test_thread_pool, priority) {
+  using namespace std::chrono_literals;
+  ThreadPool tp(1);
+  tp.start();
+  tp.pause();
+  std::vector<int> order;
+  auto record = [&](int i) { return [&order, i] { order.push_back(i); }; };
+  const auto now = ThreadPool::clock_type::now();
+  tp.detach_task(record(5), task_priority::low);
+  tp.detach_task(record(4), task_priority::normal);
+  tp.detach_task(record(6), task_priority::low);
+  tp.detach_task(record(2), task_priority::high);
+  tp.detach_task(record(7), now + 1h);
+  tp.detach_task(record(3), task_priority::high);
+  tp.detach_task(record(1), now - 1s);
+  auto f = tp.submit_task(record(8), now + 2h);
+  tp.unpause();
+  f.get();
+  EXPECT_EQ(order, std::vector<int>({1, 2, 3, 4, 5, 6, 7, 8}));
+
+  // a low priority task which waited more than 2 aging periods goes ahead of a high priority one
+  tp.set_aging_period(1ms);
+  tp.pause();
+  order.clear();
+  tp.detach_task(record(1), task_priority::low);
+  std::this_thread::sleep_for(10ms);
+  tp.detach_task(record(2), task_priority::high);
+  auto g = tp.submit_task(record(3), task_priority::normal);
+  tp.unpause();
+  g.get();
+  EXPECT_EQ(order, std::vector<int>({1, 2, 3}));
+
+  // a worker takes a deadline task ahead of its own deque only if it is due within an aging period
+  order.clear();
+  std::atomic<int> num_done = 0;
+  auto record_done = [&](int i) {
+    return [&order, &num_done, i] {
+      order.push_back(i);
+      num_done++;
+      num_done.notify_all();
+    };
+  };
+  tp.detach_task([&] {
+    tp.detach_task(record_done(3));
+    tp.detach_task(record_done(2));
+    tp.detach_task(record_done(4), ThreadPool::clock_type::now() + 1h);
+    tp.detach_task(record_done(1), ThreadPool::clock_type::now());
+  });
+  for (int n = num_done; n < 4; n = num_done)
+    num_done.wait(n);
+  EXPECT_EQ(order, std::vector<int>({1, 2, 3, 4}));
+
+  tp.pause();
+  auto purged = tp.submit_task([] {}, task_priority::high);
+  tp.detach_task([] {}, now);
+  tp.purge();
+  EXPECT_THROW(purged.get(), std::future_error);
+  tp.stop();
 }
\ No newline at end of file
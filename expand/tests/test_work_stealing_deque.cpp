@@ -0,0 +1,59 @@
+#include "work_stealing_deque.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace aria;
+
+TEST(test_work_stealing_deque, basic) {
+  work_stealing_deque<int> q(2);
+  std::vector<int> v(10);
+  EXPECT_EQ(q.pop(), nullptr);
+  EXPECT_EQ(q.steal(), nullptr);
+  for (auto &x : v)
+    q.push(&x);
+  EXPECT_EQ(q.size(), 10);
+  EXPECT_EQ(q.pop(), &v[9]);
+  EXPECT_EQ(q.steal(), &v[0]);
+  EXPECT_EQ(q.steal(), &v[1]);
+  EXPECT_EQ(q.pop(), &v[8]);
+  EXPECT_EQ(q.size(), 6);
+  while (q.pop()) {
+  }
+  EXPECT_TRUE(q.empty());
+}
+
+// every element is taken exactly once, by the owner or one of the thieves
+TEST(test_work_stealing_deque, concurrent_steal) {
+  const int n = 100000;
+  std::vector<int> items(n);
+  std::vector<std::atomic<int>> taken(n);
+  work_stealing_deque<int> q;
+  std::atomic_bool done = false;
+
+  auto take = [&](int *p) { taken[p - items.data()]++; };
+  std::vector<std::jthread> thieves;
+  for (int i = 0; i < 3; i++) {
+    thieves.emplace_back([&] {
+      while (!done)
+        if (auto p = q.steal())
+          take(p);
+    });
+  }
+
+  for (int i = 0; i < n; i++) {
+    q.push(&items[i]);
+    if (i % 3 == 0)
+      if (auto p = q.pop())
+        take(p);
+  }
+  while (auto p = q.pop())
+    take(p);
+  done = true;
+  thieves.clear();
+
+  EXPECT_TRUE(q.empty());
+  for (auto &x : taken)
+    EXPECT_EQ(x, 1);
+}
@@ -1,3 +1,5 @@
+#pragma once
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <future>
@@ -7,31 +9,90 @@
 #include <thread>
 #include <vector>
 
+#include "functional.h"
+#include "future.h"
+#include "priority_queue.h"
 #include "synchronized.h"
+#include "vector.h"
+#include "work_stealing_deque.h"
 #include <iostream>
 
 namespace aria {
 
+namespace _thread_pool {
+// the memory of deleted tasks, a free list through the blocks themselves
+struct task_cache {
+  struct block {
+    block *next;
+  };
+  static constexpr size_t s_max_size = 1024;
+
+  ~task_cache() {
+    while (head)
+      ::operator delete(exchange(head, head->next));
+    s_destroyed = true;
+  }
+
+  // trivially destructible, so it can be read after the cache is destroyed, until the thread ends
+  inline static thread_local bool s_destroyed = false;
+
+  block *head = nullptr;
+  size_t size = 0;
+};
+} // namespace _thread_pool
+
+enum class task_priority : unsigned char { high, normal, low };
+
 /*
 reference: https://github.com/bshoshany/thread-pool/blob/master/README.md
+
+Each worker has a work_stealing_deque. A task submitted by a worker goes to its own deque, which it pops in LIFO order,
+and a task submitted by another thread goes to the injection queues. A worker which runs out of tasks takes one
+from the injection queues, then steals from the other workers, starting at a random one. So submitting from a worker
+and running the tasks don't take a lock, as long as no worker sleeps.
+
+A task can be submitted with a priority or a deadline, then it goes to the injection queues even from a worker: a FIFO
+lane per priority, and a heap ordered by deadline. Each task there is due at its deadline, or at its submit time plus
+a number of aging periods, 0 for high, 1 for normal and 2 for low priority, and the task due the earliest is taken first.
+So a high priority task goes ahead of the lower priority ones submitted up to a few periods before it, but they don't
+starve. A lane is FIFO, so a task is due no earlier than the one before it in the lane, even if the aging period was
+shortened in between. Workers take the high priority tasks, and the deadline tasks due within an aging period of their
+submission, ahead of those in their own deques too.
+
+A task is a move_only_function, which stores a small callable inline, and the memory of the tasks which have run is
+reused by the thread which ran them. So in a steady state submitting from a worker doesn't allocate, and submit_task
+allocates once, for the shared state of the future which also holds the callable.
 */
 
 class ThreadPool {
 public:
-  explicit ThreadPool(size_t n) : m_size(n) {}
+  explicit ThreadPool(size_t n) : m_size(n) {
+    for (size_t i = 0; i < n; i++)
+      m_queues.emplace_back(std::make_unique<work_stealing_deque<TTask>>());
+  }
+
+  ~ThreadPool() {
+    stop();
+    m_pool.clear();
+    purge();
+  }
 
   ThreadPool(const ThreadPool &) = delete;
   ThreadPool &operator=(const ThreadPool &) = delete;
 
   void start() {
+    if (is_running())
+      return;
+    m_pool.clear(); // the workers of the last run exit once they see m_stopped
     std::lock_guard lg(tasks_mutex);
     m_stopped = false;
-    for (int i = 0; i < m_size; i++) {
-      m_pool.emplace_back([&] { worker(); });
+    for (size_t i = 0; i < m_size; i++) {
+      m_pool.emplace_back([this, i] { worker(i); });
     }
     m_tasks_cv.notify_all();
   }
 
+  // the tasks which haven't started stay queued, until the pool is started again or purged
   void stop() {
     std::lock_guard lg(tasks_mutex);
     if (!m_stopped) {
@@ -48,68 +109,246 @@ public:
   void unpause() {
     std::lock_guard lg(tasks_mutex);
     m_paused = false;
+    m_tasks_cv.notify_all();
   }
 
   bool is_running() const { return !m_stopped; }
+  size_t size() const { return m_size; }
+
+  using clock_type = std::chrono::steady_clock;
+
+  // how long a task waits per priority level before it goes ahead of the higher priority tasks submitted after it
+  void set_aging_period(clock_type::duration period) {
+    std::lock_guard lg(tasks_mutex);
+    m_aging_period = period;
+  }
 
   template <typename F> void detach_task(F &&task) {
+    if (s_current_pool != this) {
+      detach_task(std::forward<F>(task), task_priority::normal);
+      return;
+    }
+    m_queues[s_current_index]->push(new_task(std::forward<F>(task)));
+    m_num_queued++;
+    if (m_num_sleeping > 0) {
+      std::lock_guard lg(tasks_mutex);
+      m_tasks_cv.notify_one();
+    }
+  }
+
+  template <typename F> void detach_task(F &&task, task_priority priority) {
+    const auto now = clock_type::now();
+    auto p = new_task(std::forward<F>(task));
     std::lock_guard lg(tasks_mutex);
-    m_tasks.push(std::forward<F>(task));
-    m_tasks_cv.notify_one();
+    auto &lane = m_lanes[size_t(priority)];
+    // now is read before the lock, and the aging period may have been shortened, so keep the lane in order of due time
+    auto due = now + int(priority) * m_aging_period;
+    if (!lane.empty() && due < lane.back().due)
+      due = lane.back().due;
+    const bool urgent = priority == task_priority::high;
+    lane.push({p, due, urgent});
+    injected(urgent);
   }
 
-  template <typename F, typename R = std::invoke_result_t<std::decay_t<F>>> [[nodiscard]] std::future<R> submit_task(F &&task) {
-    auto task_promise = std::make_shared<std::promise<R>>();
-    detach_task([task = std::forward<F>(task), task_promise] {
-      try {
-        if constexpr (std::is_void_v<R>) {
-          task();
-          task_promise->set_value();
-        } else {
-          task_promise->set_value(task());
-        }
-      } catch (...) {
-        try {
-          task_promise->set_exception(std::current_exception());
-        } catch (...) {
-        }
-      }
-    });
-    return task_promise->get_future();
+  template <typename F> void detach_task(F &&task, clock_type::time_point deadline) {
+    const auto now = clock_type::now();
+    auto p = new_task(std::forward<F>(task));
+    std::lock_guard lg(tasks_mutex);
+    // a task due later only goes ahead of the other injected tasks, not of those in the deques of the workers
+    const bool urgent = deadline - now <= m_aging_period;
+    m_deadlines.push({p, deadline, urgent});
+    injected(urgent);
+  }
+
+  // The future gets the exception thrown by the task, or a broken_promise error if the task is purged.
+  // schedule is nothing, a task_priority or a deadline, as for detach_task
+  template <typename F, typename... Schedule, typename R = std::invoke_result_t<std::decay_t<F>>>
+  [[nodiscard]] future<R> submit_task(F &&task, Schedule... schedule) {
+    auto state = new _future::task_state<R, std::decay_t<F>>(std::forward<F>(task));
+    state->add_ref();
+    future<R> res(state);
+    detach_task(_future::task_runner(state), schedule...);
+    return res;
   }
 
+  // Runs a queued task on the calling thread, if there is one, so a thread which waits for other tasks can help instead of
+  // blocking. It runs even if the pool is paused or stopped. Returns false if no task was found
+  bool run_pending_task() {
+    auto task = find_task(s_current_pool == this ? s_current_index : m_size);
+    if (!task)
+      return false;
+    (*task)();
+    delete_task(task);
+    return true;
+  }
+
+  // removes the tasks which haven't started. Those queued by a running task concurrently may be missed
   void purge() {
     std::lock_guard lg(tasks_mutex);
-    while (!m_tasks.empty())
-      m_tasks.pop();
+    for (auto &lane : m_lanes) {
+      while (!lane.empty()) {
+        delete_task(lane.front().task);
+        lane.pop();
+        m_num_queued--;
+      }
+    }
+    while (!m_deadlines.empty()) {
+      delete_task(m_deadlines.top().task);
+      m_deadlines.pop();
+      m_num_queued--;
+    }
+    m_num_urgent = 0;
+    for (auto &queue : m_queues) {
+      while (auto p = queue->steal()) {
+        delete_task(p);
+        m_num_queued--;
+      }
+    }
   }
 
 private:
-  using TTask = std::function<void()>;
-
-  void worker() {
-    std::unique_lock lock(tasks_mutex);
-    m_num_active_threads++;
-    while (true) {
-      m_tasks_cv.wait(lock, [&]() { return m_stopped || (!m_paused && !m_tasks.empty()); });
-      if (m_stopped)
-        break;
-      auto task{std::move(m_tasks.front())};
-      m_tasks.pop();
-      m_num_running_tasks++;
-      m_tasks_cv.notify_one();
-      lock.unlock();
-      task();
-      lock.lock();
-      m_num_running_tasks--;
+  using TTask = move_only_function<void(), 6 * sizeof(void *)>;
+
+  struct injected_task {
+    TTask *task;
+    clock_type::time_point due;
+    bool urgent; // counted in m_num_urgent
+  };
+
+  struct later_due {
+    bool operator()(const injected_task &a, const injected_task &b) const { return b.due < a.due; }
+  };
+
+  // The cache of the calling thread, null once it is destroyed: e.g. default_thread_pool() is destroyed after the
+  // thread_locals of the main thread, and purges its tasks then
+  static _thread_pool::task_cache *task_cache() noexcept {
+    return _thread_pool::task_cache::s_destroyed ? nullptr : &s_task_cache;
+  }
+
+  template <typename F> static TTask *new_task(F &&f) {
+    auto cache = task_cache();
+    void *p = cache ? cache->head : nullptr;
+    if (p) {
+      cache->head = cache->head->next;
+      cache->size--;
+    } else {
+      p = ::operator new(sizeof(TTask));
     }
-    m_num_active_threads--;
+    return ::new (p) TTask(std::forward<F>(f));
   }
 
+  static void delete_task(TTask *task) noexcept {
+    task->~TTask();
+    auto cache = task_cache();
+    if (!cache || cache->size == _thread_pool::task_cache::s_max_size) {
+      ::operator delete(task);
+      return;
+    }
+    cache->head = ::new (static_cast<void *>(task)) _thread_pool::task_cache::block{cache->head};
+    cache->size++;
+  }
+
+  void worker(size_t index) {
+    s_current_pool = this;
+    s_current_index = index;
+    while (!m_stopped) {
+      if (!m_paused) {
+        if (auto task = find_task(index)) {
+          (*task)();
+          delete_task(task);
+          continue;
+        }
+      }
+
+      // a submitter which sees m_num_sleeping == 0 doesn't notify, and then this sees the task in m_num_queued
+      std::unique_lock lock(tasks_mutex);
+      m_num_sleeping++;
+      m_tasks_cv.wait(lock, [&]() { return m_stopped || (!m_paused && m_num_queued > 0); });
+      m_num_sleeping--;
+    }
+  }
+
+  // index is m_size for a thread which isn't a worker of this pool
+  TTask *find_task(size_t index) {
+    TTask *task = nullptr;
+    if (m_num_urgent > 0)
+      task = take_injected();
+    if (!task && index < m_size)
+      task = m_queues[index]->pop();
+    if (!task && m_num_queued > 0)
+      task = take_injected();
+    if (!task && m_num_queued > 0)
+      task = steal(index);
+    if (task)
+      m_num_queued--;
+    return task;
+  }
+
+  // with tasks_mutex held
+  void injected(bool urgent) {
+    if (urgent)
+      m_num_urgent++;
+    m_num_queued++;
+    m_tasks_cv.notify_one();
+  }
+
+  // the injected task which is due the earliest, from the higher priority lane on a tie
+  TTask *take_injected() {
+    std::lock_guard lg(tasks_mutex);
+    std::queue<injected_task> *lane = nullptr;
+    for (auto &l : m_lanes) {
+      if (!l.empty() && (!lane || l.front().due < lane->front().due))
+        lane = &l;
+    }
+    if (!m_deadlines.empty() && (!lane || m_deadlines.top().due < lane->front().due)) {
+      const auto top = m_deadlines.top();
+      m_deadlines.pop();
+      if (top.urgent)
+        m_num_urgent--;
+      return top.task;
+    }
+    if (!lane)
+      return nullptr;
+    const auto front = lane->front();
+    lane->pop();
+    if (front.urgent)
+      m_num_urgent--;
+    return front.task;
+  }
+
+  // tries each other worker once, starting at a random one
+  TTask *steal(size_t index) {
+    if (m_size == 0)
+      return nullptr;
+    thread_local uint32_t s_random = uint32_t(index) * 2654435761u + 1;
+    s_random ^= s_random << 13;
+    s_random ^= s_random >> 17;
+    s_random ^= s_random << 5;
+    for (size_t i = 0, start = s_random % m_size; i < m_size; i++) {
+      const auto victim = (start + i) % m_size;
+      if (victim == index)
+        continue;
+      if (auto task = m_queues[victim]->steal())
+        return task;
+    }
+    return nullptr;
+  }
+
+  // the worker which runs on this thread, if any
+  inline static thread_local ThreadPool *s_current_pool = nullptr;
+  inline static thread_local size_t s_current_index = 0;
+  inline static thread_local _thread_pool::task_cache s_task_cache;
+
   size_t m_size;
-  size_t m_num_running_tasks = 0;
-  size_t m_num_active_threads = 0;
-  std::queue<TTask> m_tasks;
+  std::vector<std::unique_ptr<work_stealing_deque<TTask>>> m_queues;
+  // the injection queues, for the tasks submitted by other threads or with a priority or a deadline
+  std::queue<injected_task> m_lanes[3];
+  priority_queue<injected_task, vector<injected_task>, later_due> m_deadlines;
+  clock_type::duration m_aging_period = std::chrono::milliseconds(100);
+  // the tasks in the injection queues and m_queues, briefly negative when a task is taken before its submitter counts it
+  std::atomic<int64_t> m_num_queued = 0;
+  std::atomic<int64_t> m_num_urgent = 0; // the injected tasks which are taken ahead of the deques of the workers
+  std::atomic<size_t> m_num_sleeping = 0;
   std::atomic_bool m_stopped = true;
   std::atomic_bool m_paused = false;
   std::condition_variable_any m_tasks_cv;
@@ -117,4 +356,16 @@ private:
   std::vector<std::jthread> m_pool;
 };
 
+// A started pool shared by the process. The thread which submits to it is expected to run tasks too, e.g. by waiting for
+// a task_group, so it has one thread less than the hardware
+inline ThreadPool &default_thread_pool() {
+  struct started_pool {
+    started_pool() : pool(std::thread::hardware_concurrency() > 2 ? std::thread::hardware_concurrency() - 1 : 1) { pool.start(); }
+    ~started_pool() { pool.stop(); }
+    ThreadPool pool;
+  };
+  static started_pool s_pool;
+  return s_pool.pool;
+}
+
 } // namespace aria
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+#include "memory.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace aria {
+
+/*
+Chase-Lev deque of pointers: the owner thread pushes and pops at the bottom, any thread can steal from the top.
+Push and pop don't take a lock, and only contend with thieves over the last element.
+https://www.di.ens.fr/~zappa/readings/ppopp13.pdf
+*/
+
+template <class T> class work_stealing_deque {
+public:
+  // capacity is the initial one, a power of 2
+  explicit work_stealing_deque(int64_t capacity = 64) : m_ring(new ring(capacity)) { m_rings.emplace_back(m_ring.load()); }
+
+  work_stealing_deque(const work_stealing_deque &) = delete;
+  work_stealing_deque &operator=(const work_stealing_deque &) = delete;
+
+  // owner only
+  void push(T *x) {
+    const auto b = m_bottom.load(std::memory_order_relaxed);
+    const auto t = m_top.load(std::memory_order_acquire);
+    auto r = m_ring.load(std::memory_order_relaxed);
+    if (b - t >= r->capacity)
+      r = grow(r, t, b);
+    r->store(b, x);
+    m_bottom.store(b + 1, std::memory_order_release);
+  }
+
+  // owner only, the last pushed element or nullptr
+  T *pop() {
+    const auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+    auto r = m_ring.load(std::memory_order_relaxed);
+    m_bottom.store(b, std::memory_order_seq_cst);
+    auto t = m_top.load(std::memory_order_seq_cst);
+    if (t > b) {
+      m_bottom.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    auto x = r->load(b);
+    if (t == b) {
+      // the last element, which a thief may be taking too
+      if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        x = nullptr;
+      m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return x;
+  }
+
+  // the first pushed element, or nullptr if the deque is empty or another thread took it first
+  T *steal() {
+    auto t = m_top.load(std::memory_order_seq_cst);
+    const auto b = m_bottom.load(std::memory_order_seq_cst);
+    if (t >= b)
+      return nullptr;
+    auto x = m_ring.load(std::memory_order_acquire)->load(t);
+    if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+      return nullptr;
+    return x;
+  }
+
+  bool empty() const { return size() == 0; }
+  // may be out of date by the time it returns, if other threads use the deque
+  int64_t size() const {
+    const auto n = m_bottom.load() - m_top.load();
+    return n > 0 ? n : 0;
+  }
+
+private:
+  struct ring {
+    explicit ring(int64_t cap) : capacity(cap), slots(make_unique<std::atomic<T *>[]>(cap)) {}
+
+    T *load(int64_t i) const { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+    void store(int64_t i, T *x) { slots[i & (capacity - 1)].store(x, std::memory_order_relaxed); }
+
+    const int64_t capacity; // a power of 2
+    unique_ptr<std::atomic<T *>[]> slots;
+  };
+
+  // A thief may still read from the old ring, so it is kept until the deque is destroyed.
+  // The rings double, so they take at most twice the memory of the last one
+  ring *grow(ring *r, int64_t t, int64_t b) {
+    auto bigger = new ring(r->capacity * 2);
+    m_rings.emplace_back(bigger);
+    for (auto i = t; i != b; i++)
+      bigger->store(i, r->load(i));
+    m_ring.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+
+  alignas(64) std::atomic<int64_t> m_top = 0;
+  alignas(64) std::atomic<int64_t> m_bottom = 0;
+  std::atomic<ring *> m_ring;
+  std::vector<unique_ptr<ring>> m_rings; // owns the current ring and the old ones
+};
+
+} // namespace aria
\ No newline at end of file